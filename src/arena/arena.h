@@ -0,0 +1,167 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+namespace arena {
+
+// Bump allocator for short-lived per-task objects.
+//
+// allocate() just advances a pointer inside the current block; deallocate()
+// does nothing (except undo the most recent allocation, which is what a
+// growing vector does). Memory comes back all at once when the arena is
+// rewound to an earlier mark or reset, and the blocks are kept for reuse,
+// so a task that runs in a loop stops calling malloc after the first pass.
+//
+// An Arena is not thread-safe: each thread uses its own, see thread_arena().
+class Arena : public std::pmr::memory_resource {
+public:
+  // Position to rewind() to; everything allocated after it is released.
+  struct Mark {
+    std::size_t block;
+    char *cursor;
+  };
+
+  explicit Arena(std::size_t block_size = 64 << 10,
+                 std::pmr::memory_resource *upstream = std::pmr::new_delete_resource())
+      : upstream(upstream), next_size(std::max<std::size_t>(block_size, 256)) {
+    add_block(0, alignof(std::max_align_t));
+  }
+
+  ~Arena() override {
+    release();
+    upstream->deallocate(blocks[0].data, blocks[0].size, blocks[0].align);
+  }
+
+  Arena(const Arena &) = delete;
+  Arena &operator=(const Arena &) = delete;
+
+  [[nodiscard]] Mark mark() const { return {current, cursor}; }
+
+  void rewind(Mark m) {
+    current = m.block;
+    cursor = m.cursor;
+    end = blocks[current].data + blocks[current].size;
+  }
+
+  // Frees every allocation but keeps the blocks.
+  void reset() { rewind({0, blocks[0].data}); }
+
+  // Returns every block but the first to the upstream resource.
+  void release() {
+    for (std::size_t i = 1; i < blocks.size(); ++i)
+      upstream->deallocate(blocks[i].data, blocks[i].size, blocks[i].align);
+    blocks.resize(1);
+    reset();
+  }
+
+  // Bytes held from upstream, used or not.
+  [[nodiscard]] std::size_t capacity() const {
+    std::size_t total = 0;
+    for (const auto &b : blocks)
+      total += b.size;
+    return total;
+  }
+
+  [[nodiscard]] std::size_t block_count() const { return blocks.size(); }
+
+private:
+  struct Block {
+    char *data;
+    std::size_t size;
+    std::size_t align;
+  };
+
+  void *do_allocate(std::size_t bytes, std::size_t alignment) override {
+    if (char *p = bump(bytes, alignment))
+      return p;
+
+    // Move on to the next retained block that fits, or insert a new one.
+    while (++current < blocks.size()) {
+      cursor = blocks[current].data;
+      end = cursor + blocks[current].size;
+      if (char *p = bump(bytes, alignment))
+        return p;
+    }
+    --current;
+    add_block(bytes, alignment);
+    return bump(bytes, alignment);
+  }
+
+  void do_deallocate(void *p, std::size_t bytes, std::size_t) override {
+    auto *first = static_cast<char *>(p);
+    if (first + bytes == cursor && first >= blocks[current].data)
+      cursor = first;
+  }
+
+  bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override {
+    return this == &other;
+  }
+
+  char *bump(std::size_t bytes, std::size_t alignment) {
+    auto addr = reinterpret_cast<std::uintptr_t>(cursor);
+    auto aligned = (addr + alignment - 1) & ~(alignment - 1);
+    if (aligned + bytes > reinterpret_cast<std::uintptr_t>(end))
+      return nullptr;
+    cursor = reinterpret_cast<char *>(aligned + bytes);
+    return reinterpret_cast<char *>(aligned);
+  }
+
+  // Inserts a block after the current one that fits `bytes`, and makes it
+  // current. Block sizes double up to 16 MiB.
+  void add_block(std::size_t bytes, std::size_t alignment) {
+    std::size_t align = std::max(alignment, alignof(std::max_align_t));
+    std::size_t size = std::max(next_size, bytes + align);
+    char *data = static_cast<char *>(upstream->allocate(size, align));
+    next_size = std::min<std::size_t>(next_size * 2, 16 << 20);
+
+    current = blocks.empty() ? 0 : current + 1;
+    blocks.insert(blocks.begin() + static_cast<std::ptrdiff_t>(current), {data, size, align});
+    cursor = data;
+    end = data + size;
+  }
+
+  std::pmr::memory_resource *upstream;
+  std::size_t next_size;
+  std::vector<Block> blocks;
+  std::size_t current = 0;
+  char *cursor = nullptr;
+  char *end = nullptr;
+};
+
+// The calling thread's arena, created on first use.
+inline Arena &thread_arena() {
+  thread_local Arena arena;
+  return arena;
+}
+
+// Scoped reset: whatever is allocated from the arena while a ScopedArena is
+// alive is released when it goes out of scope. Scopes nest, so a pool task
+// that runs other tasks while it waits (thread_pool::wait_all) is fine, but
+// nothing allocated inside may outlive the scope -- return results in
+// ordinary containers, and do not hold a scope across a co_await.
+//
+//   pool.submit([] {
+//     arena::ScopedArena scope;
+//     std::pmr::vector<int> tmp(scope.resource());
+//     ...
+//   });
+class ScopedArena {
+public:
+  explicit ScopedArena(Arena &a = thread_arena()) : arena(a), start(a.mark()) {}
+  ~ScopedArena() { arena.rewind(start); }
+
+  ScopedArena(const ScopedArena &) = delete;
+  ScopedArena &operator=(const ScopedArena &) = delete;
+
+  [[nodiscard]] std::pmr::memory_resource *resource() const { return &arena; }
+
+private:
+  Arena &arena;
+  Arena::Mark start;
+};
+
+} // namespace arena
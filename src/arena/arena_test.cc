@@ -0,0 +1,134 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <iostream>
+#include <memory_resource>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include "arena/arena.h"
+#include "thread_pool/thread_pool.h"
+
+TEST(arena_test, basic_test) {
+  arena::Arena a(1024);
+  EXPECT_EQ(a.block_count(), 1u);
+
+  auto *first = static_cast<char *>(a.allocate(100, 8));
+  auto *second = static_cast<char *>(a.allocate(100, 64));
+  EXPECT_EQ(reinterpret_cast<std::uintptr_t>(second) % 64, 0u);
+  EXPECT_GE(second, first + 100);
+
+  // Undoing the latest allocation hands the same bytes out again.
+  a.deallocate(second, 100, 64);
+  EXPECT_EQ(a.allocate(100, 64), second);
+
+  // Bigger than a block: a new block is added and kept after reset().
+  auto mark = a.mark();
+  EXPECT_NE(a.allocate(10'000, 16), nullptr);
+  EXPECT_EQ(a.block_count(), 2u);
+  a.rewind(mark);
+  EXPECT_EQ(a.allocate(100, 8), second + 104);
+
+  a.reset();
+  EXPECT_EQ(a.allocate(100, 8), first);
+  EXPECT_NE(a.allocate(10'000, 16), nullptr);
+  EXPECT_EQ(a.block_count(), 2u);
+
+  a.release();
+  EXPECT_EQ(a.block_count(), 1u);
+}
+
+TEST(arena_test, scoped_test) {
+  auto &a = arena::thread_arena();
+  auto before = a.mark();
+  {
+    arena::ScopedArena outer;
+    std::pmr::vector<int> v(outer.resource());
+    for (int i = 0; i < 100'000; ++i)
+      v.push_back(i);
+    {
+      arena::ScopedArena inner;
+      std::pmr::string s("a string long enough to skip the small buffer", inner.resource());
+      EXPECT_EQ(s.size(), 45u);
+    }
+    EXPECT_EQ(std::accumulate(v.begin(), v.end(), 0ll), 4'999'950'000ll);
+  }
+  EXPECT_EQ(a.mark().cursor, before.cursor);
+
+  // Each pool thread has its own arena.
+  thread_pool::ThreadPool pool(4);
+  std::vector<std::future<long long>> results;
+  for (int t = 0; t < 16; ++t) {
+    results.push_back(pool.submit([t] {
+      arena::ScopedArena scope;
+      std::pmr::vector<long long> tmp(scope.resource());
+      for (int i = 0; i <= t * 1000; ++i)
+        tmp.push_back(i);
+      return std::accumulate(tmp.begin(), tmp.end(), 0ll);
+    }));
+  }
+  for (int t = 0; t < 16; ++t) {
+    long long n = t * 1000;
+    EXPECT_EQ(results[t].get(), n * (n + 1) / 2);
+  }
+}
+
+namespace {
+
+// An allocation-heavy task in the shape of calculate_all in
+// get_return_value.cc: temporaries built up element by element, a few
+// strings, and only a small result leaves the task.
+long long churn(std::pmr::memory_resource *mr, int seed) {
+  long long result = 0;
+  for (int round = 0; round < 20; ++round) {
+    std::pmr::vector<int> v_a(mr);
+    for (int i = 0; i < 200; ++i)
+      v_a.push_back(seed + i);
+
+    std::pmr::vector<std::pmr::string> names(mr);
+    for (int i = 0; i < 20; ++i)
+      names.emplace_back(24 + i, static_cast<char>('a' + i));
+
+    result += std::accumulate(v_a.begin(), v_a.end(), 0ll) + names.back().size();
+  }
+  return result;
+}
+
+} // namespace
+
+TEST(arena_test, benchmark) {
+  constexpr int tasks = 2000;
+  const unsigned threads = std::max(4u, std::thread::hardware_concurrency());
+  thread_pool::ThreadPool pool(threads);
+
+  std::pmr::synchronized_pool_resource shared_pool;
+  long long expected = 0;
+  for (auto [name, mode] : {std::pair{"new/delete", 0},
+                            {"shared synchronized_pool_resource", 1},
+                            {"thread arena", 2}}) {
+    auto sta = std::chrono::steady_clock::now();
+    std::vector<std::future<long long>> results;
+    results.reserve(tasks);
+    for (int t = 0; t < tasks; ++t) {
+      results.push_back(pool.submit([mode = mode, t, &shared_pool] {
+        if (mode == 2) {
+          arena::ScopedArena scope;
+          return churn(scope.resource(), t);
+        }
+        return churn(mode == 0 ? std::pmr::new_delete_resource() : &shared_pool, t);
+      }));
+    }
+    long long total = 0;
+    for (auto &r : results)
+      total += r.get();
+    std::chrono::duration<double, std::milli> dur = std::chrono::steady_clock::now() - sta;
+
+    if (expected == 0)
+      expected = total;
+    EXPECT_EQ(total, expected);
+    std::cout << name << " (" << threads << " threads): " << dur.count() << " ms, "
+              << tasks / dur.count() << " tasks/ms." << std::endl;
+  }
+}
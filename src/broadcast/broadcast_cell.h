@@ -0,0 +1,147 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#include "thread_pool/function_wrapper.h"
+
+namespace broadcast {
+
+// Single-writer, many-reader broadcast of one value, as a cheaper
+// std::shared_future. Every std::shared_future::get() locks the mutex in the
+// shared state, so waking N readers means N trips through that mutex.
+//
+// Here the readers only look at one 32-bit word:
+//   bit 0  the value is published
+//   bit 1  at least one reader is blocked in atomic::wait()
+// A reader spins for a little while (on multi-core hosts) and then sets the
+// waiter bit and sleeps on the word; the writer publishes with a release
+// fetch_or and calls notify_all() only if the waiter bit is set. Once the
+// value is published get() is a single acquire load.
+//
+// Readers that do not want to park a thread can subscribe() a callback
+// instead. Callbacks sit in a lock-free stack and are run by the writer
+// right after publishing, or immediately by subscribe() if the value is
+// already there.
+template <typename T>
+class BroadcastCell {
+public:
+  BroadcastCell() {}
+
+  ~BroadcastCell() {
+    if (is_ready())
+      std::destroy_at(&value);
+
+    Node *node = callbacks.load(std::memory_order_acquire);
+    while (node != nullptr && node != closed()) {
+      delete std::exchange(node, node->next);
+    }
+  }
+
+  BroadcastCell(const BroadcastCell &) = delete;
+  BroadcastCell &operator=(const BroadcastCell &) = delete;
+
+  template <typename... Args>
+  void set_value(Args &&...args) {
+    if (word.load(std::memory_order_relaxed) & published)
+      throw std::logic_error("broadcast value already set");
+
+    std::construct_at(&value, std::forward<Args>(args)...);
+    if (word.fetch_or(published, std::memory_order_release) & waiters)
+      word.notify_all();
+
+    run_callbacks(callbacks.exchange(closed(), std::memory_order_acq_rel));
+  }
+
+  [[nodiscard]] bool is_ready() const {
+    return word.load(std::memory_order_acquire) & published;
+  }
+
+  void wait() const {
+    static const int spins = std::thread::hardware_concurrency() > 1 ? spin_count : 0;
+
+    auto w = word.load(std::memory_order_acquire);
+    for (int i = 0; i < spins && !(w & published); ++i)
+      w = word.load(std::memory_order_acquire);
+
+    while (!(w & published)) {
+      if (!(w & waiters)) {
+        w = word.fetch_or(waiters, std::memory_order_acquire) | waiters;
+        continue;
+      }
+      word.wait(w, std::memory_order_acquire);
+      w = word.load(std::memory_order_acquire);
+    }
+  }
+
+  const T &get() const {
+    wait();
+    return value;
+  }
+
+  // Calls f(const T &) once the value is published, on the writer's thread,
+  // or right away on this thread if it already is.
+  template <typename F>
+  void subscribe(F f) {
+    auto node = std::make_unique<Node>();
+    node->callback = [this, f = std::move(f)]() mutable { f(value); };
+
+    Node *head = callbacks.load(std::memory_order_acquire);
+    while (head != closed()) {
+      node->next = head;
+      if (callbacks.compare_exchange_weak(head, node.get(),
+                                          std::memory_order_release,
+                                          std::memory_order_acquire)) {
+        node.release();
+        return;
+      }
+    }
+    node->callback();
+  }
+
+private:
+  static constexpr std::uint32_t published = 0x1;
+  static constexpr std::uint32_t waiters = 0x2;
+  static constexpr int spin_count = 256;
+
+  struct Node {
+    thread_pool::FunctionWrapper callback;
+    Node *next = nullptr;
+  };
+
+  // Marks the callback stack as drained: later subscribers run inline.
+  static Node *closed() {
+    static Node sentinel;
+    return &sentinel;
+  }
+
+  static void run_callbacks(Node *head) {
+    // The stack is LIFO; reverse it so callbacks run in subscription order.
+    Node *ordered = nullptr;
+    while (head != nullptr) {
+      Node *next = head->next;
+      head->next = ordered;
+      ordered = head;
+      head = next;
+    }
+
+    while (ordered != nullptr) {
+      std::unique_ptr<Node> node(std::exchange(ordered, ordered->next));
+      node->callback();
+    }
+  }
+
+  mutable std::atomic<std::uint32_t> word{0};
+  std::atomic<Node *> callbacks{nullptr};
+
+  union {
+    T value;
+  };
+};
+
+} // namespace broadcast
@@ -0,0 +1,168 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "broadcast/broadcast_cell.h"
+
+TEST(broadcast_cell_test, readers_test) {
+  broadcast::BroadcastCell<std::string> cell;
+  std::vector<std::string> seen(5);
+
+  std::vector<std::thread> readers;
+  for (int i = 0; i < 5; ++i)
+    readers.emplace_back([&, i] { seen[i] = cell.get(); });
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  EXPECT_FALSE(cell.is_ready());
+  cell.set_value("20/10 = 2");
+
+  for (auto &reader : readers)
+    reader.join();
+
+  for (auto &value : seen)
+    EXPECT_EQ(value, "20/10 = 2");
+  EXPECT_THROW(cell.set_value("again"), std::logic_error);
+}
+
+TEST(broadcast_cell_test, subscribe_test) {
+  broadcast::BroadcastCell<int> cell;
+  std::vector<int> order;
+
+  for (int i = 0; i < 3; ++i)
+    cell.subscribe([&order, i](const int &v) { order.push_back(v + i); });
+  EXPECT_TRUE(order.empty());
+
+  std::thread writer([&] { cell.set_value(10); });
+  writer.join();
+  EXPECT_EQ(order, (std::vector<int>{10, 11, 12}));
+
+  // Late subscribers run immediately.
+  cell.subscribe([&order](const int &v) { order.push_back(v * 2); });
+  EXPECT_EQ(order.back(), 20);
+}
+
+TEST(broadcast_cell_test, pending_callbacks_test) {
+  // A cell that is never set frees its callbacks.
+  auto counter = std::make_shared<int>(0);
+  {
+    broadcast::BroadcastCell<int> cell;
+    cell.subscribe([counter](const int &) { ++*counter; });
+    EXPECT_EQ(counter.use_count(), 2);
+  }
+  EXPECT_EQ(counter.use_count(), 1);
+  EXPECT_EQ(*counter, 0);
+}
+
+namespace {
+
+struct SharedFutureCell {
+  std::promise<int> promise;
+  std::shared_future<int> future = promise.get_future().share();
+
+  void set_value(int v) { promise.set_value(v); }
+  const int &get() const { return future.get(); }
+};
+
+struct WakeUpStats {
+  double mean_us;
+  double max_us;
+  double wakeups_per_second;
+};
+
+// `waiters` threads block on a fresh cell each round; the writer publishes
+// once all of them are parked. Latency is publish-to-return of get().
+template <typename Cell>
+WakeUpStats wake_up(int waiters, int rounds) {
+  using clock = std::chrono::steady_clock;
+
+  std::vector<std::unique_ptr<Cell>> cells;
+  for (int r = 0; r < rounds; ++r)
+    cells.push_back(std::make_unique<Cell>());
+
+  std::atomic<int> arrived{0};
+  std::atomic<int> woken{0};
+  std::vector<clock::time_point> wake_times(waiters);
+
+  std::vector<std::thread> readers;
+  for (int i = 0; i < waiters; ++i) {
+    readers.emplace_back([&, i] {
+      for (int r = 0; r < rounds; ++r) {
+        arrived.fetch_add(1);
+        (void)cells[r]->get();
+        wake_times[i] = clock::now();
+        woken.fetch_add(1);
+        // Do not arrive at the next round before everyone woke from this one.
+        while (woken.load() < (r + 1) * waiters)
+          std::this_thread::yield();
+      }
+    });
+  }
+
+  double total_us = 0;
+  double max_us = 0;
+  double busy_us = 0;
+  for (int r = 0; r < rounds; ++r) {
+    while (arrived.load() < (r + 1) * waiters)
+      std::this_thread::yield();
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    auto t0 = clock::now();
+    cells[r]->set_value(r);
+    while (woken.load() < (r + 1) * waiters)
+      std::this_thread::yield();
+
+    double last_us = 0;
+    for (auto t : wake_times) {
+      double us = std::chrono::duration<double, std::micro>(t - t0).count();
+      total_us += us;
+      last_us = std::max(last_us, us);
+    }
+    max_us = std::max(max_us, last_us);
+    busy_us += last_us;
+  }
+
+  for (auto &reader : readers)
+    reader.join();
+
+  double wakeups = 1.0 * waiters * rounds;
+  return {total_us / wakeups, max_us, wakeups / (busy_us / 1e6)};
+}
+
+} // namespace
+
+TEST(broadcast_cell_test, benchmark) {
+  constexpr int rounds = 10;
+
+  for (int waiters : {1, 4, 16, 64, 256}) {
+    auto fut = wake_up<SharedFutureCell>(waiters, rounds);
+    auto cell = wake_up<broadcast::BroadcastCell<int>>(waiters, rounds);
+
+    std::cout << waiters << " waiters: shared_future mean " << fut.mean_us
+              << " us, max " << fut.max_us << " us, " << fut.wakeups_per_second
+              << " wakeups/s; BroadcastCell mean " << cell.mean_us
+              << " us, max " << cell.max_us << " us, " << cell.wakeups_per_second
+              << " wakeups/s." << std::endl;
+  }
+
+  for (int subscribers : {1, 16, 256}) {
+    broadcast::BroadcastCell<int> cell;
+    std::atomic<int> calls{0};
+    for (int i = 0; i < subscribers; ++i)
+      cell.subscribe([&calls](const int &) { calls.fetch_add(1); });
+
+    auto t0 = std::chrono::steady_clock::now();
+    cell.set_value(1);
+    std::chrono::duration<double, std::micro> dur = std::chrono::steady_clock::now() - t0;
+
+    EXPECT_EQ(calls.load(), subscribers);
+    std::cout << subscribers << " callbacks: all run " << dur.count()
+              << " us after set_value()." << std::endl;
+  }
+}
@@ -0,0 +1,236 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <unordered_map>
+#include <utility>
+
+namespace cache {
+
+// Which entry a full shard drops.
+//
+//   lru    the least recently used. A hit moves its entry to the front of
+//          the list, under a try_lock: if another reader is promoting at
+//          that moment the promotion is skipped, so hits never wait for
+//          each other but recency is approximate under contention.
+//   clock  second chance (CLOCK). A hit only sets the entry's referenced
+//          bit; eviction walks from the oldest entry, clearing set bits and
+//          moving those entries to the front, until it finds a clear one.
+enum class Eviction { lru, clock };
+
+struct Stats {
+  std::uint64_t hits = 0;
+  std::uint64_t misses = 0;
+  std::uint64_t evictions = 0;
+
+  [[nodiscard]] double hit_rate() const {
+    auto lookups = hits + misses;
+    return lookups == 0 ? 0.0 : static_cast<double>(hits) / static_cast<double>(lookups);
+  }
+};
+
+// Concurrent bounded cache, split into independently locked shards by key
+// hash.
+//
+//   cache::ShardedCache<std::string, Row> rows(100'000);
+//   Row r = rows.get_or_compute(key, [](const std::string &k) { return backend.load(k); });
+//
+// Each shard is a hash map whose entries are threaded on an intrusive
+// recency list, behind a shared_mutex: get() takes it shared, put() and
+// erase() exclusive. Capacity is split evenly across the shards, so
+// eviction is per shard.
+template <typename K, typename V, Eviction Policy = Eviction::lru, typename Hash = std::hash<K>,
+          typename KeyEqual = std::equal_to<K>>
+class ShardedCache {
+  struct Links {
+    Links *prev;
+    Links *next;
+  };
+
+  struct Entry : Links {
+    explicit Entry(V value) : Links{nullptr, nullptr}, value(std::move(value)) {}
+
+    V value;
+    const K *key = nullptr;
+    std::atomic<bool> referenced{false};
+  };
+
+  struct alignas(64) Shard {
+    mutable std::shared_mutex mutex;
+    // Serializes LRU promotions made under a shared lock.
+    std::mutex list_mutex;
+    std::unordered_map<K, Entry, Hash, KeyEqual> map;
+    // Most recently used first.
+    Links list{&list, &list};
+    std::size_t capacity = 0;
+
+    std::atomic<std::uint64_t> hits{0};
+    std::atomic<std::uint64_t> misses{0};
+    std::atomic<std::uint64_t> evictions{0};
+  };
+
+public:
+  // `shards` is rounded up to a power of two; each holds capacity / shards
+  // entries (at least one).
+  explicit ShardedCache(std::size_t capacity, std::size_t shards = 16, Hash hash = Hash())
+      : shard_count(std::bit_ceil(std::max<std::size_t>(shards, 1))),
+        shard_shift(64 - std::countr_zero(shard_count)),
+        shard_list(std::make_unique<Shard[]>(shard_count)), hash(std::move(hash)) {
+    for (std::size_t i = 0; i < shard_count; ++i)
+      shard_list[i].capacity = std::max<std::size_t>((capacity + shard_count - 1) / shard_count, 1);
+  }
+
+  ShardedCache(const ShardedCache &) = delete;
+  ShardedCache &operator=(const ShardedCache &) = delete;
+
+  std::optional<V> get(const K &key) {
+    Shard &s = shard(key);
+    std::shared_lock<std::shared_mutex> lk(s.mutex);
+    auto it = s.map.find(key);
+    if (it == s.map.end()) {
+      s.misses.fetch_add(1, std::memory_order_relaxed);
+      return std::nullopt;
+    }
+    s.hits.fetch_add(1, std::memory_order_relaxed);
+    Entry &e = it->second;
+    if constexpr (Policy == Eviction::clock) {
+      // Skip the store when the bit is already set, so that hot entries
+      // stay shared in every reader's cache.
+      if (!e.referenced.load(std::memory_order_relaxed))
+        e.referenced.store(true, std::memory_order_relaxed);
+    } else {
+      std::unique_lock<std::mutex> list_lk(s.list_mutex, std::try_to_lock);
+      if (list_lk.owns_lock())
+        move_to_front(s, e);
+    }
+    return e.value;
+  }
+
+  // Inserts or replaces, evicting from the key's shard if it is full.
+  void put(const K &key, V value) {
+    Shard &s = shard(key);
+    std::lock_guard<std::shared_mutex> lk(s.mutex);
+    if (auto it = s.map.find(key); it != s.map.end()) {
+      Entry &e = it->second;
+      e.value = std::move(value);
+      if constexpr (Policy == Eviction::clock)
+        e.referenced.store(true, std::memory_order_relaxed);
+      else
+        move_to_front(s, e);
+      return;
+    }
+    // Evict first, so that CLOCK never picks the entry being inserted.
+    if (s.map.size() >= s.capacity)
+      evict(s);
+    auto it = s.map.try_emplace(key, std::move(value)).first;
+    it->second.key = &it->first;
+    link_front(s, it->second);
+  }
+
+  bool erase(const K &key) {
+    Shard &s = shard(key);
+    std::lock_guard<std::shared_mutex> lk(s.mutex);
+    auto it = s.map.find(key);
+    if (it == s.map.end())
+      return false;
+    unlink(it->second);
+    s.map.erase(it);
+    return true;
+  }
+
+  // Returns the cached value, or calls load(key), caches and returns its
+  // result. Loads run without any lock held, so concurrent misses on one
+  // key may each call load; the last put wins.
+  template <typename Load>
+  V get_or_compute(const K &key, Load &&load) {
+    if (auto cached = get(key))
+      return *std::move(cached);
+    V value = std::forward<Load>(load)(key);
+    put(key, value);
+    return value;
+  }
+
+  [[nodiscard]] std::size_t size() const {
+    std::size_t n = 0;
+    for (std::size_t i = 0; i < shard_count; ++i) {
+      std::shared_lock<std::shared_mutex> lk(shard_list[i].mutex);
+      n += shard_list[i].map.size();
+    }
+    return n;
+  }
+
+  [[nodiscard]] std::size_t capacity() const { return shard_list[0].capacity * shard_count; }
+
+  [[nodiscard]] Stats stats() const {
+    Stats total;
+    for (std::size_t i = 0; i < shard_count; ++i) {
+      total.hits += shard_list[i].hits.load(std::memory_order_relaxed);
+      total.misses += shard_list[i].misses.load(std::memory_order_relaxed);
+      total.evictions += shard_list[i].evictions.load(std::memory_order_relaxed);
+    }
+    return total;
+  }
+
+private:
+  // Fibonacci hashing on top of Hash: std::hash is the identity for
+  // integers, and the shard must not be picked by the same low bits the
+  // shard's own map buckets on.
+  Shard &shard(const K &key) {
+    if (shard_count == 1)
+      return shard_list[0];
+    std::uint64_t h = static_cast<std::uint64_t>(hash(key)) * 0x9E3779B97F4A7C15ull;
+    return shard_list[h >> shard_shift];
+  }
+
+  static void unlink(Links &e) {
+    e.prev->next = e.next;
+    e.next->prev = e.prev;
+  }
+
+  static void link_front(Shard &s, Links &e) {
+    e.prev = &s.list;
+    e.next = s.list.next;
+    s.list.next->prev = &e;
+    s.list.next = &e;
+  }
+
+  static void move_to_front(Shard &s, Links &e) {
+    if (s.list.next == &e)
+      return;
+    unlink(e);
+    link_front(s, e);
+  }
+
+  // Called with the shard locked exclusively.
+  static void evict(Shard &s) {
+    for (;;) {
+      auto *victim = static_cast<Entry *>(s.list.prev);
+      if constexpr (Policy == Eviction::clock) {
+        if (victim->referenced.load(std::memory_order_relaxed)) {
+          victim->referenced.store(false, std::memory_order_relaxed);
+          move_to_front(s, *victim);
+          continue;
+        }
+      }
+      unlink(*victim);
+      s.map.erase(s.map.find(*victim->key));
+      s.evictions.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+  }
+
+  const std::size_t shard_count;
+  const int shard_shift;
+  std::unique_ptr<Shard[]> shard_list;
+  Hash hash;
+};
+
+} // namespace cache
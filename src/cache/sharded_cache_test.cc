@@ -0,0 +1,211 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "cache/sharded_cache.h"
+
+TEST(sharded_cache_test, lru_test) {
+  cache::ShardedCache<std::string, int> lru(3, 1);
+  lru.put("a", 1);
+  lru.put("b", 2);
+  lru.put("c", 3);
+  EXPECT_EQ(*lru.get("a"), 1);
+
+  // b is now the least recently used.
+  lru.put("d", 4);
+  EXPECT_FALSE(lru.get("b").has_value());
+  EXPECT_TRUE(lru.get("a").has_value());
+  EXPECT_TRUE(lru.get("c").has_value());
+  EXPECT_EQ(lru.size(), 3);
+
+  // Replacing counts as a use.
+  lru.put("d", 40);
+  lru.put("e", 5);
+  EXPECT_FALSE(lru.get("a").has_value());
+  EXPECT_EQ(*lru.get("d"), 40);
+
+  EXPECT_TRUE(lru.erase("d"));
+  EXPECT_FALSE(lru.erase("d"));
+  EXPECT_EQ(lru.size(), 2);
+
+  auto stats = lru.stats();
+  EXPECT_EQ(stats.hits, 4);
+  EXPECT_EQ(stats.misses, 2);
+  EXPECT_EQ(stats.evictions, 2);
+}
+
+TEST(sharded_cache_test, clock_test) {
+  cache::ShardedCache<int, int, cache::Eviction::clock> clock(3, 1);
+  clock.put(1, 1);
+  clock.put(2, 2);
+  clock.put(3, 3);
+  EXPECT_TRUE(clock.get(1).has_value());
+
+  // 1 gets a second chance, 2 was never referenced.
+  clock.put(4, 4);
+  EXPECT_FALSE(clock.get(2).has_value());
+  EXPECT_TRUE(clock.get(1).has_value());
+
+  // Every entry referenced: the sweep clears them all and comes back round
+  // to the oldest, 3.
+  EXPECT_TRUE(clock.get(3).has_value());
+  EXPECT_TRUE(clock.get(4).has_value());
+  clock.put(5, 5);
+  EXPECT_EQ(clock.size(), 3);
+  EXPECT_FALSE(clock.get(3).has_value());
+  EXPECT_TRUE(clock.get(5).has_value());
+  EXPECT_EQ(clock.stats().evictions, 2);
+}
+
+TEST(sharded_cache_test, get_or_compute_test) {
+  cache::ShardedCache<int, std::string> rows(1024);
+  int loads = 0;
+  auto backend = [&loads](int key) {
+    ++loads;
+    return std::to_string(key);
+  };
+  for (int round = 0; round < 3; ++round) {
+    for (int k = 0; k < 100; ++k)
+      EXPECT_EQ(rows.get_or_compute(k, backend), std::to_string(k));
+  }
+  EXPECT_EQ(loads, 100);
+  EXPECT_EQ(rows.stats().hits, 200);
+  EXPECT_DOUBLE_EQ(rows.stats().hit_rate(), 2.0 / 3.0);
+}
+
+TEST(sharded_cache_test, concurrent_test) {
+  constexpr int threads = 4;
+  constexpr int ops = 50'000;
+  cache::ShardedCache<int, int> lru(256, 8);
+  cache::ShardedCache<int, int, cache::Eviction::clock> clock(256, 8);
+
+  std::vector<std::thread> workers;
+  for (int t = 0; t < threads; ++t) {
+    workers.emplace_back([&, t] {
+      std::mt19937 rng(t);
+      for (int i = 0; i < ops; ++i) {
+        int key = static_cast<int>(rng() % 1024);
+        if (rng() % 10 == 0) {
+          lru.put(key, key);
+          clock.put(key, key);
+        } else {
+          if (auto v = lru.get(key)) {
+            EXPECT_EQ(*v, key);
+          }
+          if (auto v = clock.get(key)) {
+            EXPECT_EQ(*v, key);
+          }
+        }
+      }
+    });
+  }
+  for (auto &w : workers)
+    w.join();
+
+  EXPECT_LE(lru.size(), lru.capacity());
+  EXPECT_LE(clock.size(), clock.capacity());
+  auto s = lru.stats();
+  auto c = clock.stats();
+  EXPECT_EQ(s.hits + s.misses, c.hits + c.misses);
+  EXPECT_GT(s.hits, 0);
+  EXPECT_GT(c.hits, 0);
+}
+
+namespace {
+
+// Baseline: one mutex over a map and a recency list.
+template <typename K, typename V>
+class LockedLru {
+public:
+  explicit LockedLru(std::size_t capacity) : capacity(capacity) {}
+
+  std::optional<V> get(const K &key) {
+    std::lock_guard<std::mutex> lk(mutex);
+    auto it = map.find(key);
+    if (it == map.end())
+      return std::nullopt;
+    order.splice(order.begin(), order, it->second);
+    return it->second->second;
+  }
+
+  void put(const K &key, V value) {
+    std::lock_guard<std::mutex> lk(mutex);
+    auto it = map.find(key);
+    if (it != map.end()) {
+      it->second->second = std::move(value);
+      order.splice(order.begin(), order, it->second);
+      return;
+    }
+    order.emplace_front(key, std::move(value));
+    map.emplace(key, order.begin());
+    if (map.size() > capacity) {
+      map.erase(order.back().first);
+      order.pop_back();
+    }
+  }
+
+private:
+  std::mutex mutex;
+  std::size_t capacity;
+  std::list<std::pair<K, V>> order;
+  std::unordered_map<K, typename std::list<std::pair<K, V>>::iterator> map;
+};
+
+// The cache holds a quarter of the key space and starts warm with the
+// smallest keys; lookups are skewed towards small keys.
+template <typename Cache>
+double lookups_per_sec(Cache &cache, int threads, int reads_per_write, int ops_per_thread) {
+  constexpr int key_space = 1 << 16;
+  for (int k = 0; k < key_space / 4; ++k)
+    cache.put(k, k);
+  auto sta = std::chrono::steady_clock::now();
+  std::vector<std::thread> workers;
+  for (int t = 0; t < threads; ++t) {
+    workers.emplace_back([&, t] {
+      std::mt19937 rng(t);
+      for (int i = 0; i < ops_per_thread; ++i) {
+        int key = static_cast<int>(rng() % (rng() % key_space + 1));
+        if (i % (reads_per_write + 1) == 0)
+          cache.put(key, key);
+        else
+          (void)cache.get(key);
+      }
+    });
+  }
+  for (auto &w : workers)
+    w.join();
+  std::chrono::duration<double> dur = std::chrono::steady_clock::now() - sta;
+  return threads * ops_per_thread / dur.count();
+}
+
+} // namespace
+
+TEST(sharded_cache_test, benchmark) {
+  constexpr std::size_t capacity = (1 << 16) / 4;
+  constexpr int ops_per_thread = 100'000;
+
+  for (int reads_per_write : {9, 99}) {
+    std::cout << reads_per_write << ":1 reads:writes (M ops/s, hit rate):" << std::endl;
+    for (int threads : {1, 2, 4}) {
+      LockedLru<int, int> locked(capacity);
+      cache::ShardedCache<int, int> lru(capacity);
+      cache::ShardedCache<int, int, cache::Eviction::clock> clock(capacity);
+      double l = lookups_per_sec(locked, threads, reads_per_write, ops_per_thread);
+      double s = lookups_per_sec(lru, threads, reads_per_write, ops_per_thread);
+      double c = lookups_per_sec(clock, threads, reads_per_write, ops_per_thread);
+      std::cout << "  " << threads << " threads: single-lock LRU " << l / 1e6
+                << ", sharded LRU " << s / 1e6 << " (" << lru.stats().hit_rate() << ")"
+                << ", sharded CLOCK " << c / 1e6 << " (" << clock.stats().hit_rate() << ")"
+                << std::endl;
+    }
+  }
+}
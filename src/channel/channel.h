@@ -0,0 +1,549 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <iterator>
+#include <limits>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <stop_token>
+#include <type_traits>
+#include <utility>
+
+namespace channel {
+
+// Go-style channel: a typed FIFO between threads, bounded or unbounded,
+// that can be closed. After close() sends fail and receivers drain what is
+// left, then see the channel as closed.
+//
+//   channel::Channel<int> jobs(64);
+//   std::thread worker([&] {
+//     while (auto job = jobs.recv())
+//       handle(*job);
+//   });
+//   jobs.send(1);
+//   jobs.close();
+//
+// select() waits on several channels at once:
+//
+//   channel::select_for(10ms,
+//       channel::on_recv(results, [](std::optional<int> r) { ... }),
+//       channel::on_send(jobs, 42, [](bool sent) { ... }));
+//
+// Each channel has its own mutex; there is no lock shared between
+// channels, so select() never holds more than one channel lock at a time.
+// A blocked thread -- plain send/recv or select -- parks on its own Parker
+// after linking a Waiter node into the wait list of every channel it is
+// interested in. Checking a channel and linking the node happen under that
+// channel's lock, so an item or a free slot that shows up afterwards always
+// finds the node and wakes the thread, which then retries.
+//
+// A change wakes as many plain waiters as it made items (or slots)
+// available, plus every select waiter: a woken select may well complete on
+// another channel instead, and must not swallow the only wake-up.
+//
+// Blocking sends and receives also take a std::stop_token; a stop request
+// wakes them like a notification and they return Status::cancelled:
+//   std::jthread worker([&](std::stop_token st) {
+//     while (auto job = jobs.recv(st))
+//       handle(*job);
+//   });
+
+enum class Status { ok, would_block, closed, timeout, cancelled };
+
+template <typename T>
+class Channel;
+
+namespace detail {
+
+using Clock = std::chrono::steady_clock;
+
+inline constexpr auto no_deadline = Clock::time_point::max();
+
+class Parker {
+public:
+  explicit Parker(bool timed) : timed(timed) {}
+
+  // Called under the lock of the channel the waiter is linked into; the
+  // waiter takes that lock again before it returns, so the parker is still
+  // alive here.
+  void notify() {
+    if (timed) {
+      std::lock_guard<std::mutex> lk(mut);
+      notified.store(true, std::memory_order_release);
+      cond.notify_one();
+    } else {
+      notified.store(true, std::memory_order_release);
+      notified.notify_one();
+    }
+  }
+
+  // False if the deadline passed without a notification. Untimed parkers
+  // sleep on the flag itself; timed ones need the condition variable.
+  bool wait_until(Clock::time_point deadline) {
+    if (!timed) {
+      notified.wait(false, std::memory_order_acquire);
+    } else {
+      std::unique_lock<std::mutex> lk(mut);
+      if (!cond.wait_until(lk, deadline,
+                           [this] { return notified.load(std::memory_order_acquire); }))
+        return false;
+    }
+    notified.store(false, std::memory_order_relaxed);
+    return true;
+  }
+
+private:
+  const bool timed;
+  std::atomic<bool> notified{false};
+  std::mutex mut;
+  std::condition_variable cond;
+};
+
+// Intrusive wait list node; lives on the waiting thread's stack.
+struct Waiter {
+  Parker *parker = nullptr;
+  bool select = false;
+  bool linked = false;
+  Waiter *prev = nullptr;
+  Waiter *next = nullptr;
+};
+
+// Guarded by the owning channel's mutex.
+class WaitList {
+public:
+  void push(Waiter &w) {
+    w.prev = tail;
+    w.next = nullptr;
+    (tail ? tail->next : head) = &w;
+    tail = &w;
+    w.linked = true;
+  }
+
+  void remove(Waiter &w) {
+    if (!w.linked)
+      return;
+    (w.prev ? w.prev->next : head) = w.next;
+    (w.next ? w.next->prev : tail) = w.prev;
+    w.linked = false;
+  }
+
+  // Wakes up to `plain` non-select waiters and every select waiter. Woken
+  // waiters leave the list and link themselves again if they retry.
+  void notify(std::size_t plain) {
+    Waiter *w = head;
+    while (w != nullptr) {
+      Waiter *next = w->next;
+      if (w->select || plain > 0) {
+        if (!w->select)
+          --plain;
+        remove(*w);
+        w->parker->notify();
+      }
+      w = next;
+    }
+  }
+
+  void notify_all() { notify(std::numeric_limits<std::size_t>::max()); }
+
+private:
+  Waiter *head = nullptr;
+  Waiter *tail = nullptr;
+};
+
+class SelectCase {
+public:
+  virtual ~SelectCase() = default;
+
+  // Performs the operation if it would not block (a closed channel counts
+  // as ready), otherwise links the case into the channel's wait list when
+  // `enlist` is set.
+  virtual bool attempt(bool enlist) = 0;
+  virtual void cancel() = 0;
+  virtual void fire() = 0;
+
+  Waiter node{nullptr, true};
+};
+
+} // namespace detail
+
+template <typename T>
+class Channel {
+public:
+  static constexpr std::size_t unbounded = std::numeric_limits<std::size_t>::max();
+
+  explicit Channel(std::size_t capacity = unbounded) : limit(capacity) {
+    if (capacity == 0)
+      throw std::invalid_argument("channel capacity must be positive");
+  }
+
+  Channel(const Channel &) = delete;
+  Channel &operator=(const Channel &) = delete;
+
+  [[nodiscard]] std::size_t capacity() const { return limit; }
+
+  [[nodiscard]] std::size_t size() const {
+    std::lock_guard<std::mutex> lk(mut);
+    return items.size();
+  }
+
+  [[nodiscard]] bool is_closed() const {
+    std::lock_guard<std::mutex> lk(mut);
+    return closed;
+  }
+
+  // Wakes every blocked sender and receiver. Items already in the channel
+  // can still be received.
+  void close() {
+    std::lock_guard<std::mutex> lk(mut);
+    closed = true;
+    receivers.notify_all();
+    senders.notify_all();
+  }
+
+  // Blocks while the channel is full. False (and `value` is dropped) if the
+  // channel is closed.
+  bool send(T value) {
+    return send_until(value, detail::no_deadline) == Status::ok;
+  }
+
+  // Also false once stop is requested on `st`.
+  bool send(T value, std::stop_token st) {
+    return send_until(value, detail::no_deadline, std::move(st)) == Status::ok;
+  }
+
+  // `value` is moved from only on Status::ok.
+  Status try_send(T &value) {
+    std::lock_guard<std::mutex> lk(mut);
+    return push_locked(value);
+  }
+
+  template <typename Rep, typename Period>
+  Status send_for(T &value, const std::chrono::duration<Rep, Period> &timeout,
+                  std::stop_token st = {}) {
+    return send_until(value, detail::Clock::now() + timeout, std::move(st));
+  }
+
+  // Blocks while the channel is empty. nullopt once it is closed and
+  // drained.
+  std::optional<T> recv() {
+    std::optional<T> value;
+    recv_until(value, detail::no_deadline);
+    return value;
+  }
+
+  // Also nullopt once stop is requested on `st`.
+  std::optional<T> recv(std::stop_token st) {
+    std::optional<T> value;
+    recv_until(value, detail::no_deadline, std::move(st));
+    return value;
+  }
+
+  Status try_recv(T &out) {
+    std::optional<T> value;
+    Status s;
+    {
+      std::lock_guard<std::mutex> lk(mut);
+      s = pop_locked(value);
+    }
+    if (s == Status::ok)
+      out = std::move(*value);
+    return s;
+  }
+
+  template <typename Rep, typename Period>
+  Status recv_for(T &out, const std::chrono::duration<Rep, Period> &timeout,
+                  std::stop_token st = {}) {
+    std::optional<T> value;
+    Status s = recv_until(value, detail::Clock::now() + timeout, std::move(st));
+    if (s == Status::ok)
+      out = std::move(*value);
+    return s;
+  }
+
+  // Sends [first, last), taking the lock once per run of free slots rather
+  // than once per item. Returns the position after the last item sent,
+  // which is `last` unless the channel was closed.
+  template <typename InputIt>
+  InputIt send_batch(InputIt first, InputIt last) {
+    detail::Parker parker(false);
+    detail::Waiter node{&parker, false};
+    while (first != last) {
+      {
+        std::lock_guard<std::mutex> lk(mut);
+        senders.remove(node);
+        if (closed)
+          return first;
+
+        std::size_t sent = 0;
+        for (; first != last && items.size() < limit; ++first, ++sent)
+          items.push_back(*first);
+        if (sent > 0) {
+          receivers.notify(sent);
+          continue;
+        }
+        senders.push(node);
+      }
+      parker.wait_until(detail::no_deadline);
+    }
+    return first;
+  }
+
+  // Blocks until at least one item is there, then takes up to `max` under
+  // one lock. Returns the output position; nothing written means the
+  // channel is closed and drained.
+  template <typename OutputIt>
+  OutputIt recv_batch(OutputIt out, std::size_t max) {
+    if (max == 0)
+      return out;
+
+    std::deque<T> taken;
+    detail::Parker parker(false);
+    detail::Waiter node{&parker, false};
+    for (;;) {
+      {
+        std::lock_guard<std::mutex> lk(mut);
+        receivers.remove(node);
+        if (!items.empty()) {
+          std::size_t n = std::min(max, items.size());
+          auto end = items.begin() + static_cast<std::ptrdiff_t>(n);
+          taken.assign(std::make_move_iterator(items.begin()),
+                       std::make_move_iterator(end));
+          items.erase(items.begin(), end);
+          senders.notify(n);
+          break;
+        }
+        if (closed)
+          return out;
+        receivers.push(node);
+      }
+      parker.wait_until(detail::no_deadline);
+    }
+
+    for (auto &item : taken)
+      *out++ = std::move(item);
+    return out;
+  }
+
+private:
+  template <typename U, typename F>
+  friend class RecvCase;
+  template <typename U, typename F>
+  friend class SendCase;
+
+  Status push_locked(T &value) {
+    if (closed)
+      return Status::closed;
+    if (items.size() >= limit)
+      return Status::would_block;
+    items.push_back(std::move(value));
+    receivers.notify(1);
+    return Status::ok;
+  }
+
+  Status pop_locked(std::optional<T> &value) {
+    if (items.empty())
+      return closed ? Status::closed : Status::would_block;
+    value.emplace(std::move(items.front()));
+    items.pop_front();
+    senders.notify(1);
+    return Status::ok;
+  }
+
+  // Runs `op` under the lock until it does not report would_block, parking
+  // on `list` in between. A stop request unparks the thread the way a
+  // notification does, under the lock, so it cannot slip in between the
+  // check and the park.
+  template <typename Op>
+  Status block_on(detail::WaitList &list, Op op, detail::Clock::time_point deadline,
+                  std::stop_token st) {
+    detail::Parker parker(deadline != detail::no_deadline);
+    detail::Waiter node{&parker, false};
+    std::stop_callback on_stop(st, [&] {
+      std::lock_guard<std::mutex> lk(mut);
+      if (node.linked) {
+        list.remove(node);
+        parker.notify();
+      }
+    });
+    bool timed_out = false;
+    for (;;) {
+      {
+        std::lock_guard<std::mutex> lk(mut);
+        list.remove(node);
+        Status s = op();
+        if (s != Status::would_block)
+          return s;
+        if (st.stop_requested())
+          return Status::cancelled;
+        if (timed_out)
+          return Status::timeout;
+        list.push(node);
+      }
+      if (!parker.wait_until(deadline))
+        timed_out = true;
+    }
+  }
+
+  Status send_until(T &value, detail::Clock::time_point deadline, std::stop_token st = {}) {
+    return block_on(senders, [&] { return push_locked(value); }, deadline, std::move(st));
+  }
+
+  Status recv_until(std::optional<T> &value, detail::Clock::time_point deadline,
+                    std::stop_token st = {}) {
+    return block_on(receivers, [&] { return pop_locked(value); }, deadline, std::move(st));
+  }
+
+  mutable std::mutex mut;
+  std::deque<T> items;
+  std::size_t limit;
+  bool closed = false;
+  detail::WaitList receivers;
+  detail::WaitList senders;
+};
+
+// select() case receiving from `ch`; calls f(std::optional<T>), with
+// nullopt if the channel is closed and drained.
+template <typename T, typename F>
+class RecvCase : public detail::SelectCase {
+public:
+  RecvCase(Channel<T> &ch, F f) : ch(ch), f(std::move(f)) {}
+
+  bool attempt(bool enlist) override {
+    std::lock_guard<std::mutex> lk(ch.mut);
+    ch.receivers.remove(node);
+    if (ch.pop_locked(value) != Status::would_block)
+      return true;
+    if (enlist)
+      ch.receivers.push(node);
+    return false;
+  }
+
+  void cancel() override {
+    std::lock_guard<std::mutex> lk(ch.mut);
+    ch.receivers.remove(node);
+  }
+
+  void fire() override { f(std::move(value)); }
+
+private:
+  Channel<T> &ch;
+  F f;
+  std::optional<T> value;
+};
+
+// select() case sending `value` to `ch`; calls f(bool sent), with false if
+// the channel is closed.
+template <typename T, typename F>
+class SendCase : public detail::SelectCase {
+public:
+  SendCase(Channel<T> &ch, T value, F f)
+    : ch(ch), value(std::move(value)), f(std::move(f))
+  {}
+
+  bool attempt(bool enlist) override {
+    std::lock_guard<std::mutex> lk(ch.mut);
+    ch.senders.remove(node);
+    Status s = ch.push_locked(value);
+    if (s != Status::would_block) {
+      sent = s == Status::ok;
+      return true;
+    }
+    if (enlist)
+      ch.senders.push(node);
+    return false;
+  }
+
+  void cancel() override {
+    std::lock_guard<std::mutex> lk(ch.mut);
+    ch.senders.remove(node);
+  }
+
+  void fire() override { f(sent); }
+
+private:
+  Channel<T> &ch;
+  T value;
+  F f;
+  bool sent = false;
+};
+
+template <typename T, typename F>
+RecvCase<T, std::decay_t<F>> on_recv(Channel<T> &ch, F &&f) {
+  return {ch, std::forward<F>(f)};
+}
+
+template <typename T, typename U, typename F>
+SendCase<T, std::decay_t<F>> on_send(Channel<T> &ch, U &&value, F &&f) {
+  return {ch, T(std::forward<U>(value)), std::forward<F>(f)};
+}
+
+namespace detail {
+
+// Returns the index of the case that fired. Cases are tried starting from a
+// rotating position so that a busy channel early in the list cannot starve
+// the others.
+template <std::size_t N>
+std::optional<std::size_t> select_impl(const std::array<SelectCase *, N> &cases,
+                                       bool block, Clock::time_point deadline) {
+  static_assert(N > 0, "select needs at least one case");
+  static thread_local std::size_t rotation = 0;
+
+  Parker parker(deadline != no_deadline);
+  for (auto *c : cases)
+    c->node.parker = &parker;
+
+  std::size_t start = rotation++ % N;
+  bool timed_out = false;
+  for (;;) {
+    for (std::size_t k = 0; k < N; ++k) {
+      std::size_t i = (start + k) % N;
+      if (!cases[i]->attempt(block && !timed_out))
+        continue;
+      for (std::size_t j = 0; j < N; ++j)
+        if (j != i)
+          cases[j]->cancel();
+      cases[i]->fire();
+      return i;
+    }
+
+    if (!block || timed_out) {
+      for (auto *c : cases)
+        c->cancel();
+      return std::nullopt;
+    }
+    if (!parker.wait_until(deadline))
+      timed_out = true;
+  }
+}
+
+} // namespace detail
+
+// Blocks until one case can proceed, runs it and returns its index.
+template <typename... Cases>
+std::size_t select(Cases &&...cases) {
+  return *detail::select_impl<sizeof...(Cases)>({&cases...}, true, detail::no_deadline);
+}
+
+// Like select(), or nullopt once `timeout` has passed.
+template <typename Rep, typename Period, typename... Cases>
+std::optional<std::size_t> select_for(const std::chrono::duration<Rep, Period> &timeout,
+                                      Cases &&...cases) {
+  return detail::select_impl<sizeof...(Cases)>(
+      {&cases...}, true, detail::Clock::now() + timeout);
+}
+
+// Like select(), but returns nullopt right away if no case is ready (Go's
+// `default:`).
+template <typename... Cases>
+std::optional<std::size_t> try_select(Cases &&...cases) {
+  return detail::select_impl<sizeof...(Cases)>({&cases...}, false, detail::no_deadline);
+}
+
+} // namespace channel
@@ -0,0 +1,385 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <iterator>
+#include <mutex>
+#include <numeric>
+#include <optional>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "channel/channel.h"
+
+using namespace std::chrono_literals;
+
+TEST(channel_test, basic_test) {
+  channel::Channel<std::string> ch(2);
+  EXPECT_EQ(ch.capacity(), 2u);
+  EXPECT_THROW(channel::Channel<int>(0), std::invalid_argument);
+
+  EXPECT_TRUE(ch.send("a"));
+  EXPECT_TRUE(ch.send("b"));
+
+  std::string full = "c";
+  EXPECT_EQ(ch.try_send(full), channel::Status::would_block);
+  EXPECT_EQ(full, "c");
+  EXPECT_EQ(ch.send_for(full, 10ms), channel::Status::timeout);
+
+  EXPECT_EQ(*ch.recv(), "a");
+  std::string out;
+  EXPECT_EQ(ch.try_recv(out), channel::Status::ok);
+  EXPECT_EQ(out, "b");
+  EXPECT_EQ(ch.try_recv(out), channel::Status::would_block);
+  EXPECT_EQ(ch.recv_for(out, 10ms), channel::Status::timeout);
+}
+
+TEST(channel_test, close_test) {
+  channel::Channel<int> ch;
+  EXPECT_EQ(ch.capacity(), channel::Channel<int>::unbounded);
+
+  for (int i = 0; i < 3; ++i)
+    ch.send(i);
+  ch.close();
+
+  EXPECT_TRUE(ch.is_closed());
+  EXPECT_FALSE(ch.send(3));
+
+  // What was sent before close() is still delivered.
+  for (int i = 0; i < 3; ++i)
+    EXPECT_EQ(ch.recv(), i);
+  EXPECT_EQ(ch.recv(), std::nullopt);
+
+  int out;
+  EXPECT_EQ(ch.try_recv(out), channel::Status::closed);
+
+  // close() wakes a blocked receiver.
+  channel::Channel<int> empty(1);
+  std::thread closer([&] {
+    std::this_thread::sleep_for(10ms);
+    empty.close();
+  });
+  EXPECT_EQ(empty.recv(), std::nullopt);
+  closer.join();
+}
+
+TEST(channel_test, cancel_test) {
+  // A stop request wakes a blocked receiver and sender.
+  channel::Channel<int> ch(1);
+  std::optional<int> got = 0;
+  std::jthread receiver([&](std::stop_token st) { got = ch.recv(st); });
+  std::this_thread::sleep_for(10ms);
+  receiver.request_stop();
+  receiver.join();
+  EXPECT_EQ(got, std::nullopt);
+  EXPECT_FALSE(ch.is_closed());
+
+  EXPECT_TRUE(ch.send(1));
+  bool sent = true;
+  std::jthread sender([&](std::stop_token st) { sent = ch.send(2, st); });
+  std::this_thread::sleep_for(10ms);
+  sender.request_stop();
+  sender.join();
+  EXPECT_FALSE(sent);
+  EXPECT_EQ(ch.size(), 1);
+
+  // An item that is there wins over a stop that was already requested;
+  // after that the wait returns at once.
+  std::stop_source source;
+  source.request_stop();
+  EXPECT_EQ(ch.recv(source.get_token()), 1);
+  int out;
+  EXPECT_EQ(ch.recv_for(out, 1h, source.get_token()), channel::Status::cancelled);
+
+  // Timed and cancellable: whichever comes first.
+  std::stop_source never;
+  EXPECT_EQ(ch.recv_for(out, 10ms, never.get_token()), channel::Status::timeout);
+}
+
+TEST(channel_test, producer_consumer_test) {
+  // The three producers / two consumers of condition_variables_semantic.cc,
+  // with close() telling the consumers when to stop.
+  channel::Channel<int> buffer(10);
+  std::vector<std::vector<int>> consumed(2);
+
+  std::vector<std::thread> consumers;
+  for (int id = 0; id < 2; ++id) {
+    consumers.emplace_back([&, id] {
+      while (auto item = buffer.recv())
+        consumed[id].push_back(*item);
+    });
+  }
+
+  std::vector<std::thread> producers;
+  for (int id = 0; id < 3; ++id) {
+    producers.emplace_back([&, id] {
+      for (int i = 0; i < 20; ++i)
+        buffer.send(i + id * 1000);
+    });
+  }
+  for (auto &t : producers)
+    t.join();
+  buffer.close();
+  for (auto &t : consumers)
+    t.join();
+
+  std::vector<int> all = consumed[0];
+  all.insert(all.end(), consumed[1].begin(), consumed[1].end());
+  std::sort(all.begin(), all.end());
+
+  std::vector<int> expected;
+  for (int id = 0; id < 3; ++id)
+    for (int i = 0; i < 20; ++i)
+      expected.push_back(i + id * 1000);
+  EXPECT_EQ(all, expected);
+}
+
+TEST(channel_test, batch_test) {
+  channel::Channel<int> ch(16);
+  std::vector<int> input(1000);
+  std::iota(input.begin(), input.end(), 0);
+
+  std::thread producer([&] {
+    EXPECT_EQ(ch.send_batch(input.begin(), input.end()), input.end());
+    ch.close();
+  });
+
+  std::vector<int> output;
+  std::size_t before;
+  do {
+    before = output.size();
+    ch.recv_batch(std::back_inserter(output), 64);
+  } while (output.size() != before);
+  producer.join();
+
+  EXPECT_EQ(output, input);
+}
+
+TEST(channel_test, select_test) {
+  channel::Channel<int> numbers(1);
+  channel::Channel<std::string> words(1);
+
+  std::string got;
+  auto which = channel::try_select(
+      channel::on_recv(numbers, [&](std::optional<int> v) { got = std::to_string(*v); }),
+      channel::on_recv(words, [&](std::optional<std::string> v) { got = *v; }));
+  EXPECT_EQ(which, std::nullopt);
+
+  words.send("hello");
+  which = channel::select(
+      channel::on_recv(numbers, [&](std::optional<int> v) { got = std::to_string(*v); }),
+      channel::on_recv(words, [&](std::optional<std::string> v) { got = *v; }));
+  EXPECT_EQ(which, 1u);
+  EXPECT_EQ(got, "hello");
+
+  // A send case fires once there is room.
+  numbers.send(1);
+  std::thread drain([&] {
+    std::this_thread::sleep_for(10ms);
+    numbers.recv();
+  });
+  bool sent = false;
+  which = channel::select(channel::on_send(numbers, 2, [&](bool ok) { sent = ok; }));
+  EXPECT_EQ(which, 0u);
+  EXPECT_TRUE(sent);
+  drain.join();
+  EXPECT_EQ(numbers.recv(), 2);
+
+  // Timeout.
+  auto sta = std::chrono::steady_clock::now();
+  which = channel::select_for(20ms, channel::on_recv(numbers, [](std::optional<int>) {}),
+                              channel::on_recv(words, [](std::optional<std::string>) {}));
+  EXPECT_EQ(which, std::nullopt);
+  EXPECT_GE(std::chrono::steady_clock::now() - sta, 20ms);
+
+  // A closed channel is ready and yields nullopt.
+  words.close();
+  std::optional<std::string> closed = "not yet";
+  which = channel::select(channel::on_recv(numbers, [](std::optional<int>) {}),
+                          channel::on_recv(words, [&](std::optional<std::string> v) { closed = v; }));
+  EXPECT_EQ(which, 1u);
+  EXPECT_EQ(closed, std::nullopt);
+}
+
+TEST(channel_test, select_stress_test) {
+  // Two producers feed two channels; one consumer selects over both. Every
+  // item must arrive exactly once.
+  constexpr int per_channel = 10000;
+  channel::Channel<int> a(4), b(4);
+
+  std::thread pa([&] {
+    for (int i = 0; i < per_channel; ++i)
+      a.send(i);
+    a.close();
+  });
+  std::thread pb([&] {
+    for (int i = 0; i < per_channel; ++i)
+      b.send(i);
+    b.close();
+  });
+
+  long long sum_a = 0, sum_b = 0;
+  bool a_open = true, b_open = true;
+  while (a_open || b_open) {
+    if (a_open && b_open) {
+      channel::select(
+          channel::on_recv(a, [&](std::optional<int> v) { v ? void(sum_a += *v) : void(a_open = false); }),
+          channel::on_recv(b, [&](std::optional<int> v) { v ? void(sum_b += *v) : void(b_open = false); }));
+    } else if (a_open) {
+      auto v = a.recv();
+      v ? void(sum_a += *v) : void(a_open = false);
+    } else {
+      auto v = b.recv();
+      v ? void(sum_b += *v) : void(b_open = false);
+    }
+  }
+  pa.join();
+  pb.join();
+
+  long long expected = static_cast<long long>(per_channel) * (per_channel - 1) / 2;
+  EXPECT_EQ(sum_a, expected);
+  EXPECT_EQ(sum_b, expected);
+}
+
+namespace {
+
+// The hand-rolled bounded buffer of condition_variables_semantic.cc: one
+// global mutex and buffer_not_empty/buffer_not_full condition variables.
+class CondVarQueue {
+public:
+  explicit CondVarQueue(std::size_t size) : size(size) {}
+
+  void push(int item) {
+    std::unique_lock<std::mutex> lock(mtx);
+    buffer_not_full.wait(lock, [this] { return buffer.size() < size; });
+    buffer.push(item);
+    lock.unlock();
+    buffer_not_empty.notify_one();
+  }
+
+  int pop() {
+    std::unique_lock<std::mutex> lock(mtx);
+    buffer_not_empty.wait(lock, [this] { return !buffer.empty(); });
+    int item = buffer.front();
+    buffer.pop();
+    lock.unlock();
+    buffer_not_full.notify_one();
+    return item;
+  }
+
+private:
+  std::size_t size;
+  std::queue<int> buffer;
+  std::mutex mtx;
+  std::condition_variable buffer_not_empty;
+  std::condition_variable buffer_not_full;
+};
+
+double per_op_ns(std::chrono::steady_clock::time_point sta, int ops) {
+  std::chrono::duration<double, std::nano> dur = std::chrono::steady_clock::now() - sta;
+  return dur.count() / ops;
+}
+
+} // namespace
+
+TEST(channel_test, benchmark) {
+  constexpr int round_trips = 20000;
+  constexpr int items = 1000000;
+
+  {
+    CondVarQueue ping(1), pong(1);
+    std::thread peer([&] {
+      for (int i = 0; i < round_trips; ++i)
+        pong.push(ping.pop());
+    });
+    auto sta = std::chrono::steady_clock::now();
+    for (int i = 0; i < round_trips; ++i) {
+      ping.push(i);
+      pong.pop();
+    }
+    double ns = per_op_ns(sta, round_trips);
+    peer.join();
+    std::cout << "condvar queue ping-pong: " << ns << " ns per round trip." << std::endl;
+  }
+
+  {
+    channel::Channel<int> ping(1), pong(1);
+    std::thread peer([&] {
+      for (int i = 0; i < round_trips; ++i)
+        pong.send(*ping.recv());
+    });
+    auto sta = std::chrono::steady_clock::now();
+    for (int i = 0; i < round_trips; ++i) {
+      ping.send(i);
+      pong.recv();
+    }
+    double ns = per_op_ns(sta, round_trips);
+    peer.join();
+    std::cout << "Channel ping-pong: " << ns << " ns per round trip." << std::endl;
+  }
+
+  {
+    CondVarQueue queue(1024);
+    long long sum = 0;
+    auto sta = std::chrono::steady_clock::now();
+    std::thread consumer([&] {
+      for (int i = 0; i < items; ++i)
+        sum += queue.pop();
+    });
+    for (int i = 0; i < items; ++i)
+      queue.push(i);
+    consumer.join();
+    double ns = per_op_ns(sta, items);
+
+    EXPECT_EQ(sum, static_cast<long long>(items) * (items - 1) / 2);
+    std::cout << "condvar queue throughput: " << 1e3 / ns << " M items/s." << std::endl;
+  }
+
+  {
+    channel::Channel<int> ch(1024);
+    long long sum = 0;
+    auto sta = std::chrono::steady_clock::now();
+    std::thread consumer([&] {
+      while (auto v = ch.recv())
+        sum += *v;
+    });
+    for (int i = 0; i < items; ++i)
+      ch.send(i);
+    ch.close();
+    consumer.join();
+    double ns = per_op_ns(sta, items);
+
+    EXPECT_EQ(sum, static_cast<long long>(items) * (items - 1) / 2);
+    std::cout << "Channel throughput: " << 1e3 / ns << " M items/s." << std::endl;
+  }
+
+  {
+    channel::Channel<int> ch(1024);
+    std::vector<int> input(items);
+    std::iota(input.begin(), input.end(), 0);
+    long long sum = 0;
+    auto sta = std::chrono::steady_clock::now();
+    std::thread consumer([&] {
+      std::vector<int> batch;
+      for (;;) {
+        batch.clear();
+        ch.recv_batch(std::back_inserter(batch), 256);
+        if (batch.empty())
+          break;
+        for (int v : batch)
+          sum += v;
+      }
+    });
+    for (std::size_t i = 0; i < input.size(); i += 256)
+      ch.send_batch(input.begin() + i, input.begin() + std::min(input.size(), i + 256));
+    ch.close();
+    consumer.join();
+    double ns = per_op_ns(sta, items);
+
+    EXPECT_EQ(sum, static_cast<long long>(items) * (items - 1) / 2);
+    std::cout << "Channel batch throughput: " << 1e3 / ns << " M items/s." << std::endl;
+  }
+}
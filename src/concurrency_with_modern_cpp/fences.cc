@@ -38,6 +38,7 @@ TEST(fences_test, test1) {
 
   t1.join();
   t2.join();
+  delete memory_order_utils::ptr.exchange(nullptr);
 
   std::cout << std::endl;
 }
@@ -76,6 +77,7 @@ TEST(fences_test, test2) {
 
   t1.join();
   t2.join();
+  delete fences_utils::ptr.exchange(nullptr);
 
   std::cout << std::endl;
 }
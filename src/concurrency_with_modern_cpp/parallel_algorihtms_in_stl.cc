@@ -6,6 +6,9 @@
 #include <random>
 #include <utility>
 
+#include "numa/numa.h"
+#include "parallel_fill/parallel_fill.h"
+
 #ifdef PARALLEL
 #include <execution>
   namespace execution = std::execution;
@@ -46,7 +49,7 @@ constexpr long long thi = 75000000;
 constexpr long long fou = 100000000;
 
 void sum_up(std::promise<unsigned long long> &&prom,
-            const std::vector<int> &val,
+            const numa::numa_vector<int> &val,
             unsigned long long beg,
             unsigned long long end) {
   unsigned  long long sum{};
@@ -57,14 +60,15 @@ void sum_up(std::promise<unsigned long long> &&prom,
 }
 
 void test_performance() {
-  std::vector<int> rand_values;
-  rand_values.reserve(size);
-
-  std::mt19937  g;
-  std::uniform_int_distribution<> uniform_dist(1, 10);
-
-  for (long long i = 0; i < size; ++i)
-    rand_values.push_back(uniform_dist(g));
+  // The four summing threads are not tied to a node, so spread the pages
+  // over all nodes instead of leaving them on the allocating thread's node.
+  numa::numa_vector<int> rand_values(
+      size, numa::NumaAllocator<int>(numa::Placement::interleaved()));
+  {
+    thread_pool::ThreadPool pool;
+    parallel_fill::fill_uniform(pool, rand_values.begin(), rand_values.end(),
+                                1, 10, std::mt19937::default_seed);
+  }
 
   std::promise<unsigned long long> prom1;
   std::promise<unsigned long long> prom2;
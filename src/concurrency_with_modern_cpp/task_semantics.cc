@@ -8,6 +8,10 @@
 #include <utility>
 #include <deque>
 
+#include "numa/numa.h"
+#include "parallel_fill/parallel_fill.h"
+#include "thread_pool/thread_pool.h"
+
 namespace task_utils {
 
 // Tasks versus threads
@@ -124,22 +128,23 @@ void fire_and_forget_future_test() {
 
 static constexpr int NUM = 100000000;
 
-long long get_dot_product(std::vector<int> &v, std::vector<int> &w) {
+long long get_dot_product(numa::numa_vector<int> &v, numa::numa_vector<int> &w) {
   auto size = v.size();
+  auto &pool = thread_pool::global_pool();
 
-  auto future1 = std::async([&] {
+  auto future1 = thread_pool::async_on(pool, [&] {
     return std::inner_product(&v[0], &v[size / 4], &w[0], 0ll);
   });
 
-  auto future2 = std::async([&] {
+  auto future2 = thread_pool::async_on(pool, [&] {
     return std::inner_product(&v[size / 4], &v[size / 2], &w[size / 4], 0ll);
   });
 
-  auto future3 = std::async([&] {
+  auto future3 = thread_pool::async_on(pool, [&] {
     return std::inner_product(&v[size / 2], &v[size * 3 / 4], &w[size / 2], 0ll);
   });
 
-  auto future4 = std::async([&] {
+  auto future4 = thread_pool::async_on(pool, [&] {
     return std::inner_product(&v[size * 3 / 4], &v[size], &w[size * 3 / 4], 0ll);
   });
 
@@ -177,20 +182,15 @@ TEST(task_test, concurrent_calculation_example) {
 
   std::random_device seed;
 
-  // generator
-  std::mt19937 engine(seed());
-
-  // distribution
-  std::uniform_int_distribution<int> dist(0, 100);
-
-  // fill the vectors
-  std::vector<int> v, w;
-  v.reserve(NUM);
-  w.reserve(NUM);
-
-  for (int i = 0; i < NUM; ++i) {
-    v.push_back(dist(engine));
-    w.push_back(dist(engine));
+  // fill the vectors in parallel; a single std::mt19937 takes far longer
+  // than the dot product itself. The pages are interleaved over the NUMA
+  // nodes, since the global pool's workers may run on any of them.
+  numa::NumaAllocator<int> spread(numa::Placement::interleaved());
+  numa::numa_vector<int> v(NUM, spread), w(NUM, spread);
+  {
+    thread_pool::ThreadPool pool;
+    parallel_fill::fill_uniform(pool, v.begin(), v.end(), 0, 100, seed());
+    parallel_fill::fill_uniform(pool, w.begin(), w.end(), 0, 100, seed());
   }
 
   std::cout << "get_dot_product(v, w) = " << get_dot_product(v, w) << std::endl;
@@ -496,20 +496,16 @@ void shared_future_case() {
   Div div;
   std::thread div_thread(div, std::move(div_promise), 20, 10);
 
+  // The requestors run on the global pool instead of one thread each.
   Requestor req;
-  std::thread shared_thread1(req, div_result);
-  std::thread shared_thread2(req, div_result);
-  std::thread shared_thread3(req, div_result);
-  std::thread shared_thread4(req, div_result);
-  std::thread shared_thread5(req, div_result);
+  std::vector<std::future<void>> requests;
+  for (int i = 0; i < 5; ++i)
+    requests.push_back(thread_pool::async_on(thread_pool::global_pool(), req, div_result));
 
   div_thread.join();
 
-  shared_thread1.join();
-  shared_thread2.join();
-  shared_thread3.join();
-  shared_thread4.join();
-  shared_thread5.join();
+  for (auto &request : requests)
+    request.get();
 }
 
 void do_the_work() {
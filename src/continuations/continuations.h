@@ -0,0 +1,420 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "thread_pool/thread_pool.h"
+
+namespace continuations {
+
+// Future/Promise pair in the spirit of the Concurrency TS (std::experimental::
+// future): instead of blocking in get() and then starting the next step,
+// `fut.then(executor, f)` attaches f to the future and returns a future for
+// f's result. f runs on `executor` (anything with `execute(callable)`, e.g.
+// thread_pool::ThreadPool) once the value is there; `fut.then(f)` runs it
+// inline on the thread that completes the future.
+//
+// An exception stored in a future skips every continuation of the chain and
+// is rethrown by the final get().
+//
+// A future created ready (make_ready_future()) keeps its value inline and
+// has no shared state; then(f) on a ready future calls f right away and
+// returns another inline future, so a chain over ready values never
+// allocates.
+
+template <typename T>
+class Future;
+
+template <typename T>
+class Promise;
+
+namespace detail {
+
+struct Unit {};
+
+template <typename T>
+using value_t = std::conditional_t<std::is_void_v<T>, Unit, T>;
+
+// Empty, value or exception.
+template <typename T>
+using Result = std::variant<std::monostate, value_t<T>, std::exception_ptr>;
+
+template <typename T, typename F>
+struct continuation_result {
+  using type = std::invoke_result_t<F &, T>;
+};
+
+template <typename F>
+struct continuation_result<void, F> {
+  using type = std::invoke_result_t<F &>;
+};
+
+template <typename T, typename F>
+using continuation_result_t = typename continuation_result<T, F>::type;
+
+// Feeds a predecessor's result to f. An exception skips f.
+template <typename R, typename T, typename F>
+Result<R> apply(F &f, Result<T> &&in) {
+  if (in.index() == 2)
+    return Result<R>(std::in_place_index<2>, std::get<2>(std::move(in)));
+
+  try {
+    if constexpr (std::is_void_v<R>) {
+      if constexpr (std::is_void_v<T>)
+        f();
+      else
+        f(std::get<1>(std::move(in)));
+      return Result<R>(std::in_place_index<1>);
+    } else {
+      if constexpr (std::is_void_v<T>)
+        return Result<R>(std::in_place_index<1>, f());
+      else
+        return Result<R>(std::in_place_index<1>, f(std::get<1>(std::move(in))));
+    }
+  } catch (...) {
+    return Result<R>(std::in_place_index<2>, std::current_exception());
+  }
+}
+
+template <typename T>
+class SharedState {
+public:
+  void set_result(Result<T> r) {
+    thread_pool::FunctionWrapper cb;
+    {
+      std::lock_guard<std::mutex> lk(mut);
+      if (ready)
+        throw std::future_error(std::future_errc::promise_already_satisfied);
+      result = std::move(r);
+      ready = true;
+      cb = std::move(callback);
+    }
+    cond.notify_all();
+
+    if (cb)
+      cb();
+  }
+
+  // Calls f(Result<T>&&) once the result is there: right away if it already
+  // is, otherwise from set_result(). At most one subscriber per state.
+  template <typename F>
+  void subscribe(F f) {
+    std::unique_lock<std::mutex> lk(mut);
+    if (!ready) {
+      callback = [this, f = std::move(f)]() mutable { f(std::move(result)); };
+      return;
+    }
+    lk.unlock();
+    f(std::move(result));
+  }
+
+  bool is_ready() const {
+    std::lock_guard<std::mutex> lk(mut);
+    return ready;
+  }
+
+  void wait() const {
+    std::unique_lock<std::mutex> lk(mut);
+    cond.wait(lk, [this] { return ready; });
+  }
+
+  Result<T> take() {
+    wait();
+    return std::move(result);
+  }
+
+private:
+  mutable std::mutex mut;
+  mutable std::condition_variable cond;
+  bool ready = false;
+  Result<T> result;
+  thread_pool::FunctionWrapper callback;
+};
+
+struct InlineExecutor {
+  template <typename F>
+  void execute(F &&f) { std::forward<F>(f)(); }
+};
+
+inline InlineExecutor &inline_executor() {
+  static InlineExecutor executor;
+  return executor;
+}
+
+} // namespace detail
+
+template <typename T>
+class Future {
+public:
+  Future() = default;
+
+  Future(Future &&) noexcept = default;
+  Future &operator=(Future &&) noexcept = default;
+
+  [[nodiscard]] bool valid() const { return state || local.index() != 0; }
+
+  [[nodiscard]] bool is_ready() const {
+    return local.index() != 0 || (state && state->is_ready());
+  }
+
+  void wait() const {
+    if (state)
+      state->wait();
+  }
+
+  T get() {
+    detail::Result<T> r = take_result();
+    if (r.index() == 2)
+      std::rethrow_exception(std::get<2>(std::move(r)));
+    if constexpr (!std::is_void_v<T>)
+      return std::get<1>(std::move(r));
+  }
+
+  // Runs f inline on the completing thread, or right now if the value is
+  // already there. Invalidates this future.
+  template <typename F>
+  Future<detail::continuation_result_t<T, F>> then(F f) {
+    using R = detail::continuation_result_t<T, F>;
+    if (is_ready())
+      return Future<R>(detail::apply<R, T>(f, take_result()));
+    return then(detail::inline_executor(), std::move(f));
+  }
+
+  // Schedules f on `executor` once the value is there. Invalidates this
+  // future. The executor must outlive the continuation.
+  template <typename Executor, typename F>
+  Future<detail::continuation_result_t<T, F>> then(Executor &executor, F f) {
+    using R = detail::continuation_result_t<T, F>;
+
+    Promise<R> promise;
+    Future<R> next = promise.get_future();
+    subscribe([ex = &executor, promise = std::move(promise),
+               f = std::move(f)](detail::Result<T> &&r) mutable {
+      // An executor that rejects the task (a shut-down pool) destroys it,
+      // and with it the promise, so `next` sees broken_promise.
+      (void)ex->execute([promise = std::move(promise), f = std::move(f),
+                         r = std::move(r)]() mutable {
+        promise.set_result(detail::apply<R, T>(f, std::move(r)));
+      });
+    });
+    return next;
+  }
+
+private:
+  template <typename U>
+  friend class Future;
+  friend class Promise<T>;
+
+  template <typename U>
+  friend Future<std::decay_t<U>> make_ready_future(U &&value);
+  friend Future<void> make_ready_future();
+  template <typename U>
+  friend Future<U> make_exceptional_future(std::exception_ptr error);
+  template <typename U>
+  friend Future<std::vector<U>> when_all(std::vector<Future<U>> futures);
+  template <typename U>
+  friend Future<std::pair<std::size_t, U>> when_any(std::vector<Future<U>> futures);
+
+  explicit Future(std::shared_ptr<detail::SharedState<T>> s)
+    : state(std::move(s))
+  {}
+
+  explicit Future(detail::Result<T> r) : local(std::move(r)) {}
+
+  detail::Result<T> take_result() {
+    if (!valid())
+      throw std::future_error(std::future_errc::no_state);
+
+    if (state) {
+      auto s = std::move(state);
+      return s->take();
+    }
+    return std::exchange(local, detail::Result<T>{});
+  }
+
+  template <typename F>
+  void subscribe(F f) {
+    if (!valid())
+      throw std::future_error(std::future_errc::no_state);
+
+    if (state) {
+      auto s = std::move(state);
+      s->subscribe(std::move(f));
+    } else {
+      f(std::exchange(local, detail::Result<T>{}));
+    }
+  }
+
+  std::shared_ptr<detail::SharedState<T>> state;
+  detail::Result<T> local;
+};
+
+template <typename T>
+class Promise {
+public:
+  Promise() : state(std::make_shared<detail::SharedState<T>>()) {}
+
+  Promise(Promise &&) noexcept = default;
+  Promise &operator=(Promise &&other) noexcept {
+    abandon();
+    state = std::move(other.state);
+    future_retrieved = other.future_retrieved;
+    return *this;
+  }
+
+  ~Promise() { abandon(); }
+
+  Future<T> get_future() {
+    if (!state)
+      throw std::future_error(std::future_errc::no_state);
+    if (future_retrieved)
+      throw std::future_error(std::future_errc::future_already_retrieved);
+    future_retrieved = true;
+    return Future<T>(state);
+  }
+
+  void set_value(detail::value_t<T> value) requires(!std::is_void_v<T>) {
+    set_result(detail::Result<T>(std::in_place_index<1>, std::move(value)));
+  }
+
+  void set_value() requires std::is_void_v<T> {
+    set_result(detail::Result<T>(std::in_place_index<1>));
+  }
+
+  void set_exception(std::exception_ptr error) {
+    set_result(detail::Result<T>(std::in_place_index<2>, std::move(error)));
+  }
+
+private:
+  template <typename U>
+  friend class Future;
+
+  void set_result(detail::Result<T> r) {
+    if (!state)
+      throw std::future_error(std::future_errc::no_state);
+    auto s = std::move(state);
+    s->set_result(std::move(r));
+  }
+
+  // A promise destroyed without a result breaks its future, like
+  // std::promise.
+  void abandon() {
+    if (state) {
+      auto s = std::move(state);
+      s->set_result(detail::Result<T>(
+          std::in_place_index<2>,
+          std::make_exception_ptr(std::future_error(std::future_errc::broken_promise))));
+    }
+  }
+
+  std::shared_ptr<detail::SharedState<T>> state;
+  bool future_retrieved = false;
+};
+
+template <typename T>
+Future<std::decay_t<T>> make_ready_future(T &&value) {
+  using U = std::decay_t<T>;
+  return Future<U>(detail::Result<U>(std::in_place_index<1>, std::forward<T>(value)));
+}
+
+inline Future<void> make_ready_future() {
+  return Future<void>(detail::Result<void>(std::in_place_index<1>));
+}
+
+template <typename T>
+Future<T> make_exceptional_future(std::exception_ptr error) {
+  return Future<T>(detail::Result<T>(std::in_place_index<2>, std::move(error)));
+}
+
+// Ready once every input is. Holds all values in input order, or the first
+// exception (in completion order) if any input failed.
+template <typename T>
+Future<std::vector<T>> when_all(std::vector<Future<T>> futures) {
+  static_assert(!std::is_void_v<T>, "when_all needs a value type");
+
+  if (futures.empty())
+    return make_ready_future(std::vector<T>{});
+
+  struct Context {
+    explicit Context(std::size_t n) : values(n), remaining(n) {}
+
+    std::vector<std::optional<T>> values;
+    std::atomic<std::size_t> remaining;
+    std::mutex mut;
+    std::exception_ptr error;
+    Promise<std::vector<T>> promise;
+  };
+
+  auto ctx = std::make_shared<Context>(futures.size());
+  auto result = ctx->promise.get_future();
+
+  for (std::size_t i = 0; i < futures.size(); ++i) {
+    futures[i].subscribe([ctx, i](detail::Result<T> &&r) {
+      if (r.index() == 2) {
+        std::lock_guard<std::mutex> lk(ctx->mut);
+        if (!ctx->error)
+          ctx->error = std::get<2>(std::move(r));
+      } else {
+        ctx->values[i].emplace(std::get<1>(std::move(r)));
+      }
+
+      if (ctx->remaining.fetch_sub(1, std::memory_order_acq_rel) != 1)
+        return;
+
+      if (ctx->error) {
+        ctx->promise.set_exception(ctx->error);
+        return;
+      }
+      std::vector<T> values;
+      values.reserve(ctx->values.size());
+      for (auto &value : ctx->values)
+        values.push_back(std::move(*value));
+      ctx->promise.set_value(std::move(values));
+    });
+  }
+  return result;
+}
+
+// Ready as soon as the first input is: holds its index and value, or its
+// exception. The remaining inputs are consumed and ignored.
+template <typename T>
+Future<std::pair<std::size_t, T>> when_any(std::vector<Future<T>> futures) {
+  static_assert(!std::is_void_v<T>, "when_any needs a value type");
+
+  if (futures.empty())
+    throw std::invalid_argument("when_any of no futures");
+
+  struct Context {
+    std::atomic<bool> done{false};
+    Promise<std::pair<std::size_t, T>> promise;
+  };
+
+  auto ctx = std::make_shared<Context>();
+  auto result = ctx->promise.get_future();
+
+  for (std::size_t i = 0; i < futures.size(); ++i) {
+    futures[i].subscribe([ctx, i](detail::Result<T> &&r) {
+      if (ctx->done.exchange(true, std::memory_order_acq_rel))
+        return;
+
+      if (r.index() == 2)
+        ctx->promise.set_exception(std::get<2>(std::move(r)));
+      else
+        ctx->promise.set_value({i, std::get<1>(std::move(r))});
+    });
+  }
+  return result;
+}
+
+} // namespace continuations
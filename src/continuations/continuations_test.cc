@@ -0,0 +1,167 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "continuations/continuations.h"
+
+TEST(continuations_test, then_test) {
+  thread_pool::ThreadPool pool(2);
+  continuations::Promise<int> promise;
+
+  auto fut = promise.get_future()
+                 .then(pool, [](int v) { return v * 2; })
+                 .then(pool, [](int v) { return std::to_string(v); })
+                 .then([](std::string s) { return s + "!"; });
+
+  EXPECT_FALSE(fut.is_ready());
+  promise.set_value(21);
+  EXPECT_EQ(fut.get(), "42!");
+}
+
+TEST(continuations_test, void_test) {
+  thread_pool::ThreadPool pool(2);
+  continuations::Promise<void> promise;
+  int calls = 0;
+
+  auto fut = promise.get_future()
+                 .then(pool, [&] { ++calls; })
+                 .then(pool, [&] { return ++calls; });
+
+  promise.set_value();
+  EXPECT_EQ(fut.get(), 2);
+}
+
+TEST(continuations_test, exception_test) {
+  thread_pool::ThreadPool pool(2);
+  continuations::Promise<int> promise;
+  bool skipped = true;
+
+  auto fut = promise.get_future()
+                 .then(pool, [](int) -> int { throw std::runtime_error("step 1"); })
+                 .then(pool, [&](int v) { skipped = false; return v; });
+
+  promise.set_value(1);
+  EXPECT_THROW(fut.get(), std::runtime_error);
+  EXPECT_TRUE(skipped);
+
+  continuations::Future<int> broken;
+  {
+    continuations::Promise<int> abandoned;
+    broken = abandoned.get_future().then([](int v) { return v; });
+  }
+  EXPECT_THROW(broken.get(), std::future_error);
+}
+
+TEST(continuations_test, ready_fast_path_test) {
+  // Every step runs inline on a ready value and yields a ready future.
+  auto fut = continuations::make_ready_future(1)
+                 .then([](int v) { return v + 1; })
+                 .then([](int v) { return v * 10; });
+
+  EXPECT_TRUE(fut.is_ready());
+  EXPECT_EQ(fut.get(), 20);
+
+  auto failed = continuations::make_exceptional_future<int>(
+                    std::make_exception_ptr(std::logic_error("bad")))
+                    .then([](int v) { return v; });
+  EXPECT_TRUE(failed.is_ready());
+  EXPECT_THROW(failed.get(), std::logic_error);
+}
+
+TEST(continuations_test, when_all_test) {
+  thread_pool::ThreadPool pool(4);
+  std::vector<continuations::Promise<int>> promises(5);
+  std::vector<continuations::Future<int>> futures;
+  for (auto &promise : promises)
+    futures.push_back(promise.get_future().then(pool, [](int v) { return v * v; }));
+
+  auto all = continuations::when_all(std::move(futures));
+  for (int i = 4; i >= 0; --i)
+    promises[i].set_value(i);
+
+  EXPECT_EQ(all.get(), (std::vector<int>{0, 1, 4, 9, 16}));
+
+  std::vector<continuations::Future<int>> with_error;
+  with_error.push_back(continuations::make_ready_future(1));
+  with_error.push_back(continuations::make_exceptional_future<int>(
+      std::make_exception_ptr(std::runtime_error("failed"))));
+  EXPECT_THROW(continuations::when_all(std::move(with_error)).get(),
+               std::runtime_error);
+}
+
+TEST(continuations_test, when_any_test) {
+  std::vector<continuations::Promise<std::string>> promises(3);
+  std::vector<continuations::Future<std::string>> futures;
+  for (auto &promise : promises)
+    futures.push_back(promise.get_future());
+
+  auto any = continuations::when_any(std::move(futures));
+  EXPECT_FALSE(any.is_ready());
+
+  std::thread t([&] { promises[1].set_value("second"); });
+  auto [index, value] = any.get();
+  t.join();
+
+  EXPECT_EQ(index, 1u);
+  EXPECT_EQ(value, "second");
+
+  // Completing the others afterwards is harmless.
+  promises[0].set_value("first");
+  promises[2].set_value("third");
+}
+
+namespace {
+
+constexpr int chain_length = 2000;
+
+int step(int v) { return v + 1; }
+
+} // namespace
+
+TEST(continuations_test, benchmark) {
+  thread_pool::ThreadPool pool;
+
+  {
+    auto sta = std::chrono::steady_clock::now();
+    int v = 0;
+    for (int i = 0; i < chain_length; ++i)
+      v = thread_pool::async_on(pool, step, v).get();
+    std::chrono::duration<double, std::micro> dur = std::chrono::steady_clock::now() - sta;
+
+    EXPECT_EQ(v, chain_length);
+    std::cout << "blocking get() chain: " << dur.count() / chain_length
+              << " us per step." << std::endl;
+  }
+
+  {
+    auto sta = std::chrono::steady_clock::now();
+    continuations::Promise<int> promise;
+    auto fut = promise.get_future();
+    for (int i = 0; i < chain_length; ++i)
+      fut = fut.then(pool, step);
+    promise.set_value(0);
+    int v = fut.get();
+    std::chrono::duration<double, std::micro> dur = std::chrono::steady_clock::now() - sta;
+
+    EXPECT_EQ(v, chain_length);
+    std::cout << "then() chain on the pool: " << dur.count() / chain_length
+              << " us per step." << std::endl;
+  }
+
+  {
+    auto sta = std::chrono::steady_clock::now();
+    auto fut = continuations::make_ready_future(0);
+    for (int i = 0; i < chain_length; ++i)
+      fut = fut.then(step);
+    int v = fut.get();
+    std::chrono::duration<double, std::micro> dur = std::chrono::steady_clock::now() - sta;
+
+    EXPECT_EQ(v, chain_length);
+    std::cout << "then() chain on ready values: " << dur.count() / chain_length
+              << " us per step." << std::endl;
+  }
+}
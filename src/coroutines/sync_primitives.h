@@ -0,0 +1,296 @@
+#pragma once
+
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <utility>
+
+#include "thread_pool/thread_pool.h"
+
+namespace coro {
+
+// Coroutine-aware counterparts of std::mutex, std::counting_semaphore and a
+// manual-reset event. Waiting suspends only the awaiting coroutine; the pool
+// thread that ran it goes on with other work. Waiters are resumed on the
+// pool given to the constructor, or inline on the thread that released them
+// when there is none.
+
+namespace detail {
+
+// Inline too once the pool is shut down: the waiter may already own the
+// lock, and dropping it would leave the lock held for good.
+inline void resume_on(thread_pool::ThreadPool *pool, std::coroutine_handle<> h) {
+  if (pool == nullptr || !pool->execute([h] { h.resume(); }))
+    h.resume();
+}
+
+} // namespace detail
+
+class AsyncMutex;
+
+// Unlocks on destruction, like std::lock_guard.
+class AsyncLockGuard {
+public:
+  explicit AsyncLockGuard(AsyncMutex &m) noexcept : mutex(&m) {}
+  AsyncLockGuard(AsyncLockGuard &&other) noexcept
+    : mutex(std::exchange(other.mutex, nullptr))
+  {}
+  AsyncLockGuard &operator=(AsyncLockGuard &&) = delete;
+  ~AsyncLockGuard();
+
+private:
+  AsyncMutex *mutex;
+};
+
+// The whole lock is one atomic pointer:
+//   this        unlocked
+//   nullptr     locked, nobody waiting
+//   Waiter *    locked; a LIFO stack of coroutines that started waiting
+// Locking an unlocked mutex is a single CAS and does not suspend. Waiters
+// live inside their own awaiter (in the coroutine frame), so waiting does
+// not allocate. unlock() moves new waiters from the atomic stack into a FIFO
+// list owned by the lock holder and hands the lock straight to the first of
+// them.
+class AsyncMutex {
+  struct Waiter {
+    AsyncMutex &mutex;
+    std::coroutine_handle<> handle;
+    Waiter *next = nullptr;
+
+    bool await_ready() noexcept { return mutex.try_lock(); }
+
+    bool await_suspend(std::coroutine_handle<> h) noexcept {
+      handle = h;
+      void *old = mutex.state.load(std::memory_order_relaxed);
+      for (;;) {
+        if (old == mutex.unlocked()) {
+          if (mutex.state.compare_exchange_weak(old, nullptr,
+                                                std::memory_order_acquire,
+                                                std::memory_order_relaxed))
+            return false;
+        } else {
+          next = static_cast<Waiter *>(old);
+          if (mutex.state.compare_exchange_weak(old, this,
+                                                std::memory_order_release,
+                                                std::memory_order_relaxed))
+            return true;
+        }
+      }
+    }
+  };
+
+public:
+  explicit AsyncMutex(thread_pool::ThreadPool *resume_on = nullptr) noexcept
+    : state(unlocked()), pool(resume_on)
+  {}
+
+  AsyncMutex(const AsyncMutex &) = delete;
+  AsyncMutex &operator=(const AsyncMutex &) = delete;
+
+  bool try_lock() noexcept {
+    void *expected = unlocked();
+    return state.compare_exchange_strong(expected, nullptr,
+                                         std::memory_order_acquire,
+                                         std::memory_order_relaxed);
+  }
+
+  // co_await mutex.lock(); ... mutex.unlock();
+  auto lock() noexcept {
+    struct Awaiter : Waiter {
+      void await_resume() const noexcept {}
+    };
+    return Awaiter{{*this, nullptr}};
+  }
+
+  // auto guard = co_await mutex.scoped_lock();
+  auto scoped_lock() noexcept {
+    struct Awaiter : Waiter {
+      [[nodiscard]] AsyncLockGuard await_resume() const noexcept {
+        return AsyncLockGuard(this->mutex);
+      }
+    };
+    return Awaiter{{*this, nullptr}};
+  }
+
+  void unlock() {
+    Waiter *head = waiters;
+    if (head == nullptr) {
+      void *expected = nullptr;
+      if (state.compare_exchange_strong(expected, unlocked(),
+                                        std::memory_order_release,
+                                        std::memory_order_relaxed))
+        return;
+
+      // Take the stack of new waiters and reverse it into FIFO order.
+      auto *w = static_cast<Waiter *>(state.exchange(nullptr, std::memory_order_acquire));
+      while (w != nullptr) {
+        Waiter *next = w->next;
+        w->next = head;
+        head = w;
+        w = next;
+      }
+    }
+
+    // The lock passes directly to the first waiter.
+    waiters = head->next;
+    detail::resume_on(pool, head->handle);
+  }
+
+private:
+  void *unlocked() noexcept { return this; }
+
+  std::atomic<void *> state;
+  Waiter *waiters = nullptr;
+  thread_pool::ThreadPool *pool;
+};
+
+inline AsyncLockGuard::~AsyncLockGuard() {
+  if (mutex)
+    mutex->unlock();
+}
+
+// Counting semaphore. `count` goes negative by the number of coroutines that
+// are (about to be) suspended, so acquire() and release() are a single
+// atomic add when nobody has to wait. Only the slow path takes the internal
+// mutex. A release() that finds the queue still empty -- the waiter
+// decremented the count but has not queued itself yet -- leaves a wake-up
+// token that the waiter consumes instead of suspending.
+class AsyncSemaphore {
+public:
+  explicit AsyncSemaphore(std::ptrdiff_t initial,
+                          thread_pool::ThreadPool *resume_on = nullptr)
+    : count(initial), pool(resume_on)
+  {}
+
+  AsyncSemaphore(const AsyncSemaphore &) = delete;
+  AsyncSemaphore &operator=(const AsyncSemaphore &) = delete;
+
+  bool try_acquire() noexcept {
+    auto c = count.load(std::memory_order_relaxed);
+    while (c > 0) {
+      if (count.compare_exchange_weak(c, c - 1, std::memory_order_acquire,
+                                      std::memory_order_relaxed))
+        return true;
+    }
+    return false;
+  }
+
+  auto acquire() noexcept {
+    struct Awaiter {
+      AsyncSemaphore &sem;
+
+      bool await_ready() noexcept {
+        return sem.count.fetch_sub(1, std::memory_order_acquire) > 0;
+      }
+
+      bool await_suspend(std::coroutine_handle<> h) {
+        std::lock_guard<std::mutex> lk(sem.mut);
+        if (sem.pending_wakeups > 0) {
+          --sem.pending_wakeups;
+          return false;
+        }
+        sem.waiters.push_back(h);
+        return true;
+      }
+
+      void await_resume() const noexcept {}
+    };
+    return Awaiter{*this};
+  }
+
+  void release() {
+    if (count.fetch_add(1, std::memory_order_release) >= 0)
+      return;
+
+    std::coroutine_handle<> next;
+    {
+      std::lock_guard<std::mutex> lk(mut);
+      if (waiters.empty()) {
+        ++pending_wakeups;
+        return;
+      }
+      next = waiters.front();
+      waiters.pop_front();
+    }
+    detail::resume_on(pool, next);
+  }
+
+private:
+  std::atomic<std::ptrdiff_t> count;
+  std::mutex mut;
+  std::deque<std::coroutine_handle<>> waiters;
+  std::size_t pending_wakeups = 0;
+  thread_pool::ThreadPool *pool;
+};
+
+// Manual-reset event. One atomic pointer: `this` when set, otherwise a
+// lock-free stack of waiting coroutines (nullptr if none). Awaiting a set
+// event does not suspend; set() releases every waiter.
+class AsyncEvent {
+  struct Waiter {
+    AsyncEvent &event;
+    std::coroutine_handle<> handle;
+    Waiter *next = nullptr;
+
+    bool await_ready() const noexcept { return event.is_set(); }
+
+    bool await_suspend(std::coroutine_handle<> h) noexcept {
+      handle = h;
+      void *old = event.state.load(std::memory_order_acquire);
+      do {
+        if (old == event.set_state())
+          return false;
+        next = static_cast<Waiter *>(old);
+      } while (!event.state.compare_exchange_weak(old, this,
+                                                  std::memory_order_release,
+                                                  std::memory_order_acquire));
+      return true;
+    }
+
+    void await_resume() const noexcept {}
+  };
+
+public:
+  explicit AsyncEvent(bool initially_set = false,
+                      thread_pool::ThreadPool *resume_on = nullptr) noexcept
+    : state(initially_set ? set_state() : nullptr), pool(resume_on)
+  {}
+
+  AsyncEvent(const AsyncEvent &) = delete;
+  AsyncEvent &operator=(const AsyncEvent &) = delete;
+
+  [[nodiscard]] bool is_set() const noexcept {
+    return state.load(std::memory_order_acquire) == set_state();
+  }
+
+  Waiter wait() noexcept { return Waiter{*this, nullptr}; }
+
+  void set() {
+    void *old = state.exchange(set_state(), std::memory_order_acq_rel);
+    if (old == set_state())
+      return;
+
+    auto *w = static_cast<Waiter *>(old);
+    while (w != nullptr) {
+      // Read next first: resuming the waiter may destroy it.
+      Waiter *next = w->next;
+      detail::resume_on(pool, w->handle);
+      w = next;
+    }
+  }
+
+  void reset() noexcept {
+    void *expected = set_state();
+    state.compare_exchange_strong(expected, nullptr, std::memory_order_relaxed);
+  }
+
+private:
+  void *set_state() const noexcept { return const_cast<AsyncEvent *>(this); }
+
+  std::atomic<void *> state;
+  thread_pool::ThreadPool *pool;
+};
+
+} // namespace coro
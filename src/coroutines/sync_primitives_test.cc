@@ -0,0 +1,208 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "coroutines/sync_primitives.h"
+#include "coroutines/task.h"
+
+namespace {
+
+// Every coroutine hops to the pool inside the critical section, so an unsafe
+// lock shows up as a lost update of the non-atomic counter.
+coro::Task<void> increment(thread_pool::ThreadPool &pool, coro::AsyncMutex &mutex,
+                           long &counter, int times) {
+  co_await pool.schedule();
+  for (int i = 0; i < times; ++i) {
+    auto guard = co_await mutex.scoped_lock();
+    long v = counter;
+    co_await pool.schedule();
+    counter = v + 1;
+  }
+}
+
+coro::Task<void> limited(thread_pool::ThreadPool &pool, coro::AsyncSemaphore &sem,
+                         std::atomic<int> &inside, std::atomic<int> &peak) {
+  co_await pool.schedule();
+  co_await sem.acquire();
+  int now = inside.fetch_add(1) + 1;
+  int seen = peak.load();
+  while (now > seen && !peak.compare_exchange_weak(seen, now)) {}
+  co_await pool.schedule();
+  inside.fetch_sub(1);
+  sem.release();
+}
+
+coro::Task<void> locked_increment(coro::AsyncMutex &mutex, long &counter) {
+  auto guard = co_await mutex.scoped_lock();
+  ++counter;
+}
+
+coro::Task<int> wait_for(coro::AsyncEvent &event, const int &value) {
+  co_await event.wait();
+  co_return value;
+}
+
+} // namespace
+
+TEST(coroutine_sync_test, mutex_test) {
+  thread_pool::ThreadPool pool(4);
+  coro::AsyncMutex mutex(&pool);
+
+  EXPECT_TRUE(mutex.try_lock());
+  EXPECT_FALSE(mutex.try_lock());
+  mutex.unlock();
+
+  long counter = 0;
+  std::vector<coro::Task<void>> tasks;
+  for (int i = 0; i < 100; ++i)
+    tasks.push_back(increment(pool, mutex, counter, 100));
+  coro::sync_wait(coro::when_all(std::move(tasks)));
+
+  EXPECT_EQ(counter, 100 * 100);
+  EXPECT_TRUE(mutex.try_lock());
+  mutex.unlock();
+}
+
+TEST(coroutine_sync_test, shut_down_pool_test) {
+  // unlock() cannot hand the lock over through a pool that has been shut
+  // down, so each waiter is resumed inline instead.
+  using namespace std::chrono_literals;
+  thread_pool::ThreadPool pool(1);
+  pool.shutdown();
+  coro::AsyncMutex mutex(&pool);
+  ASSERT_TRUE(mutex.try_lock());
+
+  long counter = 0;
+  std::vector<coro::Task<void>> tasks;
+  for (int i = 0; i < 10; ++i)
+    tasks.push_back(locked_increment(mutex, counter));
+  std::jthread unlocker([&mutex] {
+    std::this_thread::sleep_for(10ms);
+    mutex.unlock();
+  });
+  coro::sync_wait(coro::when_all(std::move(tasks)));
+
+  EXPECT_EQ(counter, 10);
+  EXPECT_TRUE(mutex.try_lock());
+  mutex.unlock();
+}
+
+TEST(coroutine_sync_test, semaphore_test) {
+  thread_pool::ThreadPool pool(4);
+  coro::AsyncSemaphore sem(3, &pool);
+  std::atomic<int> inside{0}, peak{0};
+
+  std::vector<coro::Task<void>> tasks;
+  for (int i = 0; i < 200; ++i)
+    tasks.push_back(limited(pool, sem, inside, peak));
+  coro::sync_wait(coro::when_all(std::move(tasks)));
+
+  EXPECT_EQ(inside.load(), 0);
+  EXPECT_LE(peak.load(), 3);
+  EXPECT_GE(peak.load(), 1);
+
+  // All three permits are back.
+  EXPECT_TRUE(sem.try_acquire());
+  EXPECT_TRUE(sem.try_acquire());
+  EXPECT_TRUE(sem.try_acquire());
+  EXPECT_FALSE(sem.try_acquire());
+}
+
+TEST(coroutine_sync_test, event_test) {
+  thread_pool::ThreadPool pool(2);
+  coro::AsyncEvent event(false, &pool);
+  int value = 0;
+
+  std::vector<coro::Task<int>> waiters;
+  for (int i = 0; i < 10; ++i)
+    waiters.push_back(wait_for(event, value));
+
+  // The setter publishes `value` before set(); every waiter must see it.
+  EXPECT_TRUE(pool.execute([&] {
+    value = 7;
+    event.set();
+  }));
+  auto results = coro::sync_wait(coro::when_all(std::move(waiters)));
+  for (int v : results)
+    EXPECT_EQ(v, 7);
+
+  EXPECT_TRUE(event.is_set());
+  EXPECT_EQ(coro::sync_wait(wait_for(event, value)), 7);
+
+  event.reset();
+  EXPECT_FALSE(event.is_set());
+}
+
+namespace {
+
+constexpr int coroutines = 1000;
+constexpr int entries = 100;
+
+coro::Task<void> through_async_mutex(thread_pool::ThreadPool &pool,
+                                     coro::AsyncMutex &mutex, long &counter) {
+  for (int i = 0; i < entries; ++i) {
+    co_await pool.schedule();
+    co_await mutex.lock();
+    ++counter;
+    mutex.unlock();
+  }
+}
+
+coro::Task<void> through_std_mutex(thread_pool::ThreadPool &pool, std::mutex &mutex,
+                                   long &counter) {
+  for (int i = 0; i < entries; ++i) {
+    co_await pool.schedule();
+    std::lock_guard<std::mutex> lk(mutex);
+    ++counter;
+  }
+}
+
+// The section itself suspends (as it would around I/O); a std::mutex cannot
+// be held across that.
+coro::Task<void> suspending_section(thread_pool::ThreadPool &pool,
+                                    coro::AsyncMutex &mutex, long &counter) {
+  for (int i = 0; i < entries; ++i) {
+    co_await pool.schedule();
+    auto guard = co_await mutex.scoped_lock();
+    co_await pool.schedule();
+    ++counter;
+  }
+}
+
+template <typename Make>
+void run(const char *name, thread_pool::ThreadPool &pool, Make make) {
+  long counter = 0;
+  std::vector<coro::Task<void>> tasks;
+  for (int i = 0; i < coroutines; ++i)
+    tasks.push_back(make(counter));
+
+  auto sta = std::chrono::steady_clock::now();
+  coro::sync_wait(coro::when_all(std::move(tasks)));
+  std::chrono::duration<double> dur = std::chrono::steady_clock::now() - sta;
+
+  EXPECT_EQ(counter, static_cast<long>(coroutines) * entries);
+  std::cout << name << " on " << pool.size() << " threads: " << dur.count() * 1000
+            << " ms, " << counter / dur.count() << " entries/s." << std::endl;
+}
+
+} // namespace
+
+TEST(coroutine_sync_test, benchmark) {
+  thread_pool::ThreadPool pool;
+
+  std::mutex std_mutex;
+  run("std::mutex", pool,
+      [&](long &counter) { return through_std_mutex(pool, std_mutex, counter); });
+
+  coro::AsyncMutex async_mutex(&pool);
+  run("AsyncMutex", pool,
+      [&](long &counter) { return through_async_mutex(pool, async_mutex, counter); });
+
+  coro::AsyncMutex held_mutex(&pool);
+  run("AsyncMutex, suspending inside", pool,
+      [&](long &counter) { return suspending_section(pool, held_mutex, counter); });
+}
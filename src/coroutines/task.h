@@ -0,0 +1,296 @@
+#pragma once
+
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <latch>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "thread_pool/thread_pool.h"
+
+namespace coro {
+
+// Lazily started coroutine task.
+//
+//   coro::Task<int> answer(thread_pool::ThreadPool &pool) {
+//     co_await pool.schedule();   // continue on a pool thread
+//     co_return 42;
+//   }
+//
+//   int v = coro::sync_wait(answer(pool));
+//
+// A Task does not run until it is awaited. Awaiting it records the awaiting
+// coroutine as its continuation and transfers control to the task; when the
+// task finishes, its final awaiter transfers control straight back to the
+// continuation. Both hand-offs return a coroutine_handle from await_suspend
+// (symmetric transfer), so long chains of tasks that complete synchronously
+// do not grow the stack.
+//
+// A suspended task holds no thread, only its coroutine frame, which is what
+// lets thousands of operations be in flight on a handful of pool threads.
+
+template <typename T = void>
+class Task;
+
+namespace detail {
+
+class TaskPromiseBase {
+public:
+  std::suspend_always initial_suspend() noexcept { return {}; }
+
+  struct FinalAwaiter {
+    bool await_ready() const noexcept { return false; }
+
+    template <typename Promise>
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> h) noexcept {
+      return h.promise().continuation;
+    }
+
+    void await_resume() const noexcept {}
+  };
+
+  FinalAwaiter final_suspend() noexcept { return {}; }
+
+  void unhandled_exception() noexcept { error = std::current_exception(); }
+
+  void set_continuation(std::coroutine_handle<> h) noexcept { continuation = h; }
+
+protected:
+  void rethrow_if_failed() {
+    if (error)
+      std::rethrow_exception(error);
+  }
+
+private:
+  std::coroutine_handle<> continuation = std::noop_coroutine();
+  std::exception_ptr error;
+};
+
+template <typename T>
+class TaskPromise : public TaskPromiseBase {
+public:
+  Task<T> get_return_object() noexcept;
+
+  template <typename U>
+  void return_value(U &&v) { value.emplace(std::forward<U>(v)); }
+
+  T take() {
+    rethrow_if_failed();
+    return std::move(*value);
+  }
+
+private:
+  std::optional<T> value;
+};
+
+template <>
+class TaskPromise<void> : public TaskPromiseBase {
+public:
+  Task<void> get_return_object() noexcept;
+
+  void return_void() noexcept {}
+
+  void take() { rethrow_if_failed(); }
+};
+
+} // namespace detail
+
+template <typename T>
+class [[nodiscard]] Task {
+public:
+  using promise_type = detail::TaskPromise<T>;
+  using handle_type = std::coroutine_handle<promise_type>;
+
+  Task() = default;
+  explicit Task(handle_type h) : handle(h) {}
+
+  Task(Task &&other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+  Task &operator=(Task &&other) noexcept {
+    if (this != &other) {
+      if (handle)
+        handle.destroy();
+      handle = std::exchange(other.handle, nullptr);
+    }
+    return *this;
+  }
+
+  ~Task() {
+    if (handle)
+      handle.destroy();
+  }
+
+  [[nodiscard]] bool is_ready() const { return !handle || handle.done(); }
+
+  // Runs the task to completion and yields its result (or rethrows).
+  auto operator co_await() noexcept {
+    struct Awaiter : ReadyAwaiter {
+      T await_resume() { return this->task.promise().take(); }
+    };
+    return Awaiter{{handle}};
+  }
+
+  // Runs the task to completion without taking its result.
+  auto when_ready() noexcept { return ReadyAwaiter{handle}; }
+
+  // Result of a finished task.
+  T take() { return handle.promise().take(); }
+
+private:
+  struct ReadyAwaiter {
+    handle_type task;
+
+    bool await_ready() const noexcept { return !task || task.done(); }
+
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+      task.promise().set_continuation(awaiting);
+      return task;
+    }
+
+    void await_resume() const noexcept {}
+  };
+
+  handle_type handle = nullptr;
+};
+
+namespace detail {
+
+template <typename T>
+Task<T> TaskPromise<T>::get_return_object() noexcept {
+  return Task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+}
+
+inline Task<void> TaskPromise<void>::get_return_object() noexcept {
+  return Task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+}
+
+// Helper coroutine that awaits a task once start()ed and then fires a
+// callback from its final suspend point. sync_wait() and when_all() use it to
+// get from the coroutine world back to a latch or a counter.
+class Starter {
+public:
+  struct promise_type {
+    void (*on_done)(void *) = nullptr;
+    void *context = nullptr;
+
+    Starter get_return_object() noexcept {
+      return Starter(std::coroutine_handle<promise_type>::from_promise(*this));
+    }
+
+    std::suspend_always initial_suspend() noexcept { return {}; }
+
+    struct FinalAwaiter {
+      bool await_ready() const noexcept { return false; }
+      void await_suspend(std::coroutine_handle<promise_type> h) noexcept {
+        auto &p = h.promise();
+        p.on_done(p.context);
+      }
+      void await_resume() const noexcept {}
+    };
+
+    FinalAwaiter final_suspend() noexcept { return {}; }
+
+    void return_void() noexcept {}
+    void unhandled_exception() noexcept { std::terminate(); }
+  };
+
+  explicit Starter(std::coroutine_handle<promise_type> h) : handle(h) {}
+  Starter(Starter &&other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+  ~Starter() {
+    if (handle)
+      handle.destroy();
+  }
+
+  void start(void (*on_done)(void *), void *context) {
+    handle.promise().on_done = on_done;
+    handle.promise().context = context;
+    handle.resume();
+  }
+
+private:
+  std::coroutine_handle<promise_type> handle;
+};
+
+// The task's own result (or exception) stays in its promise.
+template <typename T>
+Starter run_to_completion(Task<T> &task) {
+  co_await task.when_ready();
+}
+
+struct WhenAllCounter {
+  explicit WhenAllCounter(std::size_t n) : remaining(n + 1) {}
+
+  // One count per child plus one for the awaiting coroutine, so that the
+  // last child cannot resume it before it has actually suspended.
+  std::atomic<std::size_t> remaining;
+  std::coroutine_handle<> parent;
+
+  static void child_done(void *context) {
+    auto *self = static_cast<WhenAllCounter *>(context);
+    if (self->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+      self->parent.resume();
+  }
+};
+
+template <typename T>
+struct WhenAllAwaiter {
+  std::vector<Task<T>> &tasks;
+  std::vector<Starter> &starters;
+  WhenAllCounter &counter;
+
+  bool await_ready() const noexcept { return tasks.empty(); }
+
+  bool await_suspend(std::coroutine_handle<> parent) {
+    counter.parent = parent;
+    for (auto &task : tasks)
+      starters.push_back(run_to_completion(task));
+    for (auto &starter : starters)
+      starter.start(&WhenAllCounter::child_done, &counter);
+    return counter.remaining.fetch_sub(1, std::memory_order_acq_rel) != 1;
+  }
+
+  void await_resume() const noexcept {}
+};
+
+} // namespace detail
+
+// Blocks the calling thread until `task` has finished and returns its result.
+template <typename T>
+T sync_wait(Task<T> task) {
+  std::latch done{1};
+  auto starter = detail::run_to_completion(task);
+  starter.start([](void *latch) { static_cast<std::latch *>(latch)->count_down(); },
+                &done);
+  done.wait();
+  return task.take();
+}
+
+// Starts every task at once and completes when all of them have. The
+// results keep the input order; the first failed task (in input order)
+// rethrows its exception.
+template <typename T>
+Task<std::conditional_t<std::is_void_v<T>, void, std::vector<T>>>
+when_all(std::vector<Task<T>> tasks) {
+  detail::WhenAllCounter counter(tasks.size());
+  std::vector<detail::Starter> starters;
+  starters.reserve(tasks.size());
+
+  co_await detail::WhenAllAwaiter<T>{tasks, starters, counter};
+
+  if constexpr (std::is_void_v<T>) {
+    for (auto &task : tasks)
+      task.take();
+  } else {
+    std::vector<T> results;
+    results.reserve(tasks.size());
+    for (auto &task : tasks)
+      results.push_back(task.take());
+    co_return results;
+  }
+}
+
+} // namespace coro
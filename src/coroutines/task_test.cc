@@ -0,0 +1,221 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <barrier>
+#include <chrono>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "coroutines/task.h"
+
+namespace {
+
+coro::Task<int> answer() { co_return 42; }
+
+coro::Task<int> add_on_pool(thread_pool::ThreadPool &pool, int a, int b) {
+  co_await pool.schedule();
+  co_return a + b;
+}
+
+coro::Task<std::string> nested(thread_pool::ThreadPool &pool) {
+  int a = co_await answer();
+  int b = co_await add_on_pool(pool, a, 1);
+  co_return std::to_string(b);
+}
+
+coro::Task<void> fail(thread_pool::ThreadPool &pool) {
+  co_await pool.schedule();
+  throw std::runtime_error("failed on the pool");
+}
+
+coro::Task<int> deep(int n) {
+  if (n == 0)
+    co_return 0;
+  co_return 1 + co_await deep(n - 1);
+}
+
+} // namespace
+
+TEST(coroutine_task_test, basic_test) {
+  thread_pool::ThreadPool pool(2);
+
+  EXPECT_EQ(coro::sync_wait(answer()), 42);
+  EXPECT_EQ(coro::sync_wait(add_on_pool(pool, 20, 11)), 31);
+  EXPECT_EQ(coro::sync_wait(nested(pool)), "43");
+  EXPECT_THROW(coro::sync_wait(fail(pool)), std::runtime_error);
+}
+
+TEST(coroutine_task_test, runs_on_pool_test) {
+  thread_pool::ThreadPool pool(1);
+
+  auto where = [](thread_pool::ThreadPool &p) -> coro::Task<std::thread::id> {
+    co_await p.schedule();
+    co_return std::this_thread::get_id();
+  };
+
+  EXPECT_NE(coro::sync_wait(where(pool)), std::this_thread::get_id());
+}
+
+TEST(coroutine_task_test, shut_down_pool_test) {
+  // The pool rejects the hop, so the coroutine carries on where it is.
+  thread_pool::ThreadPool pool(1);
+  pool.shutdown();
+
+  EXPECT_EQ(coro::sync_wait(add_on_pool(pool, 20, 11)), 31);
+}
+
+TEST(coroutine_task_test, symmetric_transfer_test) {
+  // A long chain of tasks that all complete synchronously. The hand-offs are
+  // tail calls only when optimizing, so keep the depth modest for -O0 builds.
+  EXPECT_EQ(coro::sync_wait(deep(10000)), 10000);
+}
+
+TEST(coroutine_task_test, when_all_test) {
+  thread_pool::ThreadPool pool(4);
+
+  std::vector<coro::Task<int>> tasks;
+  for (int i = 0; i < 1000; ++i)
+    tasks.push_back(add_on_pool(pool, i, i));
+
+  auto results = coro::sync_wait(coro::when_all(std::move(tasks)));
+  ASSERT_EQ(results.size(), 1000u);
+  for (int i = 0; i < 1000; ++i)
+    EXPECT_EQ(results[i], 2 * i);
+
+  std::vector<coro::Task<void>> failing;
+  failing.push_back(fail(pool));
+  failing.push_back(fail(pool));
+  EXPECT_THROW(coro::sync_wait(coro::when_all(std::move(failing))),
+               std::runtime_error);
+
+  EXPECT_TRUE(coro::sync_wait(coro::when_all(std::vector<coro::Task<int>>{})).empty());
+}
+
+namespace {
+
+// VmRSS and VmSize of this process in kB.
+std::pair<long, long> memory_kb() {
+  std::ifstream status("/proc/self/status");
+  std::string key;
+  long rss = 0, size = 0;
+  while (status >> key) {
+    if (key == "VmRSS:")
+      status >> rss;
+    else if (key == "VmSize:")
+      status >> size;
+  }
+  return {rss, size};
+}
+
+constexpr int in_flight = 1000;
+
+long long work(int i) {
+  long long sum = 0;
+  for (int k = 0; k < 1000; ++k)
+    sum += (i + k) % 7;
+  return sum;
+}
+
+// Coroutine counterpart of std::barrier: suspends until `count` coroutines
+// arrived, records the memory use with all of them in flight, then resumes
+// them on the pool.
+class Gate {
+public:
+  Gate(thread_pool::ThreadPool &pool, int count) : pool(pool), count(count) {}
+
+  auto arrive() {
+    struct Awaiter {
+      Gate &gate;
+      bool await_ready() const noexcept { return false; }
+      void await_suspend(std::coroutine_handle<> h) {
+        std::vector<std::coroutine_handle<>> release;
+        {
+          std::lock_guard<std::mutex> lk(gate.mut);
+          gate.waiting.push_back(h);
+          if (static_cast<int>(gate.waiting.size()) < gate.count)
+            return;
+          gate.peak = memory_kb();
+          release.swap(gate.waiting);
+        }
+        for (auto waiter : release)
+          EXPECT_TRUE(gate.pool.execute([waiter] { waiter.resume(); }));
+      }
+      void await_resume() const noexcept {}
+    };
+    return Awaiter{*this};
+  }
+
+  std::pair<long, long> peak;
+
+private:
+  thread_pool::ThreadPool &pool;
+  int count;
+  std::mutex mut;
+  std::vector<std::coroutine_handle<>> waiting;
+};
+
+coro::Task<long long> operation(thread_pool::ThreadPool &pool, Gate &gate, int i) {
+  co_await pool.schedule();
+  co_await gate.arrive();
+  co_return work(i);
+}
+
+} // namespace
+
+TEST(coroutine_task_test, benchmark) {
+  long long expected = 0;
+  for (int i = 0; i < in_flight; ++i)
+    expected += work(i);
+
+  {
+    auto base = memory_kb();
+    std::pair<long, long> peak;
+    std::barrier sync(in_flight, [&]() noexcept { peak = memory_kb(); });
+
+    auto sta = std::chrono::steady_clock::now();
+    std::vector<std::future<long long>> futures;
+    for (int i = 0; i < in_flight; ++i) {
+      futures.push_back(std::async(std::launch::async, [&sync, i] {
+        sync.arrive_and_wait();
+        return work(i);
+      }));
+    }
+    long long sum = 0;
+    for (auto &fut : futures)
+      sum += fut.get();
+    std::chrono::duration<double, std::milli> dur = std::chrono::steady_clock::now() - sta;
+
+    EXPECT_EQ(sum, expected);
+    std::cout << in_flight << " ops with std::async: " << dur.count()
+              << " ms, in flight +" << peak.first - base.first << " kB RSS, +"
+              << peak.second - base.second << " kB virtual." << std::endl;
+  }
+
+  {
+    thread_pool::ThreadPool pool;
+    Gate gate(pool, in_flight);
+    auto base = memory_kb();
+
+    auto sta = std::chrono::steady_clock::now();
+    std::vector<coro::Task<long long>> tasks;
+    for (int i = 0; i < in_flight; ++i)
+      tasks.push_back(operation(pool, gate, i));
+    auto results = coro::sync_wait(coro::when_all(std::move(tasks)));
+    std::chrono::duration<double, std::milli> dur = std::chrono::steady_clock::now() - sta;
+
+    long long sum = 0;
+    for (auto v : results)
+      sum += v;
+
+    EXPECT_EQ(sum, expected);
+    std::cout << in_flight << " ops as coroutines on " << pool.size()
+              << " threads: " << dur.count() << " ms, in flight +"
+              << gate.peak.first - base.first << " kB RSS, +"
+              << gate.peak.second - base.second << " kB virtual." << std::endl;
+  }
+}
@@ -3,6 +3,8 @@
 #include <future>
 #include <algorithm>
 
+#include "thread_pool/thread_pool.h"
+
 namespace get_return_value {
 
 std::mutex mylock;
@@ -39,7 +41,7 @@ TEST(return_value_multithread, test)
   {
     int s = i * 5;
     int e = s + 5;
-    auto fut = std::async(std::launch::async, get_return_value::calculate_all, nullptr, Container{s, e});
+    auto fut = thread_pool::async_on(thread_pool::global_pool(), get_return_value::calculate_all, nullptr, Container{s, e});
     futures.emplace_back(std::move(fut));
   }
 
@@ -0,0 +1,243 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <latch>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "topology/topology.h"
+
+// Ping-pong round-trip latency of the wake-up primitives used around the
+// repo: std::condition_variable (conditional_variable.cc), polling an
+// atomic<bool> with sleep_for(5ms) (atomic_test::waiting_for_work),
+// std::promise<void> (synchronisation_with_promise_and_future), std::latch
+// and atomic::wait.
+//
+// Two threads are pinned to a chosen pair of CPUs. The first signals the
+// second, which signals straight back; one round trip is two hand-offs.
+// Each primitive is measured per core pair:
+//   same cpu       both threads share one logical CPU
+//   smt sibling    two hardware threads of one core
+//   same socket    two cores of one package
+//   cross socket   two packages
+// Pairs the machine does not have (or the affinity mask does not allow) are
+// skipped.
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// One-way signal: wait(r) returns once signal(r) has been called.
+// Every primitive gets one for each direction.
+
+class CondVarSignal {
+public:
+  explicit CondVarSignal(int) {}
+
+  void signal(int round) {
+    {
+      std::lock_guard<std::mutex> lck(mut);
+      seq = round + 1;
+    }
+    cond_var.notify_one();
+  }
+
+  void wait(int round) {
+    std::unique_lock<std::mutex> lck(mut);
+    cond_var.wait(lck, [&] { return seq > round; });
+  }
+
+private:
+  std::mutex mut;
+  std::condition_variable cond_var;
+  int seq = 0;
+};
+
+class SleepPollSignal {
+public:
+  explicit SleepPollSignal(int) {}
+
+  void signal(int round) { seq.store(round + 1, std::memory_order_release); }
+
+  void wait(int round) {
+    while (seq.load(std::memory_order_acquire) <= round)
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+
+private:
+  std::atomic<int> seq{0};
+};
+
+// One-shot primitives need a fresh object per round; they are all created
+// up front so construction stays out of the measurement.
+class PromiseSignal {
+public:
+  explicit PromiseSignal(int rounds) : promises(rounds) {
+    for (auto &p : promises)
+      futures.push_back(p.get_future());
+  }
+
+  void signal(int round) { promises[round].set_value(); }
+  void wait(int round) { futures[round].wait(); }
+
+private:
+  std::vector<std::promise<void>> promises;
+  std::vector<std::future<void>> futures;
+};
+
+class LatchSignal {
+public:
+  explicit LatchSignal(int rounds) {
+    for (int i = 0; i < rounds; ++i)
+      latches.emplace_back(1);
+  }
+
+  void signal(int round) { latches[round].count_down(); }
+  void wait(int round) { latches[round].wait(); }
+
+private:
+  std::deque<std::latch> latches;
+};
+
+class AtomicWaitSignal {
+public:
+  explicit AtomicWaitSignal(int) {}
+
+  void signal(int round) {
+    seq.store(round + 1, std::memory_order_release);
+    seq.notify_one();
+  }
+
+  void wait(int round) {
+    int v;
+    while ((v = seq.load(std::memory_order_acquire)) <= round)
+      seq.wait(v, std::memory_order_acquire);
+  }
+
+private:
+  std::atomic<int> seq{0};
+};
+
+struct CorePair {
+  std::string name;
+  int a, b;
+};
+
+// The first allowed pair of each kind.
+std::vector<CorePair> core_pairs() {
+  const auto &cpus = topology::Topology::system().cpus();
+  std::vector<CorePair> pairs;
+  if (cpus.empty())
+    return pairs;
+  pairs.push_back({"same cpu", cpus[0].id, cpus[0].id});
+
+  std::optional<CorePair> smt, socket, cross;
+  for (const auto &x : cpus) {
+    for (const auto &y : cpus) {
+      if (x.id >= y.id)
+        continue;
+      if (x.package != y.package) {
+        if (!cross)
+          cross = CorePair{"cross socket", x.id, y.id};
+      } else if (x.core == y.core) {
+        if (!smt)
+          smt = CorePair{"smt sibling", x.id, y.id};
+      } else if (!socket) {
+        socket = CorePair{"same socket", x.id, y.id};
+      }
+    }
+  }
+  for (auto &p : {smt, socket, cross})
+    if (p)
+      pairs.push_back(*p);
+  return pairs;
+}
+
+// Round-trip times in ns, or nothing if the threads could not be pinned.
+template <typename Signal>
+std::vector<double> ping_pong(const CorePair &pair, int rounds) {
+  constexpr int warmup = 10;
+  int total = rounds + warmup;
+  Signal ping(total), pong(total);
+  std::vector<double> samples;
+  samples.reserve(rounds);
+  std::atomic<bool> pinned{true};
+
+  std::thread peer([&] {
+    if (!topology::pin_current_thread(pair.b))
+      pinned = false;
+    for (int r = 0; r < total; ++r) {
+      ping.wait(r);
+      pong.signal(r);
+    }
+  });
+
+  std::thread self([&] {
+    if (!topology::pin_current_thread(pair.a))
+      pinned = false;
+    for (int r = 0; r < total; ++r) {
+      auto sta = Clock::now();
+      ping.signal(r);
+      pong.wait(r);
+      std::chrono::duration<double, std::nano> dur = Clock::now() - sta;
+      if (r >= warmup)
+        samples.push_back(dur.count());
+    }
+  });
+
+  self.join();
+  peer.join();
+  if (!pinned)
+    samples.clear();
+  return samples;
+}
+
+double percentile(const std::vector<double> &sorted, double p) {
+  auto i = static_cast<std::size_t>(p * static_cast<double>(sorted.size()));
+  return sorted[std::min(i, sorted.size() - 1)];
+}
+
+template <typename Signal>
+void report(const char *name, int rounds) {
+  for (const auto &pair : core_pairs()) {
+    auto samples = ping_pong<Signal>(pair, rounds);
+    if (samples.empty()) {
+      std::cout << std::setw(26) << std::left << name << std::setw(14) << pair.name
+                << "skipped: cannot pin to cpus " << pair.a << "," << pair.b << std::endl;
+      continue;
+    }
+    EXPECT_EQ(samples.size(), static_cast<std::size_t>(rounds));
+
+    std::sort(samples.begin(), samples.end());
+    std::ostringstream line;
+    line << std::setw(26) << std::left << name << std::setw(14) << pair.name << "cpus "
+         << pair.a << "," << pair.b << std::right << std::fixed << std::setprecision(1);
+    for (auto [label, p] : {std::pair{"p50", 0.5}, {"p99", 0.99}, {"p999", 0.999}})
+      line << "  " << label << std::setw(9) << percentile(samples, p) / 1000 << " us";
+    std::cout << line.str() << std::endl;
+  }
+}
+
+} // namespace
+
+TEST(handoff_latency_test, benchmark) {
+  constexpr int rounds = 10000;
+
+  report<CondVarSignal>("condition_variable", rounds);
+  // Two 5 ms sleeps per round trip: a handful of rounds says enough.
+  report<SleepPollSignal>("atomic + sleep_for(5ms)", 50);
+  report<PromiseSignal>("promise<void>", rounds);
+  report<LatchSignal>("latch", rounds);
+  report<AtomicWaitSignal>("atomic::wait", rounds);
+}
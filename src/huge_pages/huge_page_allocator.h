@@ -0,0 +1,187 @@
+#pragma once
+
+#include <sys/mman.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <limits>
+#include <new>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace huge_pages {
+
+// Allocator for big streaming buffers backed by 2 MiB pages.
+//
+// With 4 KiB pages a 400 MB vector spans ~100k pages, far more than the
+// TLB holds, so a linear scan takes a TLB miss (and a page walk) every 4 KiB.
+// With 2 MiB pages the same vector is 200 pages.
+//
+//   Mode::explicit_pages   2 MiB MAP_HUGETLB pages from the kernel's pool
+//                          (vm.nr_hugepages); falls back to transparent
+//                          huge pages when the pool is empty
+//   Mode::transparent      a 2 MiB-aligned mapping with madvise(MADV_HUGEPAGE),
+//                          which THP in "madvise" mode needs
+//   Mode::small_pages      madvise(MADV_NOHUGEPAGE): plain 4 KiB pages even
+//                          when THP is "always", as a baseline
+//
+// Elements are default-initialized, so the pages are faulted in by whoever
+// writes them first (see parallel_fill).
+
+constexpr std::size_t huge_page_size = std::size_t{2} << 20;
+
+enum class Mode { small_pages, transparent, explicit_pages };
+
+namespace detail {
+
+// MAP_HUGETLB alone uses the kernel's default huge page size, which may be
+// 1 GiB; ask for 2 MiB pages so that lengths rounded to huge_page_size
+// match the mapping.
+#ifdef MAP_HUGE_SHIFT
+constexpr int map_huge_2mb = 21 << MAP_HUGE_SHIFT;
+#else
+constexpr int map_huge_2mb = 21 << 26;
+#endif
+
+inline std::size_t round_up(std::size_t bytes) {
+  return (bytes + huge_page_size - 1) / huge_page_size * huge_page_size;
+}
+
+// Anonymous mapping of `bytes` (a multiple of huge_page_size) starting on a
+// 2 MiB boundary: over-allocate and trim the ends.
+inline void *map_aligned(std::size_t bytes) {
+  if (bytes > std::numeric_limits<std::size_t>::max() - huge_page_size)
+    return nullptr;
+  std::size_t span = bytes + huge_page_size;
+  void *raw = ::mmap(nullptr, span, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (raw == MAP_FAILED)
+    return nullptr;
+
+  auto addr = reinterpret_cast<std::uintptr_t>(raw);
+  auto aligned = (addr + huge_page_size - 1) / huge_page_size * huge_page_size;
+  if (aligned > addr)
+    ::munmap(raw, aligned - addr);
+  std::size_t tail = addr + span - (aligned + bytes);
+  if (tail > 0)
+    ::munmap(reinterpret_cast<void *>(aligned + bytes), tail);
+  return reinterpret_cast<void *>(aligned);
+}
+
+inline void *map(std::size_t bytes, Mode mode) {
+  if (mode == Mode::explicit_pages) {
+    void *p = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | map_huge_2mb, -1, 0);
+    if (p != MAP_FAILED)
+      return p;
+    mode = Mode::transparent;
+  }
+
+  void *p = map_aligned(bytes);
+  if (p != nullptr)
+    ::madvise(p, bytes, mode == Mode::transparent ? MADV_HUGEPAGE : MADV_NOHUGEPAGE);
+  return p;
+}
+
+} // namespace detail
+
+template <typename T>
+class HugePageAllocator {
+public:
+  using value_type = T;
+
+  HugePageAllocator() noexcept = default;
+  explicit HugePageAllocator(Mode m) noexcept : mode(m) {}
+
+  template <typename U>
+  HugePageAllocator(const HugePageAllocator<U> &other) noexcept : mode(other.mode) {}
+
+  T *allocate(std::size_t n) {
+    // n * sizeof(T) must round up to a whole huge page without wrapping.
+    if (n > (std::numeric_limits<std::size_t>::max() - (huge_page_size - 1)) / sizeof(T))
+      throw std::bad_array_new_length();
+    if (n == 0)
+      return nullptr;
+
+    void *p = detail::map(detail::round_up(n * sizeof(T)), mode);
+    if (p == nullptr)
+      throw std::bad_alloc();
+    return static_cast<T *>(p);
+  }
+
+  // Whichever way the mapping was made, its length is the rounded size.
+  void deallocate(T *p, std::size_t n) noexcept {
+    if (p)
+      ::munmap(p, detail::round_up(n * sizeof(T)));
+  }
+
+  template <typename U>
+  void construct(U *ptr) noexcept(std::is_nothrow_default_constructible_v<U>) {
+    ::new (static_cast<void *>(ptr)) U;
+  }
+
+  template <typename U, typename... Args>
+  void construct(U *ptr, Args &&...args) {
+    ::new (static_cast<void *>(ptr)) U(std::forward<Args>(args)...);
+  }
+
+  template <typename U>
+  friend class HugePageAllocator;
+
+  friend bool operator==(const HugePageAllocator &a, const HugePageAllocator &b) {
+    return a.mode == b.mode;
+  }
+
+private:
+  Mode mode = Mode::transparent;
+};
+
+template <typename T>
+using huge_vector = std::vector<T, HugePageAllocator<T>>;
+
+// How much of the mapping that contains `addr` is backed by huge pages, in
+// bytes, according to /proc/self/smaps: AnonHugePages for THP, the whole
+// RSS for a hugetlb mapping (KernelPageSize 2048 kB).
+inline std::size_t huge_bytes(const void *addr) {
+  auto target = reinterpret_cast<std::uintptr_t>(addr);
+  std::ifstream smaps("/proc/self/smaps");
+  std::string line;
+  bool inside = false;
+  std::size_t rss_kb = 0, anon_huge_kb = 0, page_kb = 0;
+
+  while (std::getline(smaps, line)) {
+    std::uintptr_t lo, hi;
+    char dash;
+    std::istringstream in(line);
+    if (line.find(':') == std::string::npos || line.find(':') > line.find(' ')) {
+      // "lo-hi perms ..." starts a new mapping.
+      in >> std::hex >> lo >> dash >> hi;
+      if (inside)
+        break;
+      inside = dash == '-' && lo <= target && target < hi;
+      continue;
+    }
+    if (!inside)
+      continue;
+
+    std::string key;
+    std::size_t kb;
+    in >> key >> kb;
+    if (key == "Rss:")
+      rss_kb = kb;
+    else if (key == "AnonHugePages:")
+      anon_huge_kb = kb;
+    else if (key == "KernelPageSize:")
+      page_kb = kb;
+  }
+
+  if (page_kb >= huge_page_size >> 10)
+    return rss_kb << 10;
+  return anon_huge_kb << 10;
+}
+
+} // namespace huge_pages
@@ -0,0 +1,155 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <iostream>
+#include <limits>
+#include <new>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+#include "huge_pages/huge_page_allocator.h"
+#include "thread_pool/thread_pool.h"
+
+TEST(huge_page_allocator_test, basic_test) {
+  using huge_pages::Mode;
+
+  for (auto mode : {Mode::small_pages, Mode::transparent, Mode::explicit_pages}) {
+    huge_pages::huge_vector<int> v(3'000'000, huge_pages::HugePageAllocator<int>(mode));
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(v.data()) % huge_pages::huge_page_size, 0u);
+
+    std::iota(v.begin(), v.end(), 0);
+    EXPECT_EQ(v[2'999'999], 2'999'999);
+
+    v.push_back(-1);   // reallocates
+    EXPECT_EQ(v.back(), -1);
+    EXPECT_EQ(v[1'000'000], 1'000'000);
+
+    if (mode == Mode::small_pages) {
+      EXPECT_EQ(huge_pages::huge_bytes(v.data()), 0u);
+    }
+  }
+
+  // Small requests still get a whole (aligned) huge page.
+  huge_pages::huge_vector<char> tiny(1, 'x');
+  EXPECT_EQ(tiny[0], 'x');
+
+  // Sizes whose byte count would wrap when rounded up are rejected.
+  struct Big {
+    char bytes[4 << 20];
+  };
+  constexpr auto max = std::numeric_limits<std::size_t>::max();
+  EXPECT_THROW(huge_pages::HugePageAllocator<Big>().allocate(max / sizeof(Big) + 1),
+               std::bad_array_new_length);
+  EXPECT_THROW(huge_pages::HugePageAllocator<char>().allocate(max - 1), std::bad_array_new_length);
+  EXPECT_THROW(huge_pages::HugePageAllocator<char>().allocate(max - 3 * huge_pages::huge_page_size),
+               std::bad_alloc);
+}
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// sum_up from parallel_algorihtms_in_stl.cc: four threads, one quarter each.
+template <typename Vector>
+unsigned long long sum_up(const Vector &values) {
+  auto quarter = values.size() / 4;
+  std::vector<std::future<unsigned long long>> parts;
+  std::vector<std::thread> threads;
+  for (std::size_t q = 0; q < 4; ++q) {
+    std::promise<unsigned long long> prom;
+    parts.push_back(prom.get_future());
+    threads.emplace_back([&values, prom = std::move(prom), beg = q * quarter,
+                          end = q == 3 ? values.size() : (q + 1) * quarter]() mutable {
+      unsigned long long sum{};
+      for (auto i = beg; i < end; ++i)
+        sum += values[i];
+      prom.set_value(sum);
+    });
+  }
+  unsigned long long sum = 0;
+  for (auto &part : parts)
+    sum += part.get();
+  for (auto &t : threads)
+    t.join();
+  return sum;
+}
+
+// get_dot_product from task_semantics.cc: four pool tasks.
+template <typename Vector>
+long long get_dot_product(thread_pool::ThreadPool &pool, const Vector &v, const Vector &w) {
+  auto size = v.size();
+  std::vector<std::future<long long>> parts;
+  for (std::size_t q = 0; q < 4; ++q) {
+    auto first = size * q / 4, last = size * (q + 1) / 4;
+    parts.push_back(thread_pool::async_on(pool, [&v, &w, first, last] {
+      return std::inner_product(&v[first], &v[0] + last, &w[first], 0ll);
+    }));
+  }
+  long long sum = 0;
+  for (auto &part : parts)
+    sum += part.get();
+  return sum;
+}
+
+// Cheap deterministic values, written from the pool so the pages are
+// faulted in (and, for THP, collapsed) in parallel.
+template <typename Vector>
+void fill_pattern(thread_pool::ThreadPool &pool, Vector &v, int salt) {
+  std::vector<std::future<void>> parts;
+  for (std::size_t q = 0; q < 4; ++q) {
+    auto first = v.size() * q / 4, last = v.size() * (q + 1) / 4;
+    parts.push_back(thread_pool::async_on(pool, [&v, first, last, salt] {
+      for (auto i = first; i < last; ++i)
+        v[i] = static_cast<int>((i * salt) % 10) + 1;
+    }));
+  }
+  for (auto &part : parts)
+    part.get();
+}
+
+template <typename F>
+double best_ms(F f) {
+  double best = 1e300;
+  for (int run = 0; run < 2; ++run) {
+    auto sta = Clock::now();
+    f();
+    std::chrono::duration<double, std::milli> dur = Clock::now() - sta;
+    best = std::min(best, dur.count());
+  }
+  return best;
+}
+
+} // namespace
+
+TEST(huge_page_allocator_test, benchmark) {
+  // 400 MB per vector, the size of the reduction buffers in
+  // test_performance.
+  constexpr std::size_t size = 100'000'000;
+  using huge_pages::Mode;
+
+  thread_pool::ThreadPool pool;
+  for (auto [name, mode] : {std::pair{"4K pages", Mode::small_pages},
+                            {"THP (madvise)", Mode::transparent},
+                            {"MAP_HUGETLB", Mode::explicit_pages}}) {
+    huge_pages::HugePageAllocator<int> alloc(mode);
+    huge_pages::huge_vector<int> v(size, alloc), w(size, alloc);
+    fill_pattern(pool, v, 1);
+    fill_pattern(pool, w, 2);
+
+    unsigned long long sum = 0;
+    long long dot = 0;
+    double sum_ms = best_ms([&] { sum = sum_up(v); });
+    double dot_ms = best_ms([&] { dot = get_dot_product(pool, v, w); });
+
+    // v cycles through 1..10, w through 1,3,5,7,9 twice.
+    EXPECT_EQ(sum, size / 10 * 55);
+    EXPECT_EQ(dot, static_cast<long long>(size / 10) * (1 * 1 + 2 * 3 + 3 * 5 + 4 * 7 + 5 * 9 +
+                                                        6 * 1 + 7 * 3 + 8 * 5 + 9 * 7 + 10 * 9));
+    std::cout << name << " (" << (huge_pages::huge_bytes(v.data()) >> 20)
+              << " MiB on huge pages): sum_up " << sum_ms << " ms, "
+              << size * sizeof(int) / sum_ms / 1e6 << " GB/s; get_dot_product " << dot_ms
+              << " ms, " << 2 * size * sizeof(int) / dot_ms / 1e6 << " GB/s." << std::endl;
+  }
+}
@@ -0,0 +1,366 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+namespace inline_future {
+
+// Lightweight promise/future whose shared state does not have to come from
+// the heap. std::promise allocates a state with a mutex and a condition
+// variable for every pair; here the state is a plain object that lives
+// either in caller-provided storage (e.g. on the stack of a function that
+// outlives both ends) or in a SharedStatePool slab.
+//
+// All synchronisation goes through one 32-bit word:
+//
+//   bit 0-1  status: empty, value or exception
+//   bit 2    a future is blocked in atomic::wait() on the word
+//   bit 3-   reference count (promise + future)
+//
+// The promise publishes the result with a release fetch_or and calls
+// notify_one() only when the waiting bit is set; the future spins briefly
+// and then blocks in atomic::wait(). The last of the two ends to go away
+// destroys the result and hands the state back to where it came from.
+
+template <typename T>
+class SharedStatePool;
+
+template <typename T>
+class Promise;
+
+template <typename T>
+class Future;
+
+namespace detail {
+
+struct Unit {};
+
+template <typename T>
+using value_t = std::conditional_t<std::is_void_v<T>, Unit, T>;
+
+// Number of polls before a future blocks in atomic::wait().
+constexpr int spin_count = 128;
+
+} // namespace detail
+
+template <typename T>
+class SharedState {
+public:
+  SharedState() {}
+  ~SharedState() { destroy_result(word.load(std::memory_order_relaxed)); }
+
+  SharedState(const SharedState &) = delete;
+  SharedState &operator=(const SharedState &) = delete;
+
+  // True while a promise or a future still refers to this state.
+  [[nodiscard]] bool in_use() const {
+    return word.load(std::memory_order_acquire) != 0;
+  }
+
+private:
+  friend class SharedStatePool<T>;
+  friend class Promise<T>;
+  friend class Future<T>;
+  template <typename U>
+  friend std::pair<Promise<U>, Future<U>> make_promise(SharedState<U> &storage);
+  template <typename U>
+  friend std::pair<Promise<U>, Future<U>> make_promise(SharedStatePool<U> &pool);
+
+  static constexpr std::uint32_t status_mask = 0x3;
+  static constexpr std::uint32_t empty = 0x0;
+  static constexpr std::uint32_t has_value = 0x1;
+  static constexpr std::uint32_t has_error = 0x2;
+  static constexpr std::uint32_t waiting = 0x4;
+  static constexpr std::uint32_t one_ref = 0x8;
+
+  enum class Origin { caller, pool, heap };
+
+  void attach(Origin from, SharedStatePool<T> *pool) {
+    std::uint32_t expected = 0;
+    if (!word.compare_exchange_strong(expected, 2 * one_ref,
+                                      std::memory_order_acquire))
+      throw std::logic_error("shared state is still in use");
+    origin = from;
+    owner = pool;
+  }
+
+  template <typename... Args>
+  void publish_value(Args &&...args) {
+    std::construct_at(&value, std::forward<Args>(args)...);
+    publish(has_value);
+  }
+
+  void publish_error(std::exception_ptr e) {
+    std::construct_at(&error, std::move(e));
+    publish(has_error);
+  }
+
+  void publish(std::uint32_t status) {
+    auto old = word.fetch_or(status, std::memory_order_release);
+    if (old & waiting)
+      word.notify_one();
+  }
+
+  [[nodiscard]] bool is_ready() const {
+    return (word.load(std::memory_order_acquire) & status_mask) != empty;
+  }
+
+  std::uint32_t wait() {
+    // Spinning only pays off when the promise can run on another core.
+    static const int spins =
+        std::thread::hardware_concurrency() > 1 ? detail::spin_count : 0;
+
+    auto w = word.load(std::memory_order_acquire);
+    for (int i = 0; i < spins && (w & status_mask) == empty; ++i)
+      w = word.load(std::memory_order_acquire);
+
+    while ((w & status_mask) == empty) {
+      if (!(w & waiting)) {
+        if (!word.compare_exchange_weak(w, w | waiting, std::memory_order_acquire))
+          continue;
+        w |= waiting;
+      }
+      word.wait(w, std::memory_order_acquire);
+      w = word.load(std::memory_order_acquire);
+    }
+    return w & status_mask;
+  }
+
+  void release() {
+    auto old = word.fetch_sub(one_ref, std::memory_order_acq_rel);
+    if ((old >> 3) != 1)
+      return;
+
+    destroy_result(old);
+    word.store(0, std::memory_order_release);
+
+    switch (origin) {
+    case Origin::caller:
+      break;
+    case Origin::pool:
+      owner->recycle(this);
+      break;
+    case Origin::heap:
+      delete this;
+      break;
+    }
+  }
+
+  void destroy_result(std::uint32_t w) {
+    if ((w & status_mask) == has_value)
+      std::destroy_at(&value);
+    else if ((w & status_mask) == has_error)
+      std::destroy_at(&error);
+  }
+
+  std::atomic<std::uint32_t> word{0};
+  Origin origin = Origin::caller;
+  SharedStatePool<T> *owner = nullptr;
+
+  union {
+    detail::value_t<T> value;
+    std::exception_ptr error;
+  };
+};
+
+// Fixed-capacity slab of shared states with a lock-free free list. The free
+// list is a Treiber stack of slot indices; the head carries a version tag in
+// its upper half so that a slot popped and pushed back between a load and
+// the CAS (ABA) is detected.
+template <typename T>
+class SharedStatePool {
+public:
+  explicit SharedStatePool(std::size_t capacity)
+    : slots(new SharedState<T>[capacity]),
+      next(new std::atomic<std::uint32_t>[capacity]),
+      head(capacity == 0 ? nil : 0)
+  {
+    for (std::size_t i = 0; i < capacity; ++i)
+      next[i].store(i + 1 < capacity ? static_cast<std::uint32_t>(i + 1) : nil,
+                    std::memory_order_relaxed);
+  }
+
+  SharedStatePool(const SharedStatePool &) = delete;
+  SharedStatePool &operator=(const SharedStatePool &) = delete;
+
+  // nullptr when every slot is in use.
+  SharedState<T> *acquire() {
+    auto h = head.load(std::memory_order_acquire);
+    for (;;) {
+      auto index = static_cast<std::uint32_t>(h);
+      if (index == nil)
+        return nullptr;
+
+      auto tag = (h >> 32) + 1;
+      auto new_head = (tag << 32) | next[index].load(std::memory_order_relaxed);
+      if (head.compare_exchange_weak(h, new_head, std::memory_order_acquire))
+        return &slots[index];
+    }
+  }
+
+private:
+  friend class SharedState<T>;
+
+  static constexpr std::uint32_t nil = 0xffffffffu;
+
+  void recycle(SharedState<T> *state) {
+    auto index = static_cast<std::uint32_t>(state - slots.get());
+    auto h = head.load(std::memory_order_relaxed);
+    for (;;) {
+      next[index].store(static_cast<std::uint32_t>(h), std::memory_order_relaxed);
+      auto tag = (h >> 32) + 1;
+      if (head.compare_exchange_weak(h, (tag << 32) | index,
+                                     std::memory_order_release))
+        return;
+    }
+  }
+
+  std::unique_ptr<SharedState<T>[]> slots;
+  std::unique_ptr<std::atomic<std::uint32_t>[]> next;
+  std::atomic<std::uint64_t> head;
+};
+
+template <typename T>
+class Promise {
+public:
+  Promise() = default;
+
+  Promise(Promise &&other) noexcept : state(std::exchange(other.state, nullptr)) {}
+  Promise &operator=(Promise &&other) noexcept {
+    if (this != &other) {
+      abandon();
+      state = std::exchange(other.state, nullptr);
+    }
+    return *this;
+  }
+
+  ~Promise() { abandon(); }
+
+  void set_value(detail::value_t<T> v) requires(!std::is_void_v<T>) {
+    auto s = take_state();
+    s->publish_value(std::move(v));
+    s->release();
+  }
+
+  void set_value() requires std::is_void_v<T> {
+    auto s = take_state();
+    s->publish_value();
+    s->release();
+  }
+
+  void set_exception(std::exception_ptr e) {
+    auto s = take_state();
+    s->publish_error(std::move(e));
+    s->release();
+  }
+
+private:
+  template <typename U>
+  friend std::pair<Promise<U>, Future<U>> make_promise(SharedState<U> &storage);
+  template <typename U>
+  friend std::pair<Promise<U>, Future<U>> make_promise(SharedStatePool<U> &pool);
+
+  explicit Promise(SharedState<T> *s) : state(s) {}
+
+  SharedState<T> *take_state() {
+    if (!state)
+      throw std::future_error(std::future_errc::promise_already_satisfied);
+    return std::exchange(state, nullptr);
+  }
+
+  void abandon() {
+    if (state)
+      set_exception(std::make_exception_ptr(
+          std::future_error(std::future_errc::broken_promise)));
+  }
+
+  SharedState<T> *state = nullptr;
+};
+
+template <typename T>
+class Future {
+public:
+  Future() = default;
+
+  Future(Future &&other) noexcept : state(std::exchange(other.state, nullptr)) {}
+  Future &operator=(Future &&other) noexcept {
+    if (this != &other) {
+      if (state)
+        state->release();
+      state = std::exchange(other.state, nullptr);
+    }
+    return *this;
+  }
+
+  ~Future() {
+    if (state)
+      state->release();
+  }
+
+  [[nodiscard]] bool valid() const { return state != nullptr; }
+
+  [[nodiscard]] bool is_ready() const { return state && state->is_ready(); }
+
+  void wait() const {
+    if (!state)
+      throw std::future_error(std::future_errc::no_state);
+    state->wait();
+  }
+
+  T get() {
+    if (!state)
+      throw std::future_error(std::future_errc::no_state);
+
+    // Released on every path, including the rethrow.
+    std::unique_ptr<SharedState<T>, Releaser> s(std::exchange(state, nullptr));
+    if (s->wait() == SharedState<T>::has_error)
+      std::rethrow_exception(s->error);
+    if constexpr (!std::is_void_v<T>)
+      return std::move(s->value);
+  }
+
+private:
+  template <typename U>
+  friend std::pair<Promise<U>, Future<U>> make_promise(SharedState<U> &storage);
+  template <typename U>
+  friend std::pair<Promise<U>, Future<U>> make_promise(SharedStatePool<U> &pool);
+
+  struct Releaser {
+    void operator()(SharedState<T> *s) const { s->release(); }
+  };
+
+  explicit Future(SharedState<T> *s) : state(s) {}
+
+  SharedState<T> *state = nullptr;
+};
+
+// Pair living in caller-provided storage. `storage` must outlive both ends
+// and can be reused once they are gone.
+template <typename T>
+std::pair<Promise<T>, Future<T>> make_promise(SharedState<T> &storage) {
+  storage.attach(SharedState<T>::Origin::caller, nullptr);
+  return {Promise<T>(&storage), Future<T>(&storage)};
+}
+
+// Pair backed by a slab slot; falls back to the heap when the slab is full.
+template <typename T>
+std::pair<Promise<T>, Future<T>> make_promise(SharedStatePool<T> &pool) {
+  SharedState<T> *s = pool.acquire();
+  if (s) {
+    s->attach(SharedState<T>::Origin::pool, &pool);
+  } else {
+    s = new SharedState<T>;
+    s->attach(SharedState<T>::Origin::heap, nullptr);
+  }
+  return {Promise<T>(s), Future<T>(s)};
+}
+
+} // namespace inline_future
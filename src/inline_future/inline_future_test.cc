@@ -0,0 +1,171 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "inline_future/inline_future.h"
+
+TEST(inline_future_test, caller_storage_test) {
+  inline_future::SharedState<std::string> storage;
+
+  {
+    auto [promise, future] = inline_future::make_promise(storage);
+    EXPECT_TRUE(storage.in_use());
+    EXPECT_FALSE(future.is_ready());
+
+    std::thread t([p = std::move(promise)]() mutable { p.set_value("2011"); });
+    EXPECT_EQ(future.get(), "2011");
+    EXPECT_FALSE(future.valid());
+    t.join();
+  }
+  EXPECT_FALSE(storage.in_use());
+
+  // The same storage can back the next pair.
+  auto [promise, future] = inline_future::make_promise(storage);
+  promise.set_value("again");
+  EXPECT_EQ(future.get(), "again");
+}
+
+TEST(inline_future_test, exception_test) {
+  inline_future::SharedState<int> storage;
+
+  {
+    auto [promise, future] = inline_future::make_promise(storage);
+    promise.set_exception(std::make_exception_ptr(std::runtime_error("illegal division by zero")));
+    EXPECT_THROW(future.get(), std::runtime_error);
+  }
+
+  {
+    auto [promise, future] = inline_future::make_promise(storage);
+    { auto dropped = std::move(promise); }
+    EXPECT_THROW(future.get(), std::future_error);
+  }
+
+  auto [promise, future] = inline_future::make_promise(storage);
+  EXPECT_THROW(inline_future::make_promise(storage), std::logic_error);
+  promise.set_value(1);
+  EXPECT_THROW(promise.set_value(2), std::future_error);
+  EXPECT_EQ(future.get(), 1);
+}
+
+TEST(inline_future_test, pool_test) {
+  inline_future::SharedStatePool<int> pool(4);
+
+  std::vector<inline_future::Promise<int>> promises;
+  std::vector<inline_future::Future<int>> futures;
+
+  // Two more than the slab holds: those come from the heap.
+  for (int i = 0; i < 6; ++i) {
+    auto [promise, future] = inline_future::make_promise(pool);
+    promises.push_back(std::move(promise));
+    futures.push_back(std::move(future));
+  }
+  EXPECT_EQ(pool.acquire(), nullptr);
+
+  std::thread t([&] {
+    for (int i = 0; i < 6; ++i)
+      promises[i].set_value(i * i);
+  });
+  for (int i = 0; i < 6; ++i)
+    EXPECT_EQ(futures[i].get(), i * i);
+  t.join();
+
+  // All slab slots are back on the free list.
+  futures.clear();
+  promises.clear();
+  for (int i = 0; i < 4; ++i)
+    EXPECT_NE(pool.acquire(), nullptr);
+}
+
+TEST(inline_future_test, void_test) {
+  inline_future::SharedState<void> storage;
+  auto [promise, future] = inline_future::make_promise(storage);
+
+  std::thread t([&promise] { promise.set_value(); });
+  future.get();
+  t.join();
+}
+
+namespace {
+
+constexpr int round_trips = 20000;
+
+// Main thread sets request i, the echo thread answers with response i; the
+// time per iteration is one set/get round trip between two threads.
+template <typename MakePair>
+double round_trip_us(MakePair make_pair) {
+  auto requests = make_pair(round_trips);
+  auto responses = make_pair(round_trips);
+
+  std::thread echo([&] {
+    for (int i = 0; i < round_trips; ++i)
+      responses.first[i].set_value(requests.second[i].get());
+  });
+
+  auto sta = std::chrono::steady_clock::now();
+  long long sum = 0;
+  for (int i = 0; i < round_trips; ++i) {
+    requests.first[i].set_value(i);
+    sum += responses.second[i].get();
+  }
+  std::chrono::duration<double, std::micro> dur = std::chrono::steady_clock::now() - sta;
+  echo.join();
+
+  EXPECT_EQ(sum, 1ll * round_trips * (round_trips - 1) / 2);
+  return dur.count() / round_trips;
+}
+
+} // namespace
+
+TEST(inline_future_test, benchmark) {
+  double std_us = round_trip_us([](int n) {
+    std::pair<std::vector<std::promise<int>>, std::vector<std::future<int>>> pairs;
+    pairs.first.resize(n);
+    for (auto &promise : pairs.first)
+      pairs.second.push_back(promise.get_future());
+    return pairs;
+  });
+
+  inline_future::SharedStatePool<int> pool(2 * round_trips);
+  double inline_us = round_trip_us([&pool](int n) {
+    std::pair<std::vector<inline_future::Promise<int>>,
+              std::vector<inline_future::Future<int>>> pairs;
+    for (int i = 0; i < n; ++i) {
+      auto [promise, future] = inline_future::make_promise(pool);
+      pairs.first.push_back(std::move(promise));
+      pairs.second.push_back(std::move(future));
+    }
+    return pairs;
+  });
+
+  std::cout << "std::promise/std::future round trip: " << std_us << " us." << std::endl;
+  std::cout << "inline_future round trip: " << inline_us << " us." << std::endl;
+
+  // Creation cost: make, set and get on one thread.
+  auto sta = std::chrono::steady_clock::now();
+  for (int i = 0; i < round_trips; ++i) {
+    std::promise<int> promise;
+    auto future = promise.get_future();
+    promise.set_value(i);
+    (void)future.get();
+  }
+  std::chrono::duration<double, std::nano> std_dur = std::chrono::steady_clock::now() - sta;
+
+  inline_future::SharedState<int> storage;
+  sta = std::chrono::steady_clock::now();
+  for (int i = 0; i < round_trips; ++i) {
+    auto [promise, future] = inline_future::make_promise(storage);
+    promise.set_value(i);
+    (void)future.get();
+  }
+  std::chrono::duration<double, std::nano> inline_dur = std::chrono::steady_clock::now() - sta;
+
+  std::cout << "std::promise create/set/get: " << std_dur.count() / round_trips
+            << " ns, inline_future: " << inline_dur.count() / round_trips
+            << " ns." << std::endl;
+}
@@ -0,0 +1,164 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <type_traits>
+
+#include "reclamation/policies.h"
+
+namespace lock_free {
+
+// Chase-Lev work-stealing deque (Chase & Lev 2005, with the C11 memory
+// orders of Le, Pop, Cohen & Zappa Nardelli 2013).
+//
+// One owner thread pushes and pops at the bottom, like a stack; any number
+// of thieves steal from the top, oldest first:
+//
+//   owner                                 thieves
+//   deque.push(task);                     if (auto t = deque.steal())
+//   if (auto t = deque.pop()) run(*t);      run(*t);
+//
+// Owner operations touch only `bottom` and the buffer, apart from the
+// single CAS that settles a race for the last element. A thief reads
+// `top`, then `bottom`, reads the slot and claims it with a CAS on `top`;
+// a failed CAS means another thread took the element first.
+//
+// The buffer is a power-of-two ring that the owner doubles when it is full.
+// Thieves may still be reading the old one, so it goes to the Reclaimer
+// (reclamation::Epochs or reclamation::HazardPointers) rather than being
+// freed at once.
+//
+// A thief reads a slot before it knows whether it won it, so elements are
+// copied racily and must be trivially copyable; store pointers or indices
+// for anything larger.
+template <typename T, typename Reclaimer = reclamation::Epochs>
+class ChaseLevDeque {
+  static_assert(std::is_trivially_copyable_v<T>,
+                "thieves copy elements before claiming them");
+
+  struct Buffer {
+    explicit Buffer(std::size_t capacity)
+        : mask(capacity - 1), slots(std::make_unique<std::atomic<T>[]>(capacity)) {}
+
+    [[nodiscard]] std::size_t capacity() const { return mask + 1; }
+
+    T get(std::int64_t i) const {
+      return slots[static_cast<std::size_t>(i) & mask].load(std::memory_order_relaxed);
+    }
+
+    void put(std::int64_t i, T value) {
+      slots[static_cast<std::size_t>(i) & mask].store(value, std::memory_order_relaxed);
+    }
+
+    const std::size_t mask;
+    std::unique_ptr<std::atomic<T>[]> slots;
+  };
+
+public:
+  // `capacity` is rounded up to a power of two. The domain is fixed at
+  // construction, as for MSQueue.
+  explicit ChaseLevDeque(std::size_t capacity = 64,
+                         typename Reclaimer::Domain &domain = Reclaimer::default_domain())
+      : domain(domain) {
+    buffer.store(new Buffer(std::bit_ceil(std::max<std::size_t>(capacity, 2))),
+                 std::memory_order_relaxed);
+  }
+
+  // No thread may be using the deque any more.
+  ~ChaseLevDeque() { delete buffer.load(std::memory_order_relaxed); }
+
+  ChaseLevDeque(const ChaseLevDeque &) = delete;
+  ChaseLevDeque &operator=(const ChaseLevDeque &) = delete;
+
+  // Owner only.
+  void push(T value) {
+    std::int64_t b = bottom.load(std::memory_order_relaxed);
+    std::int64_t t = top.load(std::memory_order_acquire);
+    Buffer *a = buffer.load(std::memory_order_relaxed);
+    if (b - t >= static_cast<std::int64_t>(a->capacity()))
+      a = grow(a, t, b);
+    a->put(b, value);
+    // Publishes the slot before the new bottom that makes it stealable.
+    std::atomic_thread_fence(std::memory_order_release);
+    bottom.store(b + 1, std::memory_order_relaxed);
+  }
+
+  // Owner only. Takes the most recently pushed element.
+  std::optional<T> pop() {
+    std::int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+    Buffer *a = buffer.load(std::memory_order_relaxed);
+    bottom.store(b, std::memory_order_relaxed);
+    // Either a thief sees the lowered bottom, or we see its raised top.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    std::int64_t t = top.load(std::memory_order_relaxed);
+
+    std::optional<T> res;
+    if (t <= b) {
+      res = a->get(b);
+      if (t == b) {
+        // The last element: race the thieves for it through top.
+        if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                         std::memory_order_relaxed))
+          res.reset();
+        bottom.store(b + 1, std::memory_order_relaxed);
+      }
+    } else {
+      bottom.store(b + 1, std::memory_order_relaxed);
+    }
+    return res;
+  }
+
+  // Any thread. Takes the oldest element; empty if there was none or another
+  // thread claimed it first.
+  std::optional<T> steal() {
+    std::int64_t t = top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    std::int64_t b = bottom.load(std::memory_order_acquire);
+    if (t >= b)
+      return std::nullopt;
+
+    Guard guard(domain);
+    T value = guard.protect(0, buffer)->get(t);
+    if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                     std::memory_order_relaxed))
+      return std::nullopt;
+    return value;
+  }
+
+  // Snapshots; may be stale by the time they return.
+  [[nodiscard]] std::size_t size() const {
+    std::int64_t b = bottom.load(std::memory_order_relaxed);
+    std::int64_t t = top.load(std::memory_order_relaxed);
+    return b > t ? static_cast<std::size_t>(b - t) : 0;
+  }
+
+  [[nodiscard]] bool empty() const { return size() == 0; }
+
+  [[nodiscard]] std::size_t capacity() const {
+    return buffer.load(std::memory_order_relaxed)->capacity();
+  }
+
+private:
+  using Guard = typename Reclaimer::template Guard<1>;
+
+  Buffer *grow(Buffer *old, std::int64_t t, std::int64_t b) {
+    auto *a = new Buffer(old->capacity() * 2);
+    for (std::int64_t i = t; i < b; ++i)
+      a->put(i, old->get(i));
+    buffer.store(a, std::memory_order_release);
+    domain.retire(old);
+    return a;
+  }
+
+  typename Reclaimer::Domain &domain;
+  alignas(64) std::atomic<std::int64_t> top{0};
+  alignas(64) std::atomic<std::int64_t> bottom{0};
+  std::atomic<Buffer *> buffer;
+};
+
+} // namespace lock_free
@@ -0,0 +1,228 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "lock_free/chase_lev_deque.h"
+
+TEST(chase_lev_deque_test, basic_test) {
+  lock_free::ChaseLevDeque<int> deque(2);
+  EXPECT_TRUE(deque.empty());
+  EXPECT_FALSE(deque.pop().has_value());
+  EXPECT_FALSE(deque.steal().has_value());
+
+  for (int i = 0; i < 5; ++i)
+    deque.push(i);
+  EXPECT_EQ(deque.size(), 5);
+  EXPECT_GE(deque.capacity(), 5);
+
+  // The owner works at the bottom, thieves at the top.
+  EXPECT_EQ(*deque.pop(), 4);
+  EXPECT_EQ(*deque.steal(), 0);
+  EXPECT_EQ(*deque.steal(), 1);
+  EXPECT_EQ(*deque.pop(), 3);
+  EXPECT_EQ(*deque.pop(), 2);
+  EXPECT_FALSE(deque.pop().has_value());
+  EXPECT_FALSE(deque.steal().has_value());
+}
+
+TEST(chase_lev_deque_test, grow_test) {
+  lock_free::ChaseLevDeque<int> deque(2);
+  // Wrap the ring before growing, so that the copy has to follow the mask.
+  for (int round = 0; round < 3; ++round) {
+    deque.push(round);
+    EXPECT_EQ(*deque.steal(), round);
+  }
+  for (int i = 0; i < 10'000; ++i)
+    deque.push(i);
+  EXPECT_EQ(deque.capacity(), 16384);
+  for (int i = 0; i < 5'000; ++i)
+    EXPECT_EQ(*deque.steal(), i);
+  for (int i = 9'999; i >= 5'000; --i)
+    EXPECT_EQ(*deque.pop(), i);
+  EXPECT_TRUE(deque.empty());
+}
+
+namespace {
+
+// The owner pushes 0..items-1, popping one after every few pushes and
+// draining at the end, while `thieves` threads steal. Checks that every item
+// is taken exactly once. A small initial capacity makes the owner grow the
+// buffer while thieves are reading it.
+template <typename Reclaimer>
+void check_exactly_once(int thieves, int items) {
+  lock_free::ChaseLevDeque<int, Reclaimer> deque(4);
+  std::vector<std::atomic<int>> taken(items);
+  std::atomic<bool> done{false};
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < thieves; ++i) {
+    threads.emplace_back([&] {
+      while (!done.load()) {
+        if (auto v = deque.steal())
+          taken[*v].fetch_add(1);
+        else
+          std::this_thread::yield();
+      }
+    });
+  }
+
+  for (int i = 0; i < items; ++i) {
+    deque.push(i);
+    if (i % 3 == 0) {
+      if (auto v = deque.pop())
+        taken[*v].fetch_add(1);
+    }
+  }
+  while (auto v = deque.pop())
+    taken[*v].fetch_add(1);
+  done = true;
+  for (auto &t : threads)
+    t.join();
+
+  EXPECT_TRUE(deque.empty());
+  for (auto &t : taken)
+    ASSERT_EQ(t.load(), 1);
+}
+
+} // namespace
+
+TEST(chase_lev_deque_test, steal_test) {
+  for (int thieves : {1, 3}) {
+    check_exactly_once<reclamation::Epochs>(thieves, 100'000);
+    check_exactly_once<reclamation::HazardPointers>(thieves, 100'000);
+  }
+}
+
+namespace {
+
+// Baseline: the same interface over a mutex and a std::deque.
+template <typename T>
+class LockedDeque {
+public:
+  void push(T value) {
+    std::lock_guard<std::mutex> lk(mutex);
+    items.push_back(value);
+  }
+
+  std::optional<T> pop() {
+    std::lock_guard<std::mutex> lk(mutex);
+    if (items.empty())
+      return std::nullopt;
+    T value = items.back();
+    items.pop_back();
+    return value;
+  }
+
+  std::optional<T> steal() {
+    std::lock_guard<std::mutex> lk(mutex);
+    if (items.empty())
+      return std::nullopt;
+    T value = items.front();
+    items.pop_front();
+    return value;
+  }
+
+private:
+  std::mutex mutex;
+  std::deque<T> items;
+};
+
+struct Result {
+  double ops_per_sec;
+  double stolen;
+};
+
+// The owner pushes `items` in batches of 64 and pops half of each batch
+// back, the way a scheduler spawns and runs tasks; thieves steal until
+// everything has been taken.
+template <typename Deque>
+Result run(int thieves, int items) {
+  Deque deque;
+  std::atomic<int> remaining{items};
+  std::atomic<int> stolen{0};
+  auto sta = std::chrono::steady_clock::now();
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < thieves; ++i) {
+    threads.emplace_back([&] {
+      int mine = 0;
+      while (remaining.load(std::memory_order_relaxed) > 0) {
+        if (deque.steal()) {
+          remaining.fetch_sub(1, std::memory_order_relaxed);
+          ++mine;
+        } else {
+          std::this_thread::yield();
+        }
+      }
+      stolen.fetch_add(mine);
+    });
+  }
+
+  constexpr int batch = 64;
+  for (int i = 0; i < items; i += batch) {
+    for (int j = 0; j < batch; ++j)
+      deque.push(i + j);
+    for (int j = 0; j < batch / 2; ++j) {
+      if (deque.pop())
+        remaining.fetch_sub(1, std::memory_order_relaxed);
+    }
+  }
+  while (deque.pop())
+    remaining.fetch_sub(1, std::memory_order_relaxed);
+  while (remaining.load() > 0)
+    std::this_thread::yield();
+  for (auto &t : threads)
+    t.join();
+
+  std::chrono::duration<double> dur = std::chrono::steady_clock::now() - sta;
+  return {items / dur.count(), static_cast<double>(stolen.load()) / items};
+}
+
+template <typename Deque>
+void report(const char *name, int thieves, int items) {
+  Result r = run<Deque>(thieves, items);
+  std::cout << "  " << name << ": " << r.ops_per_sec / 1e6 << " M items/s, "
+            << r.stolen * 100 << "% stolen" << std::endl;
+}
+
+} // namespace
+
+TEST(chase_lev_deque_test, benchmark) {
+  constexpr int items = 1 << 20;
+
+  // Owner alone: the uncontended push/pop path.
+  {
+    lock_free::ChaseLevDeque<int> deque;
+    LockedDeque<int> locked;
+    auto sta = std::chrono::steady_clock::now();
+    for (int i = 0; i < items; ++i) {
+      deque.push(i);
+      (void)deque.pop();
+    }
+    std::chrono::duration<double> lock_free_dur = std::chrono::steady_clock::now() - sta;
+    sta = std::chrono::steady_clock::now();
+    for (int i = 0; i < items; ++i) {
+      locked.push(i);
+      (void)locked.pop();
+    }
+    std::chrono::duration<double> locked_dur = std::chrono::steady_clock::now() - sta;
+    std::cout << "owner push+pop (M pairs/s): Chase-Lev " << items / lock_free_dur.count() / 1e6
+              << ", mutex deque " << items / locked_dur.count() / 1e6 << std::endl;
+  }
+
+  for (int thieves : {0, 1, 2, 4}) {
+    std::cout << thieves << " thieves:" << std::endl;
+    report<lock_free::ChaseLevDeque<int, reclamation::Epochs>>("Chase-Lev, epochs", thieves,
+                                                                items);
+    report<lock_free::ChaseLevDeque<int, reclamation::HazardPointers>>(
+        "Chase-Lev, hazard pointers", thieves, items);
+    report<LockedDeque<int>>("mutex deque", thieves, items);
+  }
+}
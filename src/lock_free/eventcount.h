@@ -0,0 +1,59 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace lock_free {
+
+// Eventcount: lets a consumer block on a condition of a lock-free structure
+// without the producer taking a lock.
+//
+//   consumer                              producer
+//   if (q.try_pop(v)) return;             q.push(v);
+//   auto key = ec.prepare_wait();         ec.notify_one();
+//   if (q.try_pop(v)) { ec.cancel_wait(); return; }
+//   ec.wait(key);                         // retry from the top
+//
+// prepare_wait() registers the consumer before it re-checks the condition,
+// and notify() bumps the epoch after the producer's change, so a push that
+// the re-check missed always changes the epoch the consumer sleeps on.
+// notify() is a load and a branch while nobody waits.
+class EventCount {
+public:
+  using Key = std::uint32_t;
+
+  Key prepare_wait() {
+    waiters.fetch_add(1, std::memory_order_seq_cst);
+    return epoch.load(std::memory_order_seq_cst);
+  }
+
+  void cancel_wait() { waiters.fetch_sub(1, std::memory_order_relaxed); }
+
+  // Blocks until a notify after prepare_wait() returned `key`.
+  void wait(Key key) {
+    epoch.wait(key, std::memory_order_acquire);
+    waiters.fetch_sub(1, std::memory_order_relaxed);
+  }
+
+  void notify_one() { notify(false); }
+  void notify_all() { notify(true); }
+
+private:
+  void notify(bool all) {
+    // Orders the caller's change before the waiter check; pairs with the
+    // seq_cst operations in prepare_wait().
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (waiters.load(std::memory_order_relaxed) == 0)
+      return;
+    epoch.fetch_add(1, std::memory_order_release);
+    if (all)
+      epoch.notify_all();
+    else
+      epoch.notify_one();
+  }
+
+  std::atomic<Key> epoch{0};
+  std::atomic<int> waiters{0};
+};
+
+} // namespace lock_free
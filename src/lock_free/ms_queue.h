@@ -0,0 +1,164 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <optional>
+#include <utility>
+
+#include "lock_free/eventcount.h"
+#include "reclamation/policies.h"
+
+namespace lock_free {
+
+// Michael-Scott unbounded MPMC queue.
+//
+// A singly linked list with a dummy node at the head: push() links a node
+// after the last one with a CAS and swings tail; pop() swings head to
+// head->next with a CAS and takes the value out of what becomes the new
+// dummy. Either side helps a lagging tail along, so no operation waits for
+// another thread.
+//
+// Popped nodes go to the Reclaimer (reclamation::HazardPointers or
+// reclamation::Epochs), since other threads may still be reading them.
+template <typename T, typename Reclaimer = reclamation::HazardPointers>
+class MSQueue {
+  struct Node {
+    std::atomic<Node *> next{nullptr};
+    std::optional<T> value;
+  };
+
+  using Guard = typename Reclaimer::template Guard<2>;
+
+public:
+  // The domain is fixed at construction, so that a queue with static
+  // storage duration is destroyed before the default domain.
+  explicit MSQueue(typename Reclaimer::Domain &domain = Reclaimer::default_domain())
+      : domain(domain) {
+    auto *dummy = new Node;
+    head.store(dummy, std::memory_order_relaxed);
+    tail.store(dummy, std::memory_order_relaxed);
+  }
+
+  ~MSQueue() {
+    for (Node *n = head.load(); n != nullptr;) {
+      Node *next = n->next.load();
+      delete n;
+      n = next;
+    }
+  }
+
+  MSQueue(const MSQueue &) = delete;
+  MSQueue &operator=(const MSQueue &) = delete;
+
+  void push(T new_value) {
+    auto *node = new Node;
+    node->value.emplace(std::move(new_value));
+
+    Guard guard(domain);
+    for (;;) {
+      Node *last = guard.protect(0, tail);
+      Node *next = last->next.load(std::memory_order_acquire);
+      if (last != tail.load(std::memory_order_acquire))
+        continue;
+      if (next != nullptr) {
+        tail.compare_exchange_weak(last, next, std::memory_order_release,
+                                   std::memory_order_relaxed);
+        continue;
+      }
+      if (last->next.compare_exchange_weak(next, node, std::memory_order_release,
+                                           std::memory_order_relaxed)) {
+        tail.compare_exchange_strong(last, node, std::memory_order_release,
+                                     std::memory_order_relaxed);
+        return;
+      }
+    }
+  }
+
+  bool try_pop(T &value) {
+    return pop([&value](T &&v) { value = std::move(v); });
+  }
+
+  std::optional<T> try_pop() {
+    std::optional<T> res;
+    pop([&res](T &&v) { res.emplace(std::move(v)); });
+    return res;
+  }
+
+  // A snapshot; may be stale by the time it returns.
+  bool empty() const {
+    Guard guard(domain);
+    Node *first = guard.protect(0, head);
+    return first->next.load(std::memory_order_acquire) == nullptr;
+  }
+
+private:
+  template <typename Sink>
+  bool pop(Sink sink) {
+    Guard guard(domain);
+    for (;;) {
+      Node *first = guard.protect(0, head);
+      Node *next = guard.protect(1, first->next);
+      if (first != head.load(std::memory_order_acquire))
+        continue;
+      if (next == nullptr)
+        return false;
+      if (first == tail.load(std::memory_order_acquire)) {
+        tail.compare_exchange_weak(first, next, std::memory_order_release,
+                                   std::memory_order_relaxed);
+        continue;
+      }
+      if (head.compare_exchange_weak(first, next, std::memory_order_acq_rel,
+                                     std::memory_order_relaxed)) {
+        // next is the new dummy; only the thread that swung head reads its
+        // value, and the guard keeps it alive until then.
+        sink(std::move(*next->value));
+        next->value.reset();
+        guard.reset(0);
+        domain.retire(first);
+        return true;
+      }
+    }
+  }
+
+  typename Reclaimer::Domain &domain;
+  alignas(64) std::atomic<Node *> head;
+  alignas(64) std::atomic<Node *> tail;
+};
+
+// MSQueue plus an EventCount: consumers can block in wait_and_pop() while
+// producers stay lock-free.
+template <typename T, typename Reclaimer = reclamation::HazardPointers>
+class BlockingMSQueue {
+public:
+  BlockingMSQueue() = default;
+  explicit BlockingMSQueue(typename Reclaimer::Domain &domain) : queue(domain) {}
+
+  void push(T new_value) {
+    queue.push(std::move(new_value));
+    event.notify_one();
+  }
+
+  bool try_pop(T &value) { return queue.try_pop(value); }
+  std::optional<T> try_pop() { return queue.try_pop(); }
+
+  void wait_and_pop(T &value) {
+    for (;;) {
+      if (queue.try_pop(value))
+        return;
+      auto key = event.prepare_wait();
+      if (queue.try_pop(value)) {
+        event.cancel_wait();
+        return;
+      }
+      event.wait(key);
+    }
+  }
+
+  bool empty() const { return queue.empty(); }
+
+private:
+  MSQueue<T, Reclaimer> queue;
+  EventCount event;
+};
+
+} // namespace lock_free
@@ -0,0 +1,192 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "lock_free/ms_queue.h"
+#include "thread_pool/thread_pool.h"
+
+TEST(ms_queue_test, basic_test) {
+  lock_free::MSQueue<std::string> queue;
+  EXPECT_TRUE(queue.empty());
+  EXPECT_FALSE(queue.try_pop().has_value());
+
+  queue.push("one");
+  queue.push("two");
+  EXPECT_FALSE(queue.empty());
+  EXPECT_EQ(*queue.try_pop(), "one");
+  std::string s;
+  EXPECT_TRUE(queue.try_pop(s));
+  EXPECT_EQ(s, "two");
+  EXPECT_FALSE(queue.try_pop(s));
+
+  // Values left in the queue are destroyed with it.
+  lock_free::MSQueue<std::unique_ptr<int>, reclamation::Epochs> owning;
+  owning.push(std::make_unique<int>(1));
+  owning.push(std::make_unique<int>(2));
+  EXPECT_EQ(**owning.try_pop(), 1);
+}
+
+namespace {
+
+// Items are (producer << 32 | sequence). Checks that every item comes out
+// exactly once and that each consumer sees every producer's items in the
+// order they were pushed -- what a linearizable FIFO guarantees.
+template <bool Blocking, typename Queue>
+void check_fifo(Queue &queue, int producers, int consumers, std::uint32_t per_producer) {
+  std::atomic<long long> popped{0};
+  std::atomic<bool> ordered{true};
+  std::vector<std::atomic<int>> seen(static_cast<std::size_t>(producers) * per_producer);
+
+  std::vector<std::thread> threads;
+  for (int p = 0; p < producers; ++p) {
+    threads.emplace_back([&queue, p, per_producer] {
+      for (std::uint32_t i = 0; i < per_producer; ++i)
+        queue.push((static_cast<std::uint64_t>(p) << 32) | i);
+    });
+  }
+
+  const long long total = static_cast<long long>(producers) * per_producer;
+  for (int c = 0; c < consumers; ++c) {
+    threads.emplace_back([&] {
+      std::vector<std::int64_t> last(producers, -1);
+      std::uint64_t item;
+      for (;;) {
+        if constexpr (Blocking) {
+          queue.wait_and_pop(item);
+          if (item == ~std::uint64_t{0})
+            return;
+        } else if (!queue.try_pop(item)) {
+          if (popped.load() == total)
+            return;
+          std::this_thread::yield();
+          continue;
+        }
+        auto p = static_cast<int>(item >> 32);
+        auto seq = static_cast<std::int64_t>(item & 0xffffffff);
+        if (seq <= last[p])
+          ordered = false;
+        last[p] = seq;
+        seen[p * per_producer + seq].fetch_add(1);
+        popped.fetch_add(1);
+      }
+    });
+  }
+
+  for (int p = 0; p < producers; ++p)
+    threads[p].join();
+  if constexpr (Blocking) {
+    while (popped.load() != total)
+      std::this_thread::yield();
+    for (int c = 0; c < consumers; ++c)
+      queue.push(~std::uint64_t{0});
+  }
+  for (std::size_t t = producers; t < threads.size(); ++t)
+    threads[t].join();
+
+  EXPECT_TRUE(ordered.load());
+  EXPECT_EQ(popped.load(), total);
+  for (auto &s : seen)
+    ASSERT_EQ(s.load(), 1);
+}
+
+} // namespace
+
+TEST(ms_queue_test, linearizability_test) {
+  {
+    lock_free::MSQueue<std::uint64_t, reclamation::HazardPointers> queue;
+    check_fifo<false>(queue, 3, 3, 20'000);
+  }
+  {
+    lock_free::MSQueue<std::uint64_t, reclamation::Epochs> queue;
+    check_fifo<false>(queue, 3, 3, 20'000);
+  }
+  {
+    lock_free::BlockingMSQueue<std::uint64_t> queue;
+    check_fifo<true>(queue, 3, 3, 20'000);
+  }
+}
+
+TEST(ms_queue_test, pool_test) {
+  // The pool's work queue is an MSQueue: many submitters at once.
+  thread_pool::ThreadPool pool(4);
+  std::vector<std::thread> submitters;
+  std::atomic<int> ran{0};
+  std::vector<std::future<void>> futures[4];
+  for (int s = 0; s < 4; ++s) {
+    submitters.emplace_back([&, s] {
+      for (int i = 0; i < 1000; ++i)
+        futures[s].push_back(pool.submit([&ran] { ran.fetch_add(1); }));
+    });
+  }
+  for (auto &t : submitters)
+    t.join();
+  for (auto &f : futures)
+    thread_pool::wait_all(pool, f);
+  EXPECT_EQ(ran.load(), 4000);
+}
+
+namespace {
+
+template <typename Queue, typename Pop>
+double throughput(int producers, int consumers, int per_producer, Pop pop) {
+  Queue queue;
+  std::atomic<int> remaining{producers * per_producer};
+  auto sta = std::chrono::steady_clock::now();
+
+  std::vector<std::thread> threads;
+  for (int p = 0; p < producers; ++p) {
+    threads.emplace_back([&queue, per_producer] {
+      for (int i = 0; i < per_producer; ++i)
+        queue.push(i);
+    });
+  }
+  for (int c = 0; c < consumers; ++c) {
+    threads.emplace_back([&] {
+      int value;
+      while (remaining.load(std::memory_order_relaxed) > 0) {
+        if (pop(queue, value))
+          remaining.fetch_sub(1, std::memory_order_relaxed);
+      }
+    });
+  }
+  for (auto &t : threads)
+    t.join();
+
+  std::chrono::duration<double> dur = std::chrono::steady_clock::now() - sta;
+  return producers * per_producer / dur.count();
+}
+
+auto spin_pop = [](auto &queue, int &value) {
+  if (queue.try_pop(value))
+    return true;
+  std::this_thread::yield();
+  return false;
+};
+
+} // namespace
+
+TEST(ms_queue_test, benchmark) {
+  constexpr int per_producer = 200'000;
+
+  for (auto [producers, consumers] : {std::pair{1, 1}, {2, 2}, {4, 4}}) {
+    std::cout << producers << " producers, " << consumers << " consumers (M items/s):"
+              << std::endl;
+    std::cout << "  ThreadSafeQueue try_pop: "
+              << throughput<thread_pool::ThreadSafeQueue<int>>(producers, consumers,
+                                                               per_producer, spin_pop) / 1e6
+              << std::endl;
+    std::cout << "  MSQueue, hazard pointers: "
+              << throughput<lock_free::MSQueue<int, reclamation::HazardPointers>>(
+                     producers, consumers, per_producer, spin_pop) / 1e6
+              << std::endl;
+    std::cout << "  MSQueue, epochs: "
+              << throughput<lock_free::MSQueue<int, reclamation::Epochs>>(
+                     producers, consumers, per_producer, spin_pop) / 1e6
+              << std::endl;
+  }
+}
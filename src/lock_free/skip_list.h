@@ -0,0 +1,351 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <new>
+#include <optional>
+#include <utility>
+
+#include "reclamation/epoch.h"
+#include "rng/xorshift.h"
+
+namespace lock_free {
+
+// Lock-free ordered map: a skip list in the style of Fraser and of Herlihy
+// & Shavit's LockFreeSkipList.
+//
+// Every node is linked at level 0 and, with probability 2^-i, at level i.
+// A node is removed by marking the low bit of its own next pointers, top
+// level first; the mark on level 0 is what erases it, and whichever search
+// next passes the node unlinks it. Lookups and iteration never write: they
+// step over marked nodes.
+//
+//   lock_free::SkipListMap<std::string, int> book;
+//   book.insert("Dijkstra", 1972);
+//   if (auto year = book.find("Dijkstra")) ...
+//   for (auto [name, year] : book.range("A", "M")) ...
+//
+// Entries are immutable once inserted; to change a value, erase the key
+// and insert it again. Every operation pins the epoch domain, and removed
+// nodes are retired to it.
+template <typename K, typename V, typename Compare = std::less<K>>
+class SkipListMap {
+  using Link = std::atomic<std::uintptr_t>;
+
+  static constexpr int max_height = 20;
+
+  // The tower of `height` links is allocated right after the node.
+  struct alignas(Link) Node {
+    Node(int height, K key, V value)
+        : key(std::move(key)), value(std::move(value)), height(height) {}
+
+    Link *next() const { return std::launder(reinterpret_cast<Link *>(const_cast<Node *>(this) + 1)); }
+
+    const K key;
+    const V value;
+    const int height;
+    // The inserter and the eraser each drop one once they are done linking
+    // or unlinking; the last one retires the node.
+    std::atomic<int> owners{2};
+  };
+
+public:
+  class Range;
+
+  explicit SkipListMap(reclamation::EpochDomain &domain = reclamation::EpochDomain::global(),
+                       Compare comp = Compare())
+      : domain(domain), comp(std::move(comp)) {}
+
+  // No thread may be using the map any more.
+  ~SkipListMap() {
+    for (Node *n = ptr(head[0].load()); n != nullptr;) {
+      Node *next = ptr(n->next()[0].load());
+      destroy(n);
+      n = next;
+    }
+  }
+
+  SkipListMap(const SkipListMap &) = delete;
+  SkipListMap &operator=(const SkipListMap &) = delete;
+
+  // Returns false, and leaves the map alone, if `key` is already present.
+  bool insert(K key, V value) {
+    reclamation::EpochGuard guard(domain);
+    Link *preds[max_height];
+    Node *succs[max_height];
+    Node *node = create(random_height(), std::move(key), std::move(value));
+
+    for (;;) {
+      if (search(node->key, preds, succs) != nullptr) {
+        destroy(node);
+        return false;
+      }
+      for (int i = 0; i < node->height; ++i)
+        node->next()[i].store(link(succs[i]), std::memory_order_relaxed);
+      std::uintptr_t expected = link(succs[0]);
+      if (preds[0][0].compare_exchange_strong(expected, link(node), std::memory_order_release,
+                                              std::memory_order_relaxed))
+        break;
+    }
+    count.fetch_add(1, std::memory_order_relaxed);
+
+    link_upper(node, preds, succs);
+    // An erase that marked the node while we were linking it may have
+    // searched before our last link went in; unlink what we added.
+    if (marked(node->next()[0].load(std::memory_order_acquire)))
+      search(node->key, preds, succs);
+    release(node);
+    return true;
+  }
+
+  bool erase(const K &key) {
+    reclamation::EpochGuard guard(domain);
+    Link *preds[max_height];
+    Node *succs[max_height];
+    Node *node = search(key, preds, succs);
+    if (node == nullptr)
+      return false;
+
+    for (int level = node->height - 1; level > 0; --level)
+      node->next()[level].fetch_or(1, std::memory_order_acq_rel);
+    if (marked(node->next()[0].fetch_or(1, std::memory_order_acq_rel)))
+      return false; // another erase got there first
+    count.fetch_sub(1, std::memory_order_relaxed);
+
+    search(key, preds, succs);
+    release(node);
+    return true;
+  }
+
+  [[nodiscard]] std::optional<V> find(const K &key) const {
+    reclamation::EpochGuard guard(domain);
+    Node *node = lower_bound_node(key);
+    if (node == nullptr || comp(key, node->key))
+      return std::nullopt;
+    return node->value;
+  }
+
+  [[nodiscard]] bool contains(const K &key) const { return find(key).has_value(); }
+
+  // The first entry whose key is not less than `key`.
+  [[nodiscard]] std::optional<std::pair<K, V>> lower_bound(const K &key) const {
+    reclamation::EpochGuard guard(domain);
+    Node *node = lower_bound_node(key);
+    if (node == nullptr)
+      return std::nullopt;
+    return std::pair<K, V>(node->key, node->value);
+  }
+
+  // Entries with keys in [lo, hi), or from lo on, in order. The range pins
+  // the calling thread until it is destroyed, so keep it short-lived and on
+  // one thread. Iteration is weakly consistent: it sees every entry present
+  // throughout, and may or may not see concurrent inserts and erases.
+  Range range(const K &lo, const K &hi) const { return Range(*this, lo, hi); }
+  Range range(const K &lo) const { return Range(*this, lo, std::nullopt); }
+  Range range() const { return Range(*this); }
+
+  // A snapshot; may be stale by the time it returns.
+  [[nodiscard]] std::size_t size() const {
+    auto n = count.load(std::memory_order_relaxed);
+    return n > 0 ? static_cast<std::size_t>(n) : 0;
+  }
+
+  [[nodiscard]] bool empty() const { return size() == 0; }
+
+private:
+  static Node *ptr(std::uintptr_t l) { return reinterpret_cast<Node *>(l & ~std::uintptr_t{1}); }
+  static std::uintptr_t link(Node *n) { return reinterpret_cast<std::uintptr_t>(n); }
+  static bool marked(std::uintptr_t l) { return (l & 1) != 0; }
+
+  static Node *create(int height, K key, V value) {
+    void *mem = ::operator new(sizeof(Node) + height * sizeof(Link));
+    Node *node;
+    try {
+      node = new (mem) Node(height, std::move(key), std::move(value));
+    } catch (...) {
+      ::operator delete(mem);
+      throw;
+    }
+    for (int i = 0; i < height; ++i)
+      new (static_cast<void *>(reinterpret_cast<Link *>(node + 1) + i)) Link(0);
+    return node;
+  }
+
+  static void destroy(void *p) {
+    static_cast<Node *>(p)->~Node();
+    ::operator delete(p);
+  }
+
+  // Geometric with p = 1/2, capped at max_height.
+  static int random_height() {
+    return 1 + std::countr_zero(rng::thread_random() | (std::uint64_t{1} << (max_height - 1)));
+  }
+
+  void release(Node *node) {
+    if (node->owners.fetch_sub(1, std::memory_order_acq_rel) == 1)
+      domain.retire(node, &destroy);
+  }
+
+  // Fills preds (the towers whose links precede `key`) and succs (what those
+  // links point to) on every level, unlinking marked nodes on the way.
+  // Returns the node with `key` if one is linked at level 0.
+  Node *search(const K &key, Link **preds, Node **succs) {
+    while (!try_search(key, preds, succs)) {
+    }
+    Node *n = succs[0];
+    return n != nullptr && !comp(key, n->key) ? n : nullptr;
+  }
+
+  // False if an unlink lost a race and the search has to start over.
+  bool try_search(const K &key, Link **preds, Node **succs) {
+    Link *pred = head;
+    for (int level = max_height - 1; level >= 0; --level) {
+      std::uintptr_t first = pred[level].load(std::memory_order_acquire);
+      if (marked(first))
+        return false; // pred is being erased
+      Node *curr = ptr(first);
+      while (curr != nullptr) {
+        std::uintptr_t succ = curr->next()[level].load(std::memory_order_acquire);
+        if (marked(succ)) {
+          std::uintptr_t expected = link(curr);
+          if (!pred[level].compare_exchange_strong(expected, succ & ~std::uintptr_t{1},
+                                                   std::memory_order_acq_rel,
+                                                   std::memory_order_relaxed))
+            return false;
+          curr = ptr(succ);
+          continue;
+        }
+        if (!comp(curr->key, key))
+          break;
+        pred = curr->next();
+        curr = ptr(succ);
+      }
+      preds[level] = pred;
+      succs[level] = curr;
+    }
+    return true;
+  }
+
+  // Links a node that is already at level 0 into its upper levels. Stops
+  // early if the node is erased meanwhile.
+  void link_upper(Node *node, Link **preds, Node **succs) {
+    for (int level = 1; level < node->height; ++level) {
+      for (;;) {
+        std::uintptr_t old = node->next()[level].load(std::memory_order_acquire);
+        if (marked(old))
+          return;
+        if (old != link(succs[level]) &&
+            !node->next()[level].compare_exchange_strong(old, link(succs[level]),
+                                                         std::memory_order_release,
+                                                         std::memory_order_relaxed))
+          continue;
+        std::uintptr_t expected = link(succs[level]);
+        if (preds[level][level].compare_exchange_strong(expected, link(node),
+                                                        std::memory_order_release,
+                                                        std::memory_order_relaxed))
+          break;
+        if (search(node->key, preds, succs) != node)
+          return;
+      }
+    }
+  }
+
+  // The first node not less than `key` that is not marked; read-only.
+  Node *lower_bound_node(const K &key) const {
+    const Link *pred = head;
+    Node *curr = nullptr;
+    for (int level = max_height - 1; level >= 0; --level) {
+      curr = ptr(pred[level].load(std::memory_order_acquire));
+      while (curr != nullptr) {
+        std::uintptr_t succ = curr->next()[level].load(std::memory_order_acquire);
+        if (marked(succ)) {
+          curr = ptr(succ);
+          continue;
+        }
+        if (!comp(curr->key, key))
+          break;
+        pred = curr->next();
+        curr = ptr(succ);
+      }
+    }
+    return curr;
+  }
+
+  // The first unmarked node after n at level 0.
+  static Node *next_live(Node *n) {
+    Node *curr = ptr(n->next()[0].load(std::memory_order_acquire));
+    while (curr != nullptr) {
+      std::uintptr_t succ = curr->next()[0].load(std::memory_order_acquire);
+      if (!marked(succ))
+        break;
+      curr = ptr(succ);
+    }
+    return curr;
+  }
+
+  reclamation::EpochDomain &domain;
+  Compare comp;
+  Link head[max_height]{};
+  std::atomic<std::ptrdiff_t> count{0};
+
+public:
+  class Range {
+  public:
+    class iterator {
+    public:
+      using value_type = std::pair<const K &, const V &>;
+
+      value_type operator*() const { return {node->key, node->value}; }
+
+      iterator &operator++() {
+        node = range->clip(next_live(node));
+        return *this;
+      }
+
+      bool operator==(const iterator &other) const { return node == other.node; }
+
+    private:
+      friend class Range;
+      iterator(const Range *range, Node *node) : range(range), node(node) {}
+
+      const Range *range;
+      Node *node;
+    };
+
+    Range(const Range &) = delete;
+    Range &operator=(const Range &) = delete;
+
+    iterator begin() const { return iterator(this, first); }
+    iterator end() const { return iterator(this, nullptr); }
+
+  private:
+    friend class SkipListMap;
+
+    Range(const SkipListMap &map, const K &lo, std::optional<K> hi)
+        : guard(map.domain), map(map), hi(std::move(hi)) {
+      first = clip(map.lower_bound_node(lo));
+    }
+
+    explicit Range(const SkipListMap &map) : guard(map.domain), map(map) {
+      std::uintptr_t l = map.head[0].load(std::memory_order_acquire);
+      first = ptr(l);
+      if (first != nullptr && marked(first->next()[0].load(std::memory_order_acquire)))
+        first = next_live(first);
+    }
+
+    Node *clip(Node *n) const {
+      return n != nullptr && hi && !map.comp(n->key, *hi) ? nullptr : n;
+    }
+
+    reclamation::EpochGuard guard;
+    const SkipListMap &map;
+    std::optional<K> hi;
+    Node *first = nullptr;
+  };
+};
+
+} // namespace lock_free
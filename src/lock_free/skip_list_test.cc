@@ -0,0 +1,263 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <barrier>
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "lock_free/skip_list.h"
+
+TEST(skip_list_test, basic_test) {
+  lock_free::SkipListMap<std::string, int> tele_book;
+  EXPECT_TRUE(tele_book.empty());
+  EXPECT_TRUE(tele_book.insert("Dijkstra", 1972));
+  EXPECT_TRUE(tele_book.insert("Scott", 1976));
+  EXPECT_TRUE(tele_book.insert("Ritchie", 1983));
+  EXPECT_FALSE(tele_book.insert("Scott", 1968));
+  EXPECT_EQ(tele_book.size(), 3);
+
+  EXPECT_EQ(*tele_book.find("Scott"), 1976);
+  EXPECT_FALSE(tele_book.find("Bjarne").has_value());
+
+  // Values are immutable: an update is an erase and an insert.
+  EXPECT_TRUE(tele_book.erase("Scott"));
+  EXPECT_FALSE(tele_book.erase("Scott"));
+  EXPECT_TRUE(tele_book.insert("Scott", 1968));
+  EXPECT_TRUE(tele_book.insert("Bjarne", 1965));
+  EXPECT_EQ(*tele_book.find("Scott"), 1968);
+
+  EXPECT_EQ(tele_book.lower_bound("C")->first, "Dijkstra");
+  EXPECT_EQ(tele_book.lower_bound("Ritchie")->first, "Ritchie");
+  EXPECT_FALSE(tele_book.lower_bound("Z").has_value());
+
+  std::vector<std::string> names;
+  for (auto [name, year] : tele_book.range())
+    names.push_back(name);
+  EXPECT_EQ(names, (std::vector<std::string>{"Bjarne", "Dijkstra", "Ritchie", "Scott"}));
+}
+
+TEST(skip_list_test, range_test) {
+  lock_free::SkipListMap<int, int> map;
+  for (int i = 999; i >= 0; --i)
+    EXPECT_TRUE(map.insert(i, i * i));
+  for (int i = 0; i < 1000; i += 2)
+    EXPECT_TRUE(map.erase(i));
+
+  std::vector<int> keys;
+  for (auto [key, value] : map.range(100, 120)) {
+    EXPECT_EQ(value, key * key);
+    keys.push_back(key);
+  }
+  EXPECT_EQ(keys, (std::vector<int>{101, 103, 105, 107, 109, 111, 113, 115, 117, 119}));
+
+  int n = 0;
+  for (auto entry : map.range(990))
+    n += entry.first > 0;
+  EXPECT_EQ(n, 5);
+  EXPECT_EQ(map.range(2000).begin(), map.range(2000).end());
+}
+
+TEST(skip_list_test, concurrent_test) {
+  constexpr int threads = 4;
+  constexpr int keys = 20'000;
+  lock_free::SkipListMap<int, int> map;
+  std::atomic<int> inserted{0};
+  std::atomic<int> erased{0};
+  std::atomic<bool> sorted{true};
+  std::atomic<bool> done{false};
+  std::barrier phase(threads);
+
+  // Every thread inserts and then erases every key: each must succeed
+  // exactly once overall. A reader checks that scans stay in order.
+  std::thread reader([&] {
+    while (!done.load()) {
+      std::optional<int> last;
+      for (auto [key, value] : map.range()) {
+        if (last && *last >= key)
+          sorted = false;
+        if (value != -key)
+          sorted = false;
+        last = key;
+      }
+    }
+  });
+
+  std::vector<std::thread> workers;
+  for (int t = 0; t < threads; ++t) {
+    workers.emplace_back([&, t] {
+      std::mt19937 rng(t);
+      std::vector<int> order(keys);
+      for (int i = 0; i < keys; ++i)
+        order[i] = i;
+      std::shuffle(order.begin(), order.end(), rng);
+      for (int k : order)
+        inserted += map.insert(k, -k);
+      phase.arrive_and_wait();
+      std::shuffle(order.begin(), order.end(), rng);
+      for (int k : order)
+        erased += map.erase(k);
+    });
+  }
+  for (auto &w : workers)
+    w.join();
+  done = true;
+  reader.join();
+
+  EXPECT_EQ(inserted.load(), keys);
+  EXPECT_EQ(erased.load(), keys);
+  EXPECT_TRUE(sorted.load());
+  EXPECT_TRUE(map.empty());
+  EXPECT_EQ(map.range().begin(), map.range().end());
+}
+
+TEST(skip_list_test, churn_test) {
+  // Inserts and erases racing on a few keys, so that erases hit nodes whose
+  // upper levels are still being linked.
+  constexpr int keys = 64;
+  lock_free::SkipListMap<int, int> map;
+  std::atomic<int> balance{0};
+
+  std::vector<std::thread> workers;
+  for (int t = 0; t < 4; ++t) {
+    workers.emplace_back([&, t] {
+      std::mt19937 rng(t);
+      for (int i = 0; i < 50'000; ++i) {
+        int k = static_cast<int>(rng() % keys);
+        if (rng() % 2 == 0)
+          balance += map.insert(k, -k);
+        else
+          balance -= map.erase(k);
+      }
+    });
+  }
+  for (auto &w : workers)
+    w.join();
+
+  int present = 0;
+  for (auto [key, value] : map.range()) {
+    EXPECT_TRUE(map.contains(key));
+    ++present;
+  }
+  EXPECT_EQ(present, balance.load());
+  EXPECT_EQ(map.size(), static_cast<std::size_t>(present));
+}
+
+namespace {
+
+// Baseline: the tele_book pattern, std::map behind a shared_timed_mutex.
+template <typename K, typename V>
+class LockedMap {
+public:
+  bool insert(const K &key, const V &value) {
+    std::lock_guard<std::shared_timed_mutex> lk(mutex);
+    return map.emplace(key, value).second;
+  }
+
+  bool erase(const K &key) {
+    std::lock_guard<std::shared_timed_mutex> lk(mutex);
+    return map.erase(key) > 0;
+  }
+
+  std::optional<V> find(const K &key) const {
+    std::shared_lock<std::shared_timed_mutex> lk(mutex);
+    auto it = map.find(key);
+    if (it == map.end())
+      return std::nullopt;
+    return it->second;
+  }
+
+  template <typename F>
+  void scan(const K &lo, int n, F f) const {
+    std::shared_lock<std::shared_timed_mutex> lk(mutex);
+    for (auto it = map.lower_bound(lo); it != map.end() && n-- > 0; ++it)
+      f(it->first, it->second);
+  }
+
+private:
+  mutable std::shared_timed_mutex mutex;
+  std::map<K, V> map;
+};
+
+template <typename K, typename V>
+struct SkipList : lock_free::SkipListMap<K, V> {
+  template <typename F>
+  void scan(const K &lo, int n, F f) const {
+    for (auto [key, value] : this->range(lo)) {
+      if (n-- == 0)
+        break;
+      f(key, value);
+    }
+  }
+};
+
+struct Mix {
+  const char *name;
+  int find; // percent
+  int scan; // percent, 16 entries each; the rest is split between insert and erase
+};
+
+template <typename Map>
+double run(const Mix &mix, int threads, int ops_per_thread) {
+  constexpr int key_space = 1 << 16;
+  Map map;
+  for (int k = 0; k < key_space; k += 2)
+    map.insert(k, k);
+
+  std::atomic<long long> sink{0};
+  auto sta = std::chrono::steady_clock::now();
+  std::vector<std::thread> workers;
+  for (int t = 0; t < threads; ++t) {
+    workers.emplace_back([&, t] {
+      std::mt19937 rng(t);
+      long long local = 0;
+      for (int i = 0; i < ops_per_thread; ++i) {
+        int key = static_cast<int>(rng() % key_space);
+        int dice = static_cast<int>(rng() % 100);
+        if (dice < mix.find) {
+          local += map.find(key).value_or(0);
+        } else if (dice < mix.find + mix.scan) {
+          map.scan(key, 16, [&local](int k, int) { local += k; });
+        } else if (dice % 2 == 0) {
+          map.insert(key, key);
+        } else {
+          map.erase(key);
+        }
+      }
+      sink += local;
+    });
+  }
+  for (auto &w : workers)
+    w.join();
+
+  std::chrono::duration<double> dur = std::chrono::steady_clock::now() - sta;
+  return threads * ops_per_thread / dur.count();
+}
+
+} // namespace
+
+TEST(skip_list_test, benchmark) {
+  constexpr int ops_per_thread = 50'000;
+  const Mix mixes[] = {
+      {"90% find, 10% update", 90, 0},
+      {"50% find, 50% update", 50, 0},
+      {"70% find, 20% scan, 10% update", 70, 20},
+  };
+
+  for (const auto &mix : mixes) {
+    std::cout << mix.name << " (M ops/s):" << std::endl;
+    for (int threads : {1, 2, 4}) {
+      std::cout << "  " << threads << " threads: skip list "
+                << run<SkipList<int, int>>(mix, threads, ops_per_thread) / 1e6
+                << ", std::map + shared_timed_mutex "
+                << run<LockedMap<int, int>>(mix, threads, ops_per_thread) / 1e6 << std::endl;
+    }
+  }
+}
@@ -0,0 +1,323 @@
+#pragma once
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <limits>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "parallel_fill/parallel_fill.h"
+#include "thread_pool/thread_pool.h"
+#include "topology/topology.h"
+
+namespace numa {
+
+// NUMA-aware placement of large arrays.
+//
+// A page lands on the node of the thread that first writes it (first touch)
+// unless a memory policy says otherwise. A vector that the main thread
+// allocates and zeroes therefore lives entirely on one node, and every
+// worker on another socket reads it remotely.
+//
+// This header uses the kernel's memory policy calls directly (mbind,
+// set_mempolicy, get_mempolicy through syscall(2)), so there is no libnuma
+// dependency. On single-node machines, or kernels built without NUMA, the
+// policy calls are skipped or fail harmlessly and placement falls back to
+// first touch by the thread that will use the data.
+
+namespace detail {
+
+// <linux/mempolicy.h>
+constexpr int mpol_default = 0;
+constexpr int mpol_preferred = 1;
+constexpr int mpol_bind = 2;
+constexpr int mpol_interleave = 3;
+constexpr unsigned long mpol_f_node = 1 << 0;
+constexpr unsigned long mpol_f_addr = 1 << 1;
+constexpr unsigned mpol_mf_move = 1 << 1;
+
+constexpr int max_nodes = 1024;
+using NodeMask = std::array<unsigned long, max_nodes / (8 * sizeof(unsigned long))>;
+
+inline NodeMask mask_of(const std::vector<int> &nodes) {
+  NodeMask mask{};
+  for (int node : nodes) {
+    if (node >= 0 && node < max_nodes)
+      mask[node / (8 * sizeof(unsigned long))] |= 1ul << (node % (8 * sizeof(unsigned long)));
+  }
+  return mask;
+}
+
+inline long mbind(void *addr, std::size_t len, int mode, const NodeMask *mask, unsigned flags) {
+  return ::syscall(SYS_mbind, addr, len, mode, mask ? mask->data() : nullptr,
+                   mask ? static_cast<unsigned long>(max_nodes) : 0ul, flags);
+}
+
+inline long set_mempolicy(int mode, const NodeMask *mask) {
+  return ::syscall(SYS_set_mempolicy, mode, mask ? mask->data() : nullptr,
+                   mask ? static_cast<unsigned long>(max_nodes) : 0ul);
+}
+
+inline std::size_t page_size() {
+  static const std::size_t size = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+  return size;
+}
+
+} // namespace detail
+
+// More than one node and a kernel that implements memory policies.
+inline bool available() {
+  static const bool supported = [] {
+    int mode = 0;
+    detail::NodeMask mask{};
+    bool has_policy = ::syscall(SYS_get_mempolicy, &mode, mask.data(),
+                                static_cast<unsigned long>(detail::max_nodes),
+                                nullptr, 0ul) == 0;
+    return has_policy && topology::Topology::system().nodes() > 1;
+  }();
+  return supported;
+}
+
+// Node that holds the page at `addr`, or -1 if unknown (not faulted in yet,
+// or no NUMA support).
+inline int node_of(const void *addr) {
+  int node = -1;
+  if (::syscall(SYS_get_mempolicy, &node, nullptr, 0ul, const_cast<void *>(addr),
+                detail::mpol_f_node | detail::mpol_f_addr) != 0)
+    return -1;
+  return node;
+}
+
+// Places the whole pages inside [addr, addr + len) on `node`; pages already
+// faulted in elsewhere are migrated. False if the kernel refused.
+inline bool bind(void *addr, std::size_t len, int node) {
+  auto page = detail::page_size();
+  auto first = (reinterpret_cast<std::uintptr_t>(addr) + page - 1) / page * page;
+  auto last = (reinterpret_cast<std::uintptr_t>(addr) + len) / page * page;
+  if (first >= last)
+    return true;
+  auto mask = detail::mask_of({node});
+  return detail::mbind(reinterpret_cast<void *>(first), last - first, detail::mpol_bind,
+                       &mask, detail::mpol_mf_move) == 0;
+}
+
+// Spreads the pages of [addr, addr + len) round-robin over `nodes`.
+inline bool interleave(void *addr, std::size_t len, const std::vector<int> &nodes) {
+  auto mask = detail::mask_of(nodes);
+  return detail::mbind(addr, len, detail::mpol_interleave, &mask, 0) == 0;
+}
+
+// Makes the calling thread allocate from `node` first while in scope.
+class ScopedPreferredNode {
+public:
+  explicit ScopedPreferredNode(int node) {
+    auto mask = detail::mask_of({node});
+    active = detail::set_mempolicy(detail::mpol_preferred, &mask) == 0;
+  }
+
+  ~ScopedPreferredNode() {
+    if (active)
+      detail::set_mempolicy(detail::mpol_default, nullptr);
+  }
+
+  ScopedPreferredNode(const ScopedPreferredNode &) = delete;
+  ScopedPreferredNode &operator=(const ScopedPreferredNode &) = delete;
+
+  [[nodiscard]] bool applied() const { return active; }
+
+private:
+  bool active;
+};
+
+// Where NumaAllocator puts its pages.
+struct Placement {
+  enum class Kind { first_touch, on_node, interleaved };
+
+  static Placement first_touch() { return {Kind::first_touch, -1}; }
+  static Placement on_node(int node) { return {Kind::on_node, node}; }
+  static Placement interleaved() { return {Kind::interleaved, -1}; }
+
+  Kind kind;
+  int node;
+
+  friend bool operator==(const Placement &, const Placement &) = default;
+};
+
+// Allocator for large arrays: memory comes straight from mmap with the
+// requested policy applied before any page is touched. numa_vector adds
+// parallel_fill's default-initialization, so nothing faults the pages in on
+// the allocating thread. With Placement::first_touch the pages go wherever
+// the initializing threads run -- see first_touch() below.
+template <typename T>
+class NumaAllocator {
+public:
+  using value_type = T;
+
+  NumaAllocator() noexcept : placement(Placement::first_touch()) {}
+  explicit NumaAllocator(Placement p) noexcept : placement(p) {}
+
+  template <typename U>
+  NumaAllocator(const NumaAllocator<U> &other) noexcept : placement(other.placement) {}
+
+  T *allocate(std::size_t n) {
+    if (n > std::numeric_limits<std::size_t>::max() / sizeof(T))
+      throw std::bad_array_new_length();
+    if (n == 0)
+      return nullptr;
+    std::size_t bytes = n * sizeof(T);
+    void *p = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED)
+      throw std::bad_alloc();
+
+    // A policy the kernel refuses leaves the pages to first touch.
+    if (placement.kind == Placement::Kind::on_node)
+      bind(p, bytes, placement.node);
+    else if (placement.kind == Placement::Kind::interleaved)
+      interleave(p, bytes, all_nodes());
+    return static_cast<T *>(p);
+  }
+
+  void deallocate(T *p, std::size_t n) noexcept {
+    if (p)
+      ::munmap(p, n * sizeof(T));
+  }
+
+  template <typename U>
+  friend class NumaAllocator;
+
+  friend bool operator==(const NumaAllocator &a, const NumaAllocator &b) {
+    return a.placement == b.placement;
+  }
+
+private:
+  static std::vector<int> all_nodes() {
+    std::vector<int> nodes;
+    for (const auto &cpu : topology::Topology::system().cpus())
+      if (std::find(nodes.begin(), nodes.end(), cpu.node) == nodes.end())
+        nodes.push_back(cpu.node);
+    return nodes;
+  }
+
+  Placement placement;
+};
+
+template <typename T>
+using numa_vector = parallel_fill::uninitialized_vector<T, NumaAllocator<T>>;
+
+// One thread pool per NUMA node, its workers pinned to that node's cpus.
+class NodePools {
+public:
+  explicit NodePools(const topology::Topology &topo = topology::Topology::system()) {
+    for (const auto &cpu : topo.cpus())
+      if (std::find(node_ids.begin(), node_ids.end(), cpu.node) == node_ids.end())
+        node_ids.push_back(cpu.node);
+    std::sort(node_ids.begin(), node_ids.end());
+
+    for (int node : node_ids) {
+      auto local = topo.node(node);
+      pools.push_back(std::make_unique<thread_pool::ThreadPool>(
+          static_cast<unsigned>(local.cpus().size()), topology::Pinning::compact, local));
+    }
+  }
+
+  [[nodiscard]] std::size_t size() const { return pools.size(); }
+  [[nodiscard]] int node_id(std::size_t i) const { return node_ids[i]; }
+  thread_pool::ThreadPool &pool(std::size_t i) { return *pools[i]; }
+
+  [[nodiscard]] std::size_t threads() const {
+    std::size_t n = 0;
+    for (const auto &p : pools)
+      n += p->size();
+    return n;
+  }
+
+private:
+  std::vector<int> node_ids;
+  std::vector<std::unique_ptr<thread_pool::ThreadPool>> pools;
+};
+
+// Part of an array owned by one node: elements [first, last) live on, and
+// are processed by, pools.pool(pool).
+struct Slice {
+  std::size_t pool;
+  std::size_t first;
+  std::size_t last;
+};
+
+// Splits n elements of T over the node pools in proportion to their thread
+// counts, with slice boundaries on page boundaries so that no page is
+// shared between two nodes.
+template <typename T>
+std::vector<Slice> node_slices(NodePools &pools, std::size_t n) {
+  std::size_t per_page = std::max<std::size_t>(1, detail::page_size() / sizeof(T));
+  std::size_t total = pools.threads();
+  std::vector<Slice> slices;
+  std::size_t first = 0, threads_before = 0;
+  for (std::size_t i = 0; i < pools.size(); ++i) {
+    threads_before += pools.pool(i).size();
+    std::size_t last = i + 1 == pools.size()
+        ? n
+        : std::min(n, n * threads_before / total / per_page * per_page);
+    slices.push_back({i, first, std::max(first, last)});
+    first = std::max(first, last);
+  }
+  return slices;
+}
+
+// Runs f(first, last) for every slice on its node's pool, split into one
+// chunk per worker there, and returns the results in index order.
+template <typename F>
+auto for_each_chunk(NodePools &pools, const std::vector<Slice> &slices, F f) {
+  using R = std::invoke_result_t<F &, std::size_t, std::size_t>;
+  std::vector<std::future<R>> futures;
+  for (const auto &slice : slices) {
+    auto &pool = pools.pool(slice.pool);
+    std::size_t chunks = pool.size(), len = slice.last - slice.first;
+    for (std::size_t c = 0; c < chunks; ++c) {
+      std::size_t first = slice.first + len * c / chunks;
+      std::size_t last = slice.first + len * (c + 1) / chunks;
+      futures.push_back(pool.submit([f, first, last]() mutable { return f(first, last); }));
+    }
+  }
+
+  if constexpr (std::is_void_v<R>) {
+    for (auto &fut : futures)
+      fut.get();
+  } else {
+    std::vector<R> results;
+    results.reserve(futures.size());
+    for (auto &fut : futures)
+      results.push_back(fut.get());
+    return results;
+  }
+}
+
+// Parallel first touch: binds each slice of data[0, n) to its node (when the
+// kernel supports it) and has that node's workers run init(first, last) on
+// it, so that even without mbind the pages are faulted in where they will be
+// read. Returns the slices for the processing step to reuse.
+template <typename T, typename F>
+std::vector<Slice> first_touch(NodePools &pools, T *data, std::size_t n, F init) {
+  auto slices = node_slices<T>(pools, n);
+  if (available()) {
+    for (const auto &slice : slices)
+      bind(data + slice.first, (slice.last - slice.first) * sizeof(T),
+           pools.node_id(slice.pool));
+  }
+  for_each_chunk(pools, slices, init);
+  return slices;
+}
+
+} // namespace numa
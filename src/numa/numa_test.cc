@@ -0,0 +1,143 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <numeric>
+#include <vector>
+
+#include "numa/numa.h"
+
+TEST(numa_test, slices_test) {
+  numa::NodePools pools;
+  ASSERT_GE(pools.size(), 1u);
+
+  constexpr std::size_t n = 1'000'003;
+  auto slices = numa::node_slices<int>(pools, n);
+  ASSERT_EQ(slices.size(), pools.size());
+
+  std::size_t per_page = numa::detail::page_size() / sizeof(int);
+  std::size_t expected_first = 0;
+  for (const auto &slice : slices) {
+    EXPECT_EQ(slice.first, expected_first);
+    EXPECT_EQ(slice.first % per_page, 0u);
+    expected_first = slice.last;
+  }
+  EXPECT_EQ(expected_first, n);
+}
+
+TEST(numa_test, first_touch_test) {
+  numa::NodePools pools;
+  constexpr std::size_t n = 1 << 22;
+
+  numa::numa_vector<long long> values(n);
+  auto slices = numa::first_touch(pools, values.data(), n, [&](std::size_t first, std::size_t last) {
+    for (auto i = first; i < last; ++i)
+      values[i] = static_cast<long long>(i);
+  });
+
+  auto parts = numa::for_each_chunk(pools, slices, [&](std::size_t first, std::size_t last) {
+    return std::accumulate(values.begin() + first, values.begin() + last, 0LL);
+  });
+  EXPECT_EQ(std::accumulate(parts.begin(), parts.end(), 0LL),
+            static_cast<long long>(n) * (n - 1) / 2);
+
+  // Each slice starts on its own node (when the kernel can tell).
+  for (const auto &slice : slices) {
+    int node = numa::node_of(values.data() + slice.first);
+    if (node >= 0) {
+      EXPECT_EQ(node, pools.node_id(slice.pool));
+    }
+  }
+}
+
+TEST(numa_test, allocator_test) {
+  const auto &cpus = topology::Topology::system().cpus();
+  int node = cpus.front().node;
+
+  numa::numa_vector<int> bound(1 << 20, numa::NumaAllocator<int>(numa::Placement::on_node(node)));
+  std::iota(bound.begin(), bound.end(), 0);
+  EXPECT_EQ(bound[12345], 12345);
+  int where = numa::node_of(bound.data());
+  if (where >= 0) {
+    EXPECT_EQ(where, node);
+  }
+
+  numa::numa_vector<int> spread(1 << 20, 7, numa::NumaAllocator<int>(numa::Placement::interleaved()));
+  EXPECT_EQ(std::accumulate(spread.begin(), spread.end(), 0LL), 7LL << 20);
+
+  numa::ScopedPreferredNode preferred(node);
+  std::vector<int> plain(1 << 20, 1);
+  EXPECT_EQ(std::accumulate(plain.begin(), plain.end(), 0LL), 1LL << 20);
+}
+
+namespace {
+
+// GB/s reading `values` with the workers of pools.pool(reader).
+double read_bandwidth(numa::NodePools &pools, std::size_t reader,
+                      const numa::numa_vector<int> &values) {
+  std::vector<numa::Slice> all{{reader, 0, values.size()}};
+  auto sta = std::chrono::steady_clock::now();
+  auto parts = numa::for_each_chunk(pools, all, [&](std::size_t first, std::size_t last) {
+    return std::accumulate(values.begin() + first, values.begin() + last, 0LL);
+  });
+  std::chrono::duration<double> dur = std::chrono::steady_clock::now() - sta;
+  EXPECT_EQ(std::accumulate(parts.begin(), parts.end(), 0LL),
+            static_cast<long long>(values.size()));
+  return values.size() * sizeof(int) / dur.count() / 1e9;
+}
+
+} // namespace
+
+TEST(numa_test, benchmark) {
+  constexpr std::size_t size = 16'000'000;
+  numa::NodePools pools;
+  std::cout << pools.size() << " node(s), " << pools.threads() << " threads, NUMA policy "
+            << (numa::available() ? "available" : "unavailable") << "." << std::endl;
+
+  // Memory bound to one node, read from each node in turn.
+  for (std::size_t mem = 0; mem < pools.size(); ++mem) {
+    numa::numa_vector<int> values(
+        size, numa::NumaAllocator<int>(numa::Placement::on_node(pools.node_id(mem))));
+    numa::for_each_chunk(pools, {{mem, 0, size}}, [&](std::size_t first, std::size_t last) {
+      std::fill(values.begin() + first, values.begin() + last, 1);
+    });
+
+    for (std::size_t reader = 0; reader < pools.size(); ++reader) {
+      std::cout << "memory on node " << pools.node_id(mem) << ", read from node "
+                << pools.node_id(reader) << (mem == reader ? " (local): " : " (remote): ")
+                << read_bandwidth(pools, reader, values) << " GB/s." << std::endl;
+    }
+  }
+  if (pools.size() == 1)
+    std::cout << "remote: skipped, single node." << std::endl;
+
+  // The dot product over two vectors, filled by the main thread (all pages
+  // on its node) versus placed by first_touch().
+  auto dot = [&](const auto &v, const auto &w, const std::vector<numa::Slice> &slices) {
+    auto sta = std::chrono::steady_clock::now();
+    auto parts = numa::for_each_chunk(pools, slices, [&](std::size_t first, std::size_t last) {
+      return std::inner_product(v.begin() + first, v.begin() + last, w.begin() + first, 0LL);
+    });
+    std::chrono::duration<double, std::milli> dur = std::chrono::steady_clock::now() - sta;
+    EXPECT_EQ(std::accumulate(parts.begin(), parts.end(), 0LL), 2LL * size);
+    return dur.count();
+  };
+
+  auto slices = numa::node_slices<int>(pools, size);
+  {
+    std::vector<int> v(size, 1), w(size, 2);
+    std::cout << "dot product, main-thread first touch: " << dot(v, w, slices) << " ms."
+              << std::endl;
+  }
+  {
+    numa::numa_vector<int> v(size), w(size);
+    numa::first_touch(pools, v.data(), size, [&](std::size_t first, std::size_t last) {
+      std::fill(v.begin() + first, v.begin() + last, 1);
+    });
+    numa::first_touch(pools, w.data(), size, [&](std::size_t first, std::size_t last) {
+      std::fill(w.begin() + first, w.begin() + last, 2);
+    });
+    std::cout << "dot product, node-local first touch: " << dot(v, w, slices) << " ms."
+              << std::endl;
+  }
+}
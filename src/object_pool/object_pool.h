@@ -0,0 +1,279 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace object_pool {
+
+// Fixed-size object pool with per-thread magazines.
+//
+// Each thread keeps a magazine (a linked list of up to `magazine_size` free
+// slots) per pool, so allocate() and deallocate() are a thread_local lookup
+// and a pointer swap. A thread whose magazine runs dry takes a whole batch
+// from the pool's global free list; one whose magazine is full pushes the
+// whole magazine there. The global list is a lock-free stack of batches, so
+// a producer that only allocates and a consumer that only frees exchange
+// slots with one CAS per magazine. New slots are carved from chunks under a
+// mutex; chunks are only returned when the pool is destroyed.
+//
+// Magazines of threads that exit go back to the global list. Objects must
+// be destroyed before their pool.
+
+namespace detail {
+
+// What a free slot holds. The head of a batch also carries the link to the
+// next batch and the batch length.
+struct FreeNode {
+  FreeNode *next;
+  std::atomic<FreeNode *> next_batch;
+  std::size_t count;
+};
+
+// Treiber stack of batches. The top word packs a 48-bit pointer with a
+// 16-bit tag that changes on every update, so a pop that read a stale
+// next_batch fails its CAS instead of corrupting the list (ABA). Free nodes
+// live in chunks that stay mapped for the pool's lifetime, so reading
+// next_batch of a node that was popped meanwhile is harmless.
+class BatchStack {
+public:
+  void push(FreeNode *batch) {
+    auto old = top.load(std::memory_order_relaxed);
+    do {
+      batch->next_batch.store(pointer(old), std::memory_order_relaxed);
+    } while (!top.compare_exchange_weak(old, pack(batch, old), std::memory_order_release,
+                                        std::memory_order_relaxed));
+  }
+
+  FreeNode *pop() {
+    auto old = top.load(std::memory_order_acquire);
+    while (FreeNode *head = pointer(old)) {
+      FreeNode *next = head->next_batch.load(std::memory_order_relaxed);
+      if (top.compare_exchange_weak(old, pack(next, old), std::memory_order_acquire,
+                                    std::memory_order_acquire))
+        return head;
+    }
+    return nullptr;
+  }
+
+private:
+  static_assert(sizeof(void *) == 8, "BatchStack packs a tag into the top 16 pointer bits");
+  static constexpr std::uint64_t pointer_mask = (std::uint64_t{1} << 48) - 1;
+
+  static FreeNode *pointer(std::uint64_t word) {
+    return reinterpret_cast<FreeNode *>(word & pointer_mask);
+  }
+
+  static std::uint64_t pack(FreeNode *p, std::uint64_t old) {
+    return (reinterpret_cast<std::uint64_t>(p) & pointer_mask) +
+           (((old >> 48) + 1) << 48);
+  }
+
+  std::atomic<std::uint64_t> top{0};
+};
+
+// The part of a pool that outlives it while threads still hold magazines.
+struct Shared {
+  Shared(std::size_t slot_size, std::size_t slot_align, std::size_t magazine_size,
+         std::size_t chunk_slots)
+      : slot_size((std::max(slot_size, sizeof(FreeNode)) + slot_align - 1) / slot_align *
+                  slot_align),
+        slot_align(slot_align), magazine_size(std::max<std::size_t>(magazine_size, 1)),
+        chunk_slots(std::max(chunk_slots, this->magazine_size)) {}
+
+  ~Shared() {
+    for (void *chunk : chunks)
+      ::operator delete(chunk, std::align_val_t(slot_align));
+  }
+
+  // A fresh batch of magazine_size slots from the current chunk.
+  FreeNode *carve() {
+    std::lock_guard<std::mutex> lk(chunk_mutex);
+    if (carve_left < magazine_size) {
+      carve_cursor = static_cast<char *>(
+          ::operator new(chunk_slots * slot_size, std::align_val_t(slot_align)));
+      chunks.push_back(carve_cursor);
+      carve_left = chunk_slots;
+      capacity.fetch_add(chunk_slots, std::memory_order_relaxed);
+    }
+
+    FreeNode *head = nullptr;
+    for (std::size_t i = 0; i < magazine_size; ++i) {
+      head = ::new (carve_cursor) FreeNode{head, {nullptr}, 0};
+      carve_cursor += slot_size;
+    }
+    carve_left -= magazine_size;
+    head->count = magazine_size;
+    return head;
+  }
+
+  const std::uint64_t id = next_id.fetch_add(1, std::memory_order_relaxed);
+  const std::size_t slot_size;
+  const std::size_t slot_align;
+  const std::size_t magazine_size;
+  const std::size_t chunk_slots;
+  BatchStack global;
+  std::atomic<std::size_t> capacity{0};
+
+  std::mutex chunk_mutex;
+  std::vector<void *> chunks;
+  char *carve_cursor = nullptr;
+  std::size_t carve_left = 0;
+
+  static inline std::atomic<std::uint64_t> next_id{1};
+};
+
+struct Magazine {
+  std::uint64_t id;
+  std::weak_ptr<Shared> owner;
+  FreeNode *head = nullptr;
+  std::size_t count = 0;
+};
+
+// This thread's magazines, one per pool it has used. Pool ids are never
+// reused, so the entry of a destroyed pool is simply never matched again.
+struct ThreadMagazines {
+  std::vector<Magazine> magazines;
+  Magazine *last = nullptr;
+
+  ~ThreadMagazines() {
+    for (auto &m : magazines) {
+      if (m.head == nullptr)
+        continue;
+      if (auto owner = m.owner.lock()) {
+        m.head->count = m.count;
+        owner->global.push(m.head);
+      }
+    }
+  }
+
+  Magazine &find(const std::shared_ptr<Shared> &shared) {
+    std::uint64_t id = shared->id;
+    if (last != nullptr && last->id == id)
+      return *last;
+    for (auto &m : magazines)
+      if (m.id == id)
+        return *(last = &m);
+
+    std::erase_if(magazines, [](const Magazine &m) { return m.owner.expired(); });
+    return *(last = &magazines.emplace_back(Magazine{id, shared}));
+  }
+};
+
+inline Magazine &magazine(const std::shared_ptr<Shared> &shared) {
+  thread_local ThreadMagazines mags;
+  return mags.find(shared);
+}
+
+} // namespace detail
+
+template <typename T>
+class ObjectPool;
+
+// Returns an object to the pool it came from.
+template <typename T>
+struct PoolDeleter {
+  ObjectPool<T> *pool = nullptr;
+  void operator()(T *p) const noexcept { pool->destroy(p); }
+};
+
+// unique_ptr-style handle to a pooled object.
+template <typename T>
+using Pooled = std::unique_ptr<T, PoolDeleter<T>>;
+
+template <typename T>
+class ObjectPool {
+public:
+  explicit ObjectPool(std::size_t magazine_size = 64, std::size_t chunk_slots = 4096)
+      : shared(std::make_shared<detail::Shared>(sizeof(T), alignof(T), magazine_size,
+                                                chunk_slots)) {}
+
+  ObjectPool(const ObjectPool &) = delete;
+  ObjectPool &operator=(const ObjectPool &) = delete;
+
+  // Raw storage for one T.
+  void *allocate() {
+    auto &mag = detail::magazine(shared);
+    if (mag.head == nullptr) {
+      mag.head = shared->global.pop();
+      if (mag.head == nullptr)
+        mag.head = shared->carve();
+      mag.count = mag.head->count;
+    }
+    detail::FreeNode *node = mag.head;
+    mag.head = node->next;
+    --mag.count;
+    return node;
+  }
+
+  void deallocate(void *p) noexcept {
+    auto &mag = detail::magazine(shared);
+    if (mag.count == shared->magazine_size) {
+      mag.head->count = mag.count;
+      shared->global.push(mag.head);
+      mag.head = nullptr;
+      mag.count = 0;
+    }
+    mag.head = ::new (p) detail::FreeNode{mag.head, {nullptr}, 0};
+    ++mag.count;
+  }
+
+  template <typename... Args>
+  T *create(Args &&...args) {
+    void *p = allocate();
+    try {
+      return ::new (p) T(std::forward<Args>(args)...);
+    } catch (...) {
+      deallocate(p);
+      throw;
+    }
+  }
+
+  void destroy(T *p) noexcept {
+    if (p) {
+      p->~T();
+      deallocate(p);
+    }
+  }
+
+  template <typename... Args>
+  Pooled<T> make(Args &&...args) {
+    return Pooled<T>(create(std::forward<Args>(args)...), PoolDeleter<T>{this});
+  }
+
+  // Slots carved so far, free or not.
+  [[nodiscard]] std::size_t capacity() const {
+    return shared->capacity.load(std::memory_order_relaxed);
+  }
+
+private:
+  std::shared_ptr<detail::Shared> shared;
+};
+
+// Handle policies for containers that hand out popped values by pointer
+// (thread_pool::ThreadSafeQueue, ThreadSafeStack): a fresh shared_ptr per
+// value, or a Pooled handle from a pool owned by the container. Pooled
+// handles must not outlive the container.
+template <typename T>
+struct SharedHandles {
+  using handle = std::shared_ptr<T>;
+  handle make(T &&value) { return std::make_shared<T>(std::move(value)); }
+};
+
+template <typename T>
+class PooledHandles {
+public:
+  using handle = Pooled<T>;
+  handle make(T &&value) { return pool.make(std::move(value)); }
+
+private:
+  ObjectPool<T> pool;
+};
+
+} // namespace object_pool
@@ -0,0 +1,201 @@
+#include <gtest/gtest.h>
+#include <unistd.h>
+#include <chrono>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "object_pool/object_pool.h"
+#include "thread_pool/thread_pool.h"
+
+TEST(object_pool_test, basic_test) {
+  object_pool::ObjectPool<std::string> pool(4, 16);
+
+  std::string *a = pool.create("first");
+  std::string *b = pool.create(40, 'x');
+  EXPECT_EQ(*a, "first");
+  EXPECT_EQ(b->size(), 40u);
+  EXPECT_EQ(pool.capacity(), 16u);
+
+  // A freed slot is the next one handed out on this thread.
+  pool.destroy(a);
+  EXPECT_EQ(pool.create("second"), a);
+
+  {
+    auto handle = pool.make("pooled");
+    EXPECT_EQ(*handle, "pooled");
+  }
+
+  // More live objects than one chunk holds.
+  std::vector<object_pool::Pooled<std::string>> many;
+  for (int i = 0; i < 100; ++i)
+    many.push_back(pool.make(std::to_string(i)));
+  std::set<std::string *> distinct;
+  for (auto &p : many)
+    distinct.insert(p.get());
+  EXPECT_EQ(distinct.size(), 100u);
+  EXPECT_GE(pool.capacity(), 102u);
+
+  pool.destroy(a);
+  pool.destroy(b);
+}
+
+TEST(object_pool_test, cross_thread_test) {
+  object_pool::ObjectPool<int> pool(8, 64);
+
+  // One thread only allocates, the other only frees: slots travel back to
+  // the producer in whole magazines through the global list.
+  thread_pool::ThreadSafeQueue<int *> queue;
+  constexpr int count = 10'000;
+  std::thread producer([&] {
+    for (int i = 0; i < count; ++i)
+      queue.push(pool.create(i));
+    queue.push(nullptr);
+  });
+  std::thread consumer([&] {
+    long long sum = 0;
+    for (int *p;;) {
+      queue.wait_and_pop(p);
+      if (p == nullptr)
+        break;
+      sum += *p;
+      pool.destroy(p);
+    }
+    EXPECT_EQ(sum, static_cast<long long>(count) * (count - 1) / 2);
+  });
+  producer.join();
+  consumer.join();
+
+  // Both threads have exited, so their magazines are back in the pool and
+  // every slot can be handed out again without carving new ones.
+  std::size_t capacity = pool.capacity();
+  std::thread([&] {
+    std::vector<int *> all;
+    for (std::size_t i = 0; i < capacity; ++i)
+      all.push_back(pool.create(0));
+    EXPECT_EQ(std::set<int *>(all.begin(), all.end()).size(), all.size());
+    EXPECT_EQ(pool.capacity(), capacity);
+    for (int *p : all)
+      pool.destroy(p);
+  }).join();
+}
+
+TEST(object_pool_test, pooled_queue_test) {
+  thread_pool::ThreadSafeQueue<std::string, object_pool::PooledHandles<std::string>> queue;
+  EXPECT_EQ(queue.try_pop(), nullptr);
+  queue.push("a");
+  queue.push("b");
+  auto a = queue.wait_and_pop();
+  auto b = queue.try_pop();
+  EXPECT_EQ(*a, "a");
+  EXPECT_EQ(*b, "b");
+}
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Message {
+  int id;
+  char payload[60];
+};
+
+std::size_t rss_bytes() {
+  std::ifstream statm("/proc/self/statm");
+  std::size_t pages = 0, resident = 0;
+  statm >> pages >> resident;
+  return resident * static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+}
+
+// Steady producer/consumer load: the producer allocates every message, the
+// consumer keeps the last `window` of them alive and frees the rest.
+template <typename Create, typename Destroy>
+double cross_thread_rate(int count, std::size_t window, Create create, Destroy destroy) {
+  thread_pool::ThreadSafeQueue<Message *> queue;
+  auto sta = Clock::now();
+  std::thread producer([&] {
+    for (int i = 0; i < count; ++i)
+      queue.push(create(i));
+    queue.push(nullptr);
+  });
+
+  std::deque<Message *> live;
+  for (Message *m;;) {
+    queue.wait_and_pop(m);
+    if (m == nullptr)
+      break;
+    live.push_back(m);
+    if (live.size() > window) {
+      destroy(live.front());
+      live.pop_front();
+    }
+  }
+  producer.join();
+  for (Message *m : live)
+    destroy(m);
+  std::chrono::duration<double> dur = Clock::now() - sta;
+  return count / dur.count();
+}
+
+// Pops through the pointer-returning try_pop(), which allocates a handle
+// per element.
+template <typename Queue>
+double handle_pop_rate(int count) {
+  Queue queue;
+  auto sta = Clock::now();
+  std::thread producer([&] {
+    for (int i = 0; i < count; ++i)
+      queue.push(Message{i, {}});
+  });
+
+  long long sum = 0;
+  for (int received = 0; received < count;) {
+    if (auto m = queue.try_pop()) {
+      sum += m->id;
+      ++received;
+    } else {
+      std::this_thread::yield();
+    }
+  }
+  producer.join();
+  std::chrono::duration<double> dur = Clock::now() - sta;
+  EXPECT_EQ(sum, static_cast<long long>(count) * (count - 1) / 2);
+  return count / dur.count();
+}
+
+} // namespace
+
+TEST(object_pool_test, benchmark) {
+  constexpr int count = 500'000;
+  constexpr std::size_t window = 10'000;
+
+  auto rss_before = rss_bytes();
+  double heap = cross_thread_rate(
+      count, window, [](int i) { return new Message{i, {}}; }, [](Message *m) { delete m; });
+  auto rss_heap = rss_bytes();
+
+  object_pool::ObjectPool<Message> pool;
+  double pooled = cross_thread_rate(
+      count, window, [&](int i) { return pool.create(Message{i, {}}); },
+      [&](Message *m) { pool.destroy(m); });
+  auto rss_pool = rss_bytes();
+
+  std::cout << "new/delete: " << heap / 1e6 << " M allocations/s, RSS +"
+            << (rss_heap - std::min(rss_heap, rss_before)) / 1024 << " KiB." << std::endl;
+  std::cout << "ObjectPool: " << pooled / 1e6 << " M allocations/s, RSS +"
+            << (rss_pool - std::min(rss_pool, rss_heap)) / 1024 << " KiB, "
+            << pool.capacity() << " slots carved." << std::endl;
+
+  using object_pool::PooledHandles;
+  std::cout << "ThreadSafeQueue::try_pop with shared_ptr handles: "
+            << handle_pop_rate<thread_pool::ThreadSafeQueue<Message>>(count) / 1e6
+            << " M pops/s." << std::endl;
+  std::cout << "ThreadSafeQueue::try_pop with pooled handles: "
+            << handle_pop_rate<thread_pool::ThreadSafeQueue<Message, PooledHandles<Message>>>(
+                   count) / 1e6
+            << " M pops/s." << std::endl;
+}
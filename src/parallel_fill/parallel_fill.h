@@ -0,0 +1,159 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "thread_pool/thread_pool.h"
+
+namespace parallel_fill {
+
+// SplitMix64 used as a counter-based generator: the n-th output is a pure
+// function of (seed, n). A chunk starting at element `first` simply starts its
+// generator at counter `first`, so the generated data does not depend on how
+// the range is split or on how many threads fill it.
+class SplitMix64 {
+public:
+  using result_type = std::uint64_t;
+
+  explicit SplitMix64(std::uint64_t seed, std::uint64_t start = 0)
+    : key(mix(seed)), counter(start)
+  {}
+
+  static constexpr result_type min() { return 0; }
+  static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+  result_type operator()() { return at(counter++); }
+
+  // Output number `n`, independent of the current position.
+  [[nodiscard]] result_type at(std::uint64_t n) const {
+    return mix(key + (n + 1) * gamma);
+  }
+
+  void discard(std::uint64_t n) { counter += n; }
+
+private:
+  static constexpr std::uint64_t gamma = 0x9e3779b97f4a7c15ull;
+
+  static constexpr std::uint64_t mix(std::uint64_t z) {
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+  }
+
+  std::uint64_t key;
+  std::uint64_t counter;
+};
+
+// Maps a 64-bit random word onto [lo, hi] (both inclusive, like
+// std::uniform_int_distribution) or [lo, hi) for floating point types.
+// std::uniform_int_distribution is not used because its output is not
+// specified by the standard and differs between library implementations.
+template <typename T>
+T map_uniform(std::uint64_t bits, T lo, T hi) {
+  if constexpr (std::is_floating_point_v<T>) {
+    double unit = static_cast<double>(bits >> 11) * 0x1.0p-53;
+    return static_cast<T>(lo + (hi - lo) * unit);
+  } else {
+    using U = std::make_unsigned_t<T>;
+    auto range = static_cast<std::uint64_t>(static_cast<U>(hi) - static_cast<U>(lo)) + 1;
+    if (range == 0) // the full 64-bit range
+      return static_cast<T>(bits);
+    auto scaled = static_cast<std::uint64_t>(
+        (static_cast<unsigned __int128>(bits) * range) >> 64);
+    return static_cast<T>(static_cast<U>(lo) + static_cast<U>(scaled));
+  }
+}
+
+// Number of chunks handed to each pool thread.
+constexpr std::size_t chunks_per_thread = 4;
+
+// Chunks smaller than this are not worth a task.
+constexpr std::size_t min_chunk_size = 1 << 15;
+
+// Fills [first, last) with values uniformly distributed over [lo, hi]. The
+// result only depends on `seed`, never on the pool size.
+template <typename RandomIt, typename T = std::iter_value_t<RandomIt>>
+void fill_uniform(thread_pool::ThreadPool &pool, RandomIt first, RandomIt last,
+                  T lo, T hi, std::uint64_t seed) {
+  auto const length = static_cast<std::size_t>(last - first);
+  auto const chunks = std::max<std::size_t>(
+      1, std::min(pool.size() * chunks_per_thread, length / min_chunk_size));
+
+  auto fill_chunk = [=](std::size_t chunk_first, std::size_t chunk_last) {
+    SplitMix64 gen(seed, chunk_first);
+    for (auto it = first + chunk_first; it != first + chunk_last; ++it)
+      *it = map_uniform<T>(gen(), lo, hi);
+  };
+
+  if (chunks == 1) {
+    fill_chunk(0, length);
+    return;
+  }
+
+  std::vector<std::future<void>> futures;
+  futures.reserve(chunks);
+  for (std::size_t c = 0; c < chunks; ++c) {
+    futures.push_back(pool.submit(
+        [=] { fill_chunk(length * c / chunks, length * (c + 1) / chunks); }));
+  }
+  thread_pool::wait_all(pool, futures);
+  for (auto &fut : futures)
+    fut.get();
+}
+
+// Allocator that default-initializes instead of value-initializing, so
+// `std::vector<int, DefaultInitAllocator<int>> v(n)` does not zero the memory.
+// Large blocks come straight from mmap and stay untouched until the first
+// write; filling them from the pool places every page near the thread that
+// wrote it first (first-touch) instead of near the allocating thread.
+// Wraps any allocator A; it converts from A, so
+//   uninitialized_vector<int, numa::NumaAllocator<int>> v(n, numa_alloc);
+// keeps A's placement and adds the default-initialization.
+template <typename T, typename A = std::allocator<T>>
+class DefaultInitAllocator : public A {
+  using traits = std::allocator_traits<A>;
+
+public:
+  template <typename U>
+  struct rebind {
+    using other = DefaultInitAllocator<U, typename traits::template rebind_alloc<U>>;
+  };
+
+  using A::A;
+
+  DefaultInitAllocator() = default;
+  DefaultInitAllocator(const A &a) noexcept : A(a) {}
+
+  template <typename U>
+  void construct(U *ptr) noexcept(std::is_nothrow_default_constructible_v<U>) {
+    ::new (static_cast<void *>(ptr)) U;
+  }
+
+  template <typename U, typename... Args>
+  void construct(U *ptr, Args &&...args) {
+    traits::construct(static_cast<A &>(*this), ptr, std::forward<Args>(args)...);
+  }
+};
+
+template <typename T, typename A = std::allocator<T>>
+using uninitialized_vector = std::vector<T, DefaultInitAllocator<T, A>>;
+
+// Allocates `n` elements without touching them and fills them from the pool.
+template <typename T>
+uninitialized_vector<T> make_uniform_vector(thread_pool::ThreadPool &pool,
+                                            std::size_t n, T lo, T hi,
+                                            std::uint64_t seed) {
+  uninitialized_vector<T> values(n);
+  fill_uniform(pool, values.begin(), values.end(), lo, hi, seed);
+  return values;
+}
+
+} // namespace parallel_fill
@@ -0,0 +1,89 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "parallel_fill/parallel_fill.h"
+
+TEST(parallel_fill_test, deterministic_test) {
+  constexpr std::size_t n = 1000003;
+
+  std::vector<int> expected(n);
+  {
+    // The serial reference: one generator walking the whole range.
+    parallel_fill::SplitMix64 gen(2011);
+    for (auto &value : expected)
+      value = parallel_fill::map_uniform(gen(), 0, 100);
+  }
+
+  for (unsigned threads : {1, 2, 3, 8}) {
+    thread_pool::ThreadPool pool(threads);
+    std::vector<int> actual(n);
+    parallel_fill::fill_uniform(pool, actual.begin(), actual.end(), 0, 100, 2011);
+
+    EXPECT_EQ(expected, actual) << threads << " threads";
+  }
+}
+
+TEST(parallel_fill_test, range_test) {
+  thread_pool::ThreadPool pool(4);
+
+  auto ints = parallel_fill::make_uniform_vector(pool, 1 << 20, -3, 3, 42);
+  EXPECT_EQ(*std::min_element(ints.begin(), ints.end()), -3);
+  EXPECT_EQ(*std::max_element(ints.begin(), ints.end()), 3);
+
+  auto doubles = parallel_fill::make_uniform_vector(pool, 1 << 20, 0.0, 1.0, 42);
+  EXPECT_GE(*std::min_element(doubles.begin(), doubles.end()), 0.0);
+  EXPECT_LT(*std::max_element(doubles.begin(), doubles.end()), 1.0);
+
+  // Different seeds give different streams.
+  auto other = parallel_fill::make_uniform_vector(pool, 1 << 20, -3, 3, 43);
+  EXPECT_FALSE(std::equal(ints.begin(), ints.end(), other.begin()));
+}
+
+TEST(parallel_fill_test, generator_test) {
+  parallel_fill::SplitMix64 gen(7);
+  parallel_fill::SplitMix64 jumped(7, 1000);
+
+  gen.discard(1000);
+  EXPECT_EQ(gen(), jumped());
+  EXPECT_EQ(gen.at(5), jumped.at(5));
+
+  // Usable with the standard distributions as well.
+  std::uniform_int_distribution<int> dist(1, 6);
+  int roll = dist(gen);
+  EXPECT_TRUE(roll >= 1 && roll <= 6);
+}
+
+TEST(parallel_fill_test, benchmark) {
+  constexpr std::size_t n = 20000000;
+
+  {
+    std::mt19937 engine;
+    std::uniform_int_distribution<int> dist(0, 100);
+
+    auto sta = std::chrono::steady_clock::now();
+    std::vector<int> values;
+    values.reserve(n);
+    for (std::size_t i = 0; i < n; ++i)
+      values.push_back(dist(engine));
+    std::chrono::duration<double> dur = std::chrono::steady_clock::now() - sta;
+
+    std::cout << "std::mt19937 serial fill: " << dur.count() << " seconds."
+              << std::endl;
+  }
+
+  for (unsigned threads : {1, 2, 4, 8}) {
+    thread_pool::ThreadPool pool(threads);
+
+    auto sta = std::chrono::steady_clock::now();
+    auto values = parallel_fill::make_uniform_vector(pool, n, 0, 100, 2011);
+    std::chrono::duration<double> dur = std::chrono::steady_clock::now() - sta;
+
+    std::cout << "fill_uniform with " << threads << " threads: " << dur.count()
+              << " seconds." << std::endl;
+    EXPECT_EQ(values.size(), n);
+  }
+}
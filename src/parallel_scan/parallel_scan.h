@@ -0,0 +1,242 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "thread_pool/thread_pool.h"
+
+namespace parallel_scan {
+
+// Blocked two-pass prefix scan.
+//
+// The range is cut into a few blocks per pool thread.
+//   1. reduce:   every block except the last one is folded to a single value
+//                in parallel.
+//   2. carries:  the calling thread scans the (few) block totals, which gives
+//                the value every block has to start from.
+//   3. downsweep: every block is scanned in parallel, seeded with its carry.
+//
+// The input is read twice and the output written once, so the scan can run
+// out-of-place or in-place (d_first == first). `op` must be associative; it
+// does not have to be commutative and does not need an identity element.
+
+namespace detail {
+
+// Ranges shorter than this are not worth splitting into blocks.
+constexpr std::size_t min_block_size = 1 << 14;
+
+// Number of blocks handed to each pool thread, so that a slow thread does not
+// hold up the whole pass.
+constexpr std::size_t blocks_per_thread = 4;
+
+template <typename InputIt, typename OutputIt, typename T, typename BinaryOp>
+constexpr bool use_simd_v =
+    std::contiguous_iterator<InputIt> && std::contiguous_iterator<OutputIt> &&
+    std::is_same_v<std::iter_value_t<InputIt>, int> &&
+    std::is_same_v<std::iter_value_t<OutputIt>, int> &&
+    std::is_same_v<T, int> &&
+    (std::is_same_v<BinaryOp, std::plus<>> ||
+     std::is_same_v<BinaryOp, std::plus<int>>);
+
+#if defined(__SSE2__)
+// In-register scan of four lanes: two shifted adds turn [a b c d] into
+// [a a+b a+b+c a+b+c+d], then the running total of the previous vector is
+// broadcast and added. Returns the running total after `n` elements.
+inline int simd_scan(const int *in, int *out, std::size_t n, int carry,
+                     bool exclusive) {
+  __m128i offset = _mm_set1_epi32(carry);
+  std::size_t i = 0;
+
+  for (; i + 4 <= n; i += 4) {
+    __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i));
+    __m128i y = _mm_add_epi32(x, _mm_slli_si128(x, 4));
+    y = _mm_add_epi32(y, _mm_slli_si128(y, 8));
+    y = _mm_add_epi32(y, offset);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i),
+                     exclusive ? _mm_sub_epi32(y, x) : y);
+    offset = _mm_shuffle_epi32(y, _MM_SHUFFLE(3, 3, 3, 3));
+  }
+
+  carry = _mm_cvtsi128_si32(offset);
+  for (; i < n; ++i) {
+    int value = in[i];
+    out[i] = exclusive ? carry : carry + value;
+    carry += value;
+  }
+  return carry;
+}
+#endif
+
+// Scans [first, last) into d_first starting from `carry`. When `exclusive` is
+// false out[i] = carry op in[0] op ... op in[i], otherwise in[i] is left out.
+template <typename InputIt, typename OutputIt, typename T, typename BinaryOp>
+T scan_block(InputIt first, InputIt last, OutputIt d_first, T carry,
+             BinaryOp op, bool exclusive) {
+#if defined(__SSE2__)
+  if constexpr (use_simd_v<InputIt, OutputIt, T, BinaryOp>) {
+    return simd_scan(std::to_address(first), std::to_address(d_first),
+                     static_cast<std::size_t>(last - first), carry, exclusive);
+  }
+#endif
+
+  for (; first != last; ++first, ++d_first) {
+    T value = *first;
+    if (exclusive) {
+      *d_first = carry;
+      carry = op(std::move(carry), std::move(value));
+    } else {
+      carry = op(std::move(carry), std::move(value));
+      *d_first = carry;
+    }
+  }
+  return carry;
+}
+
+// Inclusive scan of a block that has no carry (the first block).
+template <typename InputIt, typename OutputIt, typename BinaryOp>
+void scan_first_block(InputIt first, InputIt last, OutputIt d_first,
+                      BinaryOp op) {
+  if (first == last)
+    return;
+
+  std::iter_value_t<InputIt> carry = *first;
+  *d_first = carry;
+  scan_block(std::next(first), last, std::next(d_first), std::move(carry), op,
+             false);
+}
+
+template <typename InputIt, typename BinaryOp>
+std::iter_value_t<InputIt> reduce_block(InputIt first, InputIt last,
+                                        BinaryOp op) {
+  std::iter_value_t<InputIt> sum = *first;
+  for (++first; first != last; ++first)
+    sum = op(std::move(sum), *first);
+  return sum;
+}
+
+inline std::size_t block_count(thread_pool::ThreadPool &pool,
+                               std::size_t length) {
+  return std::min(pool.size() * blocks_per_thread, length / min_block_size);
+}
+
+// Pass 1: returns the fold of every block but the last one.
+template <typename RandomIt, typename BinaryOp>
+std::vector<std::iter_value_t<RandomIt>>
+reduce_blocks(thread_pool::ThreadPool &pool, RandomIt first,
+              std::size_t length, std::size_t blocks, BinaryOp op) {
+  using T = std::iter_value_t<RandomIt>;
+
+  std::vector<std::future<T>> futures;
+  futures.reserve(blocks - 1);
+  for (std::size_t b = 0; b + 1 < blocks; ++b) {
+    auto block_first = first + length * b / blocks;
+    auto block_last = first + length * (b + 1) / blocks;
+    futures.push_back(pool.submit(
+        [=] { return reduce_block(block_first, block_last, op); }));
+  }
+  thread_pool::wait_all(pool, futures);
+
+  std::vector<T> sums;
+  sums.reserve(blocks - 1);
+  for (auto &fut : futures)
+    sums.push_back(fut.get());
+  return sums;
+}
+
+} // namespace detail
+
+template <typename RandomIt, typename OutputIt, typename BinaryOp = std::plus<>>
+OutputIt parallel_inclusive_scan(thread_pool::ThreadPool &pool, RandomIt first,
+                                 RandomIt last, OutputIt d_first,
+                                 BinaryOp op = {}) {
+  using T = std::iter_value_t<RandomIt>;
+
+  auto const length = static_cast<std::size_t>(std::distance(first, last));
+  auto const blocks = detail::block_count(pool, length);
+
+  if (blocks < 2) {
+    detail::scan_first_block(first, last, d_first, op);
+    return d_first + length;
+  }
+
+  std::vector<T> carries = detail::reduce_blocks(pool, first, length, blocks, op);
+  for (std::size_t b = 1; b < carries.size(); ++b)
+    carries[b] = op(carries[b - 1], carries[b]);
+
+  std::vector<std::future<void>> futures;
+  futures.reserve(blocks);
+  for (std::size_t b = 0; b < blocks; ++b) {
+    auto const offset = length * b / blocks;
+    auto block_first = first + offset;
+    auto block_last = first + length * (b + 1) / blocks;
+    auto block_d_first = d_first + offset;
+
+    if (b == 0) {
+      futures.push_back(pool.submit([=] {
+        detail::scan_first_block(block_first, block_last, block_d_first, op);
+      }));
+    } else {
+      futures.push_back(pool.submit([=, carry = carries[b - 1]] {
+        detail::scan_block(block_first, block_last, block_d_first, carry, op,
+                           false);
+      }));
+    }
+  }
+  thread_pool::wait_all(pool, futures);
+  for (auto &fut : futures)
+    fut.get();
+
+  return d_first + length;
+}
+
+template <typename RandomIt, typename OutputIt, typename T,
+          typename BinaryOp = std::plus<>>
+OutputIt parallel_exclusive_scan(thread_pool::ThreadPool &pool, RandomIt first,
+                                 RandomIt last, OutputIt d_first, T init,
+                                 BinaryOp op = {}) {
+  auto const length = static_cast<std::size_t>(std::distance(first, last));
+  auto const blocks = detail::block_count(pool, length);
+
+  if (blocks < 2) {
+    detail::scan_block(first, last, d_first, std::move(init), op, true);
+    return d_first + length;
+  }
+
+  auto sums = detail::reduce_blocks(pool, first, length, blocks, op);
+  std::vector<T> carries;
+  carries.reserve(blocks);
+  carries.push_back(std::move(init));
+  for (auto &sum : sums)
+    carries.push_back(op(carries.back(), std::move(sum)));
+
+  std::vector<std::future<void>> futures;
+  futures.reserve(blocks);
+  for (std::size_t b = 0; b < blocks; ++b) {
+    auto const offset = length * b / blocks;
+    auto block_first = first + offset;
+    auto block_last = first + length * (b + 1) / blocks;
+    auto block_d_first = d_first + offset;
+
+    futures.push_back(pool.submit([=, carry = carries[b]] {
+      detail::scan_block(block_first, block_last, block_d_first, carry, op,
+                         true);
+    }));
+  }
+  thread_pool::wait_all(pool, futures);
+  for (auto &fut : futures)
+    fut.get();
+
+  return d_first + length;
+}
+
+} // namespace parallel_scan
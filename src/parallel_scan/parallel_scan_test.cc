@@ -0,0 +1,138 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "parallel_scan/parallel_scan.h"
+
+namespace {
+
+std::vector<int> random_values(std::size_t n) {
+  std::mt19937 engine;
+  std::uniform_int_distribution<int> dist(0, 9);
+
+  std::vector<int> values(n);
+  std::generate(values.begin(), values.end(), [&] { return dist(engine); });
+  return values;
+}
+
+} // namespace
+
+TEST(parallel_scan_test, inclusive_scan_test) {
+  thread_pool::ThreadPool pool(4);
+
+  for (std::size_t n : {0, 1, 7, 1000, 100003, 1 << 20}) {
+    auto values = random_values(n);
+
+    std::vector<int> expected(n);
+    std::inclusive_scan(values.begin(), values.end(), expected.begin());
+
+    std::vector<int> actual(n);
+    auto end = parallel_scan::parallel_inclusive_scan(
+        pool, values.begin(), values.end(), actual.begin());
+
+    EXPECT_TRUE(end == actual.end());
+    EXPECT_EQ(expected, actual) << "n = " << n;
+  }
+}
+
+TEST(parallel_scan_test, exclusive_scan_test) {
+  thread_pool::ThreadPool pool(4);
+
+  for (std::size_t n : {0, 1, 7, 1000, 100003, 1 << 20}) {
+    auto values = random_values(n);
+
+    std::vector<int> expected(n);
+    std::exclusive_scan(values.begin(), values.end(), expected.begin(), 42);
+
+    std::vector<int> actual(n);
+    parallel_scan::parallel_exclusive_scan(pool, values.begin(), values.end(),
+                                           actual.begin(), 42);
+
+    EXPECT_EQ(expected, actual) << "n = " << n;
+  }
+}
+
+TEST(parallel_scan_test, in_place_test) {
+  thread_pool::ThreadPool pool(4);
+
+  auto values = random_values(1 << 20);
+  std::vector<int> expected(values.size());
+  std::exclusive_scan(values.begin(), values.end(), expected.begin(), 0);
+
+  parallel_scan::parallel_exclusive_scan(pool, values.begin(), values.end(),
+                                         values.begin(), 0);
+
+  EXPECT_EQ(expected, values);
+}
+
+TEST(parallel_scan_test, generic_op_test) {
+  thread_pool::ThreadPool pool(4);
+
+  // long long is scanned by the scalar path.
+  std::vector<long long> numbers(300000);
+  std::iota(numbers.begin(), numbers.end(), 1);
+  std::vector<long long> max_expected(numbers.size());
+  std::vector<long long> max_actual(numbers.size());
+  auto max_op = [](long long a, long long b) { return std::max(a, b); };
+
+  std::inclusive_scan(numbers.begin(), numbers.end(), max_expected.begin(), max_op);
+  parallel_scan::parallel_inclusive_scan(pool, numbers.begin(), numbers.end(),
+                                         max_actual.begin(), max_op);
+  EXPECT_EQ(max_expected, max_actual);
+
+  // Concatenation is associative but not commutative, so it catches blocks
+  // being combined out of order.
+  std::vector<std::string> words(100000);
+  for (std::size_t i = 0; i < words.size(); ++i)
+    words[i] = std::string(1, static_cast<char>('a' + i % 26));
+
+  std::vector<std::string> last_expected;
+  std::string running;
+  for (auto &word : words) {
+    running += word;
+    if (running.size() > 8)
+      running.erase(0, running.size() - 8);
+    last_expected.push_back(running);
+  }
+
+  auto tail_concat = [](std::string a, const std::string &b) {
+    a += b;
+    if (a.size() > 8)
+      a.erase(0, a.size() - 8);
+    return a;
+  };
+  std::vector<std::string> last_actual(words.size());
+  parallel_scan::parallel_inclusive_scan(pool, words.begin(), words.end(),
+                                         last_actual.begin(), tail_concat);
+  EXPECT_EQ(last_expected, last_actual);
+}
+
+TEST(parallel_scan_test, benchmark) {
+  thread_pool::ThreadPool pool;
+
+  for (std::size_t n : {1000000, 10000000, 100000000}) {
+    auto values = random_values(n);
+    std::vector<int> expected(n);
+    std::vector<int> actual(n);
+
+    auto sta = std::chrono::steady_clock::now();
+    std::partial_sum(values.begin(), values.end(), expected.begin());
+    std::chrono::duration<double> seq_dur = std::chrono::steady_clock::now() - sta;
+
+    sta = std::chrono::steady_clock::now();
+    parallel_scan::parallel_inclusive_scan(pool, values.begin(), values.end(),
+                                           actual.begin());
+    std::chrono::duration<double> par_dur = std::chrono::steady_clock::now() - sta;
+
+    std::cout << "n = " << n << ": std::partial_sum " << seq_dur.count()
+              << " seconds, parallel_inclusive_scan (" << pool.size()
+              << " threads) " << par_dur.count() << " seconds." << std::endl;
+
+    EXPECT_EQ(expected, actual);
+  }
+}
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "rng/xorshift.h"
+
+namespace priority {
+
+// Relaxed concurrent priority queue: a MultiQueue (Rihani, Sanders &
+// Dementiev 2015).
+//
+// The queue is `heaps` binary heaps, each behind its own mutex. push()
+// locks a random heap (another one if that lock is taken); try_pop() looks
+// at the cached minimum of two random heaps and pops from the better one.
+// Threads rarely meet on a lock, and a pop is still close to the global
+// minimum: in expectation it is among the O(shards) smallest keys.
+//
+//   priority::MultiQueue<Job> jobs;
+//   jobs.push(0, urgent);        // lower keys come out first
+//   jobs.push(10, background);
+//   if (auto job = jobs.try_pop()) ...
+//
+// Equal keys pushed to the same heap come out in push order. try_pop() can
+// miss an element whose push is still in flight, and is only reliably
+// empty-handed once pushes have stopped.
+template <typename T>
+class MultiQueue {
+public:
+  using Key = std::uint64_t;
+
+  // At least two heaps, for the two-choice pop.
+  explicit MultiQueue(std::size_t heaps = 2 * std::thread::hardware_concurrency())
+      : shard_count(std::max<std::size_t>(heaps, 2)),
+        shards(std::make_unique<Shard[]>(shard_count)) {}
+
+  MultiQueue(const MultiQueue &) = delete;
+  MultiQueue &operator=(const MultiQueue &) = delete;
+
+  void push(Key key, T value) {
+    key = std::min(key, empty_key - 1);
+    for (int attempt = 0;; ++attempt) {
+      Shard &s = shards[random_index()];
+      std::unique_lock<std::mutex> lk(s.mutex, std::defer_lock);
+      // After a few collisions, wait for a lock instead of spinning.
+      if (attempt < 4) {
+        if (!lk.try_lock())
+          continue;
+      } else {
+        lk.lock();
+      }
+      s.heap.push_back(Entry{key, s.seq++, std::move(value)});
+      std::push_heap(s.heap.begin(), s.heap.end(), later);
+      s.top.store(s.heap.front().key, std::memory_order_release);
+      return;
+    }
+  }
+
+  bool try_pop(T &value) {
+    for (;;) {
+      std::size_t i = random_index();
+      std::size_t j = random_index();
+      if (j == i)
+        j = (i + 1) % shard_count;
+      Key ki = shards[i].top.load(std::memory_order_acquire);
+      Key kj = shards[j].top.load(std::memory_order_acquire);
+      Shard *s = &shards[kj < ki ? j : i];
+
+      if (std::min(ki, kj) == empty_key) {
+        // Both samples look empty; take any heap that is not, so that a
+        // nearly empty queue still drains.
+        s = nullptr;
+        for (std::size_t k = 0; k < shard_count && s == nullptr; ++k) {
+          if (shards[k].top.load(std::memory_order_acquire) != empty_key)
+            s = &shards[k];
+        }
+        if (s == nullptr)
+          return false;
+      }
+
+      std::unique_lock<std::mutex> lk(s->mutex, std::try_to_lock);
+      if (!lk.owns_lock() || s->heap.empty())
+        continue;
+      std::pop_heap(s->heap.begin(), s->heap.end(), later);
+      value = std::move(s->heap.back().value);
+      s->heap.pop_back();
+      s->top.store(s->heap.empty() ? empty_key : s->heap.front().key,
+                   std::memory_order_release);
+      return true;
+    }
+  }
+
+  std::optional<T> try_pop() {
+    T value;
+    if (!try_pop(value))
+      return std::nullopt;
+    return value;
+  }
+
+  // A snapshot; may be stale by the time it returns.
+  [[nodiscard]] bool empty() const {
+    for (std::size_t k = 0; k < shard_count; ++k) {
+      if (shards[k].top.load(std::memory_order_acquire) != empty_key)
+        return false;
+    }
+    return true;
+  }
+
+private:
+  static constexpr Key empty_key = std::numeric_limits<Key>::max();
+
+  struct Entry {
+    Key key;
+    std::uint64_t seq;
+    T value;
+  };
+
+  // Heap order: the root is the smallest key, oldest first.
+  static bool later(const Entry &a, const Entry &b) {
+    return a.key != b.key ? a.key > b.key : a.seq > b.seq;
+  }
+
+  struct alignas(64) Shard {
+    std::mutex mutex;
+    std::vector<Entry> heap;
+    std::uint64_t seq = 0;
+    // The root's key, readable without the lock; empty_key when empty.
+    std::atomic<Key> top{empty_key};
+  };
+
+  std::size_t random_index() const {
+    return static_cast<std::size_t>(rng::thread_random() % shard_count);
+  }
+
+  const std::size_t shard_count;
+  std::unique_ptr<Shard[]> shards;
+};
+
+} // namespace priority
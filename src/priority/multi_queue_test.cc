@@ -0,0 +1,166 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <queue>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "priority/multi_queue.h"
+
+TEST(multi_queue_test, order_test) {
+  // With two heaps a single thread always compares both roots, so the
+  // order is exact.
+  priority::MultiQueue<int> queue(2);
+  EXPECT_TRUE(queue.empty());
+  EXPECT_FALSE(queue.try_pop().has_value());
+
+  std::vector<int> keys(1000);
+  for (int i = 0; i < 1000; ++i)
+    keys[i] = i;
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(1));
+  for (int k : keys)
+    queue.push(k, k);
+  for (int i = 0; i < 1000; ++i)
+    EXPECT_EQ(*queue.try_pop(), i);
+  EXPECT_TRUE(queue.empty());
+}
+
+TEST(multi_queue_test, rank_error_test) {
+  // With more heaps the order is relaxed, but a pop stays near the front.
+  constexpr int n = 20'000;
+  priority::MultiQueue<int> queue(16);
+  std::vector<int> keys(n);
+  for (int i = 0; i < n; ++i)
+    keys[i] = i;
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(2));
+  for (int k : keys)
+    queue.push(k, k);
+
+  // Rank of a popped key among those still queued = how many smaller keys
+  // are still queued.
+  std::vector<bool> popped(n, false);
+  int smallest = 0;
+  long long total_rank = 0;
+  int value;
+  while (queue.try_pop(value)) {
+    popped[value] = true;
+    int rank = 0;
+    for (int k = smallest; k < value; ++k)
+      rank += !popped[k];
+    total_rank += rank;
+    while (smallest < n && popped[smallest])
+      ++smallest;
+  }
+  EXPECT_EQ(smallest, n);
+  double mean_rank = static_cast<double>(total_rank) / n;
+  std::cout << "mean rank error with 16 heaps: " << mean_rank << std::endl;
+  EXPECT_LT(mean_rank, 64);
+}
+
+TEST(multi_queue_test, concurrent_test) {
+  constexpr int producers = 3;
+  constexpr int per_producer = 20'000;
+  priority::MultiQueue<int> queue(8);
+  std::vector<std::atomic<int>> seen(producers * per_producer);
+  std::atomic<int> popped{0};
+
+  std::vector<std::thread> threads;
+  for (int p = 0; p < producers; ++p) {
+    threads.emplace_back([&, p] {
+      for (int i = 0; i < per_producer; ++i)
+        queue.push(static_cast<std::uint64_t>(i), p * per_producer + i);
+    });
+  }
+  for (int c = 0; c < 3; ++c) {
+    threads.emplace_back([&] {
+      int value;
+      while (popped.load() < producers * per_producer) {
+        if (queue.try_pop(value)) {
+          seen[value].fetch_add(1);
+          popped.fetch_add(1);
+        } else {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+  for (auto &t : threads)
+    t.join();
+
+  EXPECT_TRUE(queue.empty());
+  for (auto &s : seen)
+    ASSERT_EQ(s.load(), 1);
+}
+
+namespace {
+
+// Baseline: std::priority_queue behind one mutex.
+template <typename T>
+class LockedPriorityQueue {
+public:
+  void push(std::uint64_t key, T value) {
+    std::lock_guard<std::mutex> lk(mutex);
+    heap.emplace(key, std::move(value));
+  }
+
+  bool try_pop(T &value) {
+    std::lock_guard<std::mutex> lk(mutex);
+    if (heap.empty())
+      return false;
+    value = heap.top().second;
+    heap.pop();
+    return true;
+  }
+
+private:
+  using Entry = std::pair<std::uint64_t, T>;
+  std::mutex mutex;
+  std::priority_queue<Entry, std::vector<Entry>, std::greater<>> heap;
+};
+
+// Every thread alternates push and pop on a queue prefilled with `prefill`
+// random keys.
+template <typename Queue>
+double throughput(Queue &queue, int threads, int ops_per_thread) {
+  constexpr int prefill = 1 << 14;
+  std::mt19937 rng(3);
+  for (int i = 0; i < prefill; ++i)
+    queue.push(rng() % prefill, i);
+
+  auto sta = std::chrono::steady_clock::now();
+  std::vector<std::thread> workers;
+  for (int t = 0; t < threads; ++t) {
+    workers.emplace_back([&queue, t, ops_per_thread] {
+      std::mt19937 rng(t);
+      int value;
+      for (int i = 0; i < ops_per_thread; ++i) {
+        queue.push(rng() % prefill, i);
+        (void)queue.try_pop(value);
+      }
+    });
+  }
+  for (auto &w : workers)
+    w.join();
+  std::chrono::duration<double> dur = std::chrono::steady_clock::now() - sta;
+  return 2.0 * threads * ops_per_thread / dur.count();
+}
+
+} // namespace
+
+TEST(multi_queue_test, benchmark) {
+  constexpr int ops_per_thread = 100'000;
+  std::cout << "push+pop pairs (M ops/s):" << std::endl;
+  for (int threads : {1, 2, 4}) {
+    LockedPriorityQueue<int> locked;
+    priority::MultiQueue<int> relaxed(2 * threads);
+    std::cout << "  " << threads << " threads: mutex + std::priority_queue "
+              << throughput(locked, threads, ops_per_thread) / 1e6 << ", MultiQueue "
+              << throughput(relaxed, threads, ops_per_thread) / 1e6 << std::endl;
+  }
+}
@@ -0,0 +1,315 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "reclamation/retire_list.h"
+
+namespace reclamation {
+
+// Epoch-based reclamation.
+//
+// Readers do not protect individual pointers. They pin the domain for the
+// duration of an operation, which records the global epoch they started
+// in; inside the pin every node they can reach stays allocated, and loads
+// are plain acquire loads.
+//
+//   {
+//     reclamation::EpochGuard guard;            // EpochDomain::global()
+//     for (Node *n = head.load(std::memory_order_acquire); n; n = n->next.load(...))
+//       ...
+//   }
+//   reclamation::EpochDomain::global().retire(unlinked);
+//
+// A node retired while the global epoch is e can still be seen by threads
+// pinned in e (or e - 1). The epoch only advances from e to e + 1 once
+// every pinned thread has caught up with e, so by the time it reaches e + 2
+// nobody can hold the node and it is freed.
+//
+// The price is that one stalled reader holds back all reclamation, where
+// with hazard pointers it would only hold back the nodes it protects.
+//
+// Retired nodes go to a per-thread list that is collected once it holds
+// scan_threshold nodes. With start_reclaimer() a background thread does the
+// collecting instead: full lists are handed to it, and it advances the
+// epoch and frees them periodically.
+
+namespace detail {
+
+// Per-thread pin state: (epoch << 1) | pinned.
+struct EpochRecord {
+  std::atomic<std::uint64_t> state{0};
+  std::atomic<bool> active{false};
+  EpochRecord *next = nullptr;
+};
+
+struct EpochRetired {
+  Retired node;
+  std::uint64_t epoch;
+};
+
+// Frees the prefix of `list` (in retire order, so in epoch order) that was
+// retired at least two epochs before `epoch`.
+inline void reclaim_before(std::vector<EpochRetired> &list, std::uint64_t epoch) {
+  auto end = std::find_if(list.begin(), list.end(),
+                          [epoch](const EpochRetired &r) { return r.epoch + 2 > epoch; });
+  std::vector<EpochRetired> ready(list.begin(), end);
+  list.erase(list.begin(), end);
+  for (auto &r : ready)
+    r.node.reclaim(r.node.ptr);
+}
+
+struct EpochShared {
+  explicit EpochShared(std::size_t threshold) : scan_threshold(std::max<std::size_t>(threshold, 1)) {}
+
+  ~EpochShared() {
+    for (auto &r : deferred)
+      r.node.reclaim(r.node.ptr);
+    for (EpochRecord *r = records.load(); r != nullptr;) {
+      EpochRecord *next = r->next;
+      delete r;
+      r = next;
+    }
+  }
+
+  EpochRecord *acquire_record() {
+    for (EpochRecord *r = records.load(std::memory_order_acquire); r != nullptr; r = r->next) {
+      bool expected = false;
+      if (!r->active.load(std::memory_order_relaxed) &&
+          r->active.compare_exchange_strong(expected, true, std::memory_order_acquire))
+        return r;
+    }
+
+    auto *r = new EpochRecord;
+    r->active.store(true, std::memory_order_relaxed);
+    r->next = records.load(std::memory_order_relaxed);
+    while (!records.compare_exchange_weak(r->next, r, std::memory_order_release,
+                                          std::memory_order_relaxed)) {
+    }
+    return r;
+  }
+
+  // Moves the global epoch on if every pinned thread is in it. Returns the
+  // (possibly new) global epoch.
+  std::uint64_t try_advance() {
+    std::uint64_t e = epoch.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    for (auto *r = records.load(std::memory_order_acquire); r != nullptr; r = r->next) {
+      std::uint64_t s = r->state.load(std::memory_order_acquire);
+      if ((s & 1) && (s >> 1) != e)
+        return e;
+    }
+    if (epoch.compare_exchange_strong(e, e + 1, std::memory_order_acq_rel))
+      return e + 1;
+    return e;
+  }
+
+  // Frees what the lists of exited threads (and, with a background
+  // reclaimer, of live ones) hold, as far as the epoch allows.
+  void collect_deferred(std::uint64_t e) {
+    std::unique_lock<std::mutex> lk(deferred_mutex, std::try_to_lock);
+    if (!lk.owns_lock() || deferred.empty())
+      return;
+    std::sort(deferred.begin(), deferred.end(),
+              [](const EpochRetired &a, const EpochRetired &b) { return a.epoch < b.epoch; });
+    std::vector<EpochRetired> list = std::move(deferred);
+    deferred.clear();
+    lk.unlock();
+
+    reclaim_before(list, e);
+
+    lk.lock();
+    deferred.insert(deferred.end(), list.begin(), list.end());
+  }
+
+  const std::uint64_t id = next_id.fetch_add(1, std::memory_order_relaxed);
+  const std::size_t scan_threshold;
+  std::atomic<std::uint64_t> epoch{2};
+  std::atomic<EpochRecord *> records{nullptr};
+
+  std::mutex deferred_mutex;
+  std::condition_variable deferred_cond;
+  std::vector<EpochRetired> deferred;
+  std::atomic<bool> background{false};
+
+  static inline std::atomic<std::uint64_t> next_id{1};
+};
+
+struct EpochLocal {
+  std::uint64_t id;
+  std::weak_ptr<EpochShared> owner;
+  EpochRecord *record = nullptr;
+  unsigned pins = 0;
+  std::vector<EpochRetired> retired;
+
+  void detach() {
+    if (auto shared = owner.lock()) {
+      if (record != nullptr) {
+        record->state.store(0, std::memory_order_release);
+        record->active.store(false, std::memory_order_release);
+      }
+      std::lock_guard<std::mutex> lk(shared->deferred_mutex);
+      shared->deferred.insert(shared->deferred.end(), retired.begin(), retired.end());
+    } else {
+      for (auto &r : retired)
+        r.node.reclaim(r.node.ptr);
+    }
+    record = nullptr;
+    retired.clear();
+  }
+};
+
+inline EpochLocal &local_state(const std::shared_ptr<EpochShared> &shared) {
+  return thread_state<EpochLocal>(shared);
+}
+
+} // namespace detail
+
+class EpochGuard;
+
+class EpochDomain {
+public:
+  explicit EpochDomain(std::size_t scan_threshold = 64)
+      : shared(std::make_shared<detail::EpochShared>(scan_threshold)) {}
+
+  // No thread may be pinned any more.
+  ~EpochDomain() {
+    stop_reclaimer();
+    if (auto *local = detail::thread_state_if_alive<detail::EpochLocal>(shared)) {
+      for (auto &r : local->retired)
+        r.node.reclaim(r.node.ptr);
+      local->retired.clear();
+    }
+  }
+
+  EpochDomain(const EpochDomain &) = delete;
+  EpochDomain &operator=(const EpochDomain &) = delete;
+
+  static EpochDomain &global() {
+    static EpochDomain domain;
+    return domain;
+  }
+
+  // Frees p once every thread that could have seen it has unpinned. p must
+  // already be unreachable for new readers.
+  template <typename T>
+  void retire(T *p) {
+    retire(static_cast<void *>(p), [](void *q) { delete static_cast<T *>(q); });
+  }
+
+  void retire(void *p, void (*reclaim)(void *)) {
+    auto &local = detail::local_state(shared);
+    local.retired.push_back({{p, reclaim}, shared->epoch.load(std::memory_order_seq_cst)});
+    if (local.retired.size() < shared->scan_threshold)
+      return;
+
+    if (shared->background.load(std::memory_order_relaxed)) {
+      std::lock_guard<std::mutex> lk(shared->deferred_mutex);
+      shared->deferred.insert(shared->deferred.end(), local.retired.begin(),
+                              local.retired.end());
+      local.retired.clear();
+      shared->deferred_cond.notify_one();
+    } else {
+      scan(local);
+    }
+  }
+
+  // Tries to advance the epoch and frees what this thread retired that is
+  // old enough, along with the lists of threads that have exited.
+  void scan() { scan(detail::local_state(shared)); }
+
+  // Nodes this thread has retired but not freed yet.
+  [[nodiscard]] std::size_t pending() const { return detail::local_state(shared).retired.size(); }
+
+  // Nodes handed over by exited threads or to the background reclaimer.
+  [[nodiscard]] std::size_t deferred() const {
+    std::lock_guard<std::mutex> lk(shared->deferred_mutex);
+    return shared->deferred.size();
+  }
+
+  [[nodiscard]] std::uint64_t epoch() const {
+    return shared->epoch.load(std::memory_order_acquire);
+  }
+
+  // Starts a thread that advances the epoch and frees deferred nodes every
+  // `period`, or sooner when a retire list is handed over.
+  void start_reclaimer(std::chrono::milliseconds period = std::chrono::milliseconds(1)) {
+    if (reclaimer.joinable())
+      return;
+    stopping = false;
+    shared->background = true;
+    reclaimer = std::thread([this, period] {
+      std::unique_lock<std::mutex> lk(shared->deferred_mutex);
+      while (!stopping) {
+        shared->deferred_cond.wait_for(lk, period);
+        lk.unlock();
+        shared->collect_deferred(shared->try_advance());
+        lk.lock();
+      }
+    });
+  }
+
+  void stop_reclaimer() {
+    if (!reclaimer.joinable())
+      return;
+    {
+      std::lock_guard<std::mutex> lk(shared->deferred_mutex);
+      stopping = true;
+      shared->background = false;
+      shared->deferred_cond.notify_one();
+    }
+    reclaimer.join();
+  }
+
+private:
+  friend class EpochGuard;
+
+  void scan(detail::EpochLocal &local) {
+    std::uint64_t e = shared->try_advance();
+    detail::reclaim_before(local.retired, e);
+    shared->collect_deferred(e);
+  }
+
+  std::shared_ptr<detail::EpochShared> shared;
+  std::thread reclaimer;
+  bool stopping = false;
+};
+
+// Pins the calling thread in a domain for its lifetime. Guards nest; only
+// the outermost one touches the shared record.
+class EpochGuard {
+public:
+  explicit EpochGuard(EpochDomain &domain = EpochDomain::global())
+      : local(&detail::local_state(domain.shared)) {
+    if (local->pins++ > 0)
+      return;
+    if (local->record == nullptr)
+      local->record = domain.shared->acquire_record();
+    std::uint64_t e = domain.shared->epoch.load(std::memory_order_relaxed);
+    local->record->state.store((e << 1) | 1, std::memory_order_relaxed);
+    // The pin must be visible before any load of the protected structure.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+  }
+
+  ~EpochGuard() {
+    if (--local->pins == 0)
+      local->record->state.store(0, std::memory_order_release);
+  }
+
+  EpochGuard(const EpochGuard &) = delete;
+  EpochGuard &operator=(const EpochGuard &) = delete;
+
+private:
+  detail::EpochLocal *local;
+};
+
+} // namespace reclamation
@@ -0,0 +1,301 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "reclamation/epoch.h"
+#include "reclamation/hazard_pointer.h"
+
+namespace {
+
+struct Tracked {
+  static inline std::atomic<int> live{0};
+
+  explicit Tracked(int v) : value(v) { live.fetch_add(1); }
+  ~Tracked() { live.fetch_sub(1); }
+
+  int value;
+};
+
+// Treiber stack: pop() reads head->next inside an epoch pin.
+template <typename T>
+class EpochStack {
+  struct Node {
+    T value;
+    Node *next;
+  };
+
+public:
+  explicit EpochStack(reclamation::EpochDomain &domain) : domain(domain) {}
+
+  ~EpochStack() {
+    while (pop()) {
+    }
+  }
+
+  void push(int v) {
+    auto *node = new Node{T(v), head.load(std::memory_order_relaxed)};
+    while (!head.compare_exchange_weak(node->next, node, std::memory_order_release,
+                                       std::memory_order_relaxed)) {
+    }
+  }
+
+  std::optional<int> pop() {
+    reclamation::EpochGuard guard(domain);
+    Node *old = head.load(std::memory_order_acquire);
+    while (old != nullptr && !head.compare_exchange_weak(old, old->next,
+                                                         std::memory_order_acquire,
+                                                         std::memory_order_acquire)) {
+    }
+    if (old == nullptr)
+      return std::nullopt;
+    int v = old->value.value;
+    domain.retire(old);
+    return v;
+  }
+
+private:
+  reclamation::EpochDomain &domain;
+  std::atomic<Node *> head{nullptr};
+};
+
+} // namespace
+
+TEST(epoch_test, pin_test) {
+  reclamation::EpochDomain domain(1);
+  auto *node = new Tracked(1);
+  std::thread reader;
+  std::atomic<bool> pinned{false}, release{false};
+
+  // Another thread pinned before the retire holds the node back.
+  reader = std::thread([&] {
+    reclamation::EpochGuard guard(domain);
+    pinned = true;
+    while (!release)
+      std::this_thread::yield();
+  });
+  while (!pinned)
+    std::this_thread::yield();
+
+  domain.retire(node);
+  for (int i = 0; i < 10; ++i)
+    domain.scan();
+  EXPECT_EQ(domain.pending(), 1u);
+  EXPECT_EQ(Tracked::live.load(), 1);
+
+  release = true;
+  reader.join();
+  domain.scan();
+  domain.scan();
+  EXPECT_EQ(domain.pending(), 0u);
+  EXPECT_EQ(Tracked::live.load(), 0);
+
+  // Nested guards on one thread keep a single pin.
+  {
+    reclamation::EpochGuard outer(domain);
+    reclamation::EpochGuard inner(domain);
+  }
+  auto before = domain.epoch();
+  domain.scan();
+  EXPECT_GT(domain.epoch(), before);
+}
+
+TEST(epoch_test, stress_test) {
+  for (bool background : {false, true}) {
+    {
+      reclamation::EpochDomain domain(32);
+      if (background)
+        domain.start_reclaimer();
+      EpochStack<Tracked> stack(domain);
+      std::atomic<long long> popped{0};
+
+      std::vector<std::thread> workers;
+      for (int t = 0; t < 4; ++t) {
+        workers.emplace_back([&, t] {
+          long long sum = 0;
+          for (int i = 0; i < 20'000; ++i) {
+            stack.push(t * 20'000 + i);
+            if (auto v = stack.pop())
+              sum += *v;
+          }
+          popped += sum;
+        });
+      }
+      for (auto &w : workers)
+        w.join();
+      while (auto v = stack.pop())
+        popped += *v;
+
+      long long n = 80'000;
+      EXPECT_EQ(popped.load(), n * (n - 1) / 2);
+    }
+    EXPECT_EQ(Tracked::live.load(), 0) << "background reclaimer: " << background;
+  }
+}
+
+namespace {
+
+// Sorted list with lock-free readers and mutex-serialized writers, the
+// shape of a read-mostly lookup table. A removed node is flagged before it
+// is unlinked so that a hazard-pointer reader standing on it knows its
+// next pointer may lead to freed nodes and restarts.
+template <typename Domain>
+class ReadMostlyList {
+  struct Node {
+    int key;
+    std::atomic<Node *> next;
+    std::atomic<bool> removed{false};
+  };
+
+public:
+  explicit ReadMostlyList(Domain &domain) : domain(domain) {}
+
+  ~ReadMostlyList() {
+    for (Node *n = head.load(); n != nullptr;) {
+      Node *next = n->next.load();
+      delete n;
+      n = next;
+    }
+  }
+
+  bool insert(int key) {
+    std::lock_guard<std::mutex> lk(write_mutex);
+    auto [link, cur] = find(key);
+    if (cur != nullptr && cur->key == key)
+      return false;
+    link->store(new Node{key, {cur}}, std::memory_order_release);
+    return true;
+  }
+
+  bool remove(int key) {
+    std::lock_guard<std::mutex> lk(write_mutex);
+    auto [link, cur] = find(key);
+    if (cur == nullptr || cur->key != key)
+      return false;
+    cur->removed.store(true, std::memory_order_seq_cst);
+    link->store(cur->next.load(std::memory_order_relaxed), std::memory_order_release);
+    domain.retire(cur);
+    return true;
+  }
+
+  bool contains(int key) {
+    if constexpr (std::is_same_v<Domain, reclamation::EpochDomain>) {
+      reclamation::EpochGuard guard(domain);
+      for (Node *n = head.load(std::memory_order_acquire); n != nullptr;
+           n = n->next.load(std::memory_order_acquire)) {
+        if (n->key >= key)
+          return n->key == key;
+      }
+      return false;
+    } else {
+      reclamation::HazardPointer hp_cur(domain), hp_next(domain);
+    retry:
+      Node *cur = hp_cur.protect(head);
+      while (cur != nullptr) {
+        if (cur->key >= key)
+          return cur->key == key;
+        Node *next = cur->next.load(std::memory_order_acquire);
+        hp_next.reset(next);
+        if (cur->next.load(std::memory_order_acquire) != next ||
+            cur->removed.load(std::memory_order_seq_cst))
+          goto retry;
+        hp_cur.swap(hp_next);
+        cur = next;
+      }
+      return false;
+    }
+  }
+
+private:
+  // Writers only: the link that points at the first node >= key.
+  std::pair<std::atomic<Node *> *, Node *> find(int key) {
+    std::atomic<Node *> *link = &head;
+    Node *cur = link->load(std::memory_order_relaxed);
+    while (cur != nullptr && cur->key < key) {
+      link = &cur->next;
+      cur = link->load(std::memory_order_relaxed);
+    }
+    return {link, cur};
+  }
+
+  Domain &domain;
+  std::atomic<Node *> head{nullptr};
+  std::mutex write_mutex;
+};
+
+struct ListResult {
+  double lookups_per_ms;
+  std::size_t peak_unreclaimed;
+};
+
+template <typename Domain>
+ListResult read_mostly(Domain &domain, int readers, int lookups) {
+  constexpr int keys = 256;
+  ReadMostlyList<Domain> list(domain);
+  for (int k = 0; k < keys; k += 2)
+    list.insert(k);
+
+  std::atomic<bool> done{false};
+  std::size_t peak = 0;
+  std::thread writer([&] {
+    unsigned x = 12345;
+    while (!done.load(std::memory_order_relaxed)) {
+      x = x * 1103515245 + 12345;
+      int k = static_cast<int>((x >> 8) % keys);
+      if (!list.remove(k))
+        list.insert(k);
+      peak = std::max(peak, domain.pending());
+      std::this_thread::yield();
+    }
+  });
+
+  auto sta = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  std::atomic<int> found{0};
+  for (int r = 0; r < readers; ++r) {
+    threads.emplace_back([&, r] {
+      int hits = 0;
+      for (int i = 0; i < lookups; ++i)
+        hits += list.contains((i * 7 + r) % keys);
+      found += hits;
+    });
+  }
+  for (auto &t : threads)
+    t.join();
+  std::chrono::duration<double, std::milli> dur = std::chrono::steady_clock::now() - sta;
+  done = true;
+  writer.join();
+  EXPECT_GT(found.load(), 0);
+  return {readers * lookups / dur.count(), peak};
+}
+
+} // namespace
+
+TEST(epoch_test, benchmark) {
+  constexpr int readers = 3;
+  constexpr int lookups = 20'000;
+
+  reclamation::HazardDomain hazards;
+  reclamation::EpochDomain epochs;
+  auto hp = read_mostly(hazards, readers, lookups);
+  auto ebr = read_mostly(epochs, readers, lookups);
+
+  reclamation::EpochDomain background;
+  background.start_reclaimer();
+  auto bg = read_mostly(background, readers, lookups);
+
+  std::cout << readers << " readers + 1 writer on a 128-node list:" << std::endl;
+  std::cout << "  hazard pointers: " << hp.lookups_per_ms << " lookups/ms, peak "
+            << hp.peak_unreclaimed << " unreclaimed nodes." << std::endl;
+  std::cout << "  epochs: " << ebr.lookups_per_ms << " lookups/ms, peak "
+            << ebr.peak_unreclaimed << " unreclaimed nodes." << std::endl;
+  std::cout << "  epochs, background reclaimer: " << bg.lookups_per_ms
+            << " lookups/ms, peak " << bg.peak_unreclaimed << " unreclaimed nodes on the writer."
+            << std::endl;
+}
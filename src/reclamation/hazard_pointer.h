@@ -0,0 +1,264 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "reclamation/retire_list.h"
+
+namespace reclamation {
+
+// Hazard pointers: safe memory reclamation for lock-free containers.
+//
+// A reader that is about to dereference a shared node publishes the node's
+// address in a hazard pointer first. A writer that has unlinked a node
+// retires it instead of deleting it; the node is only reclaimed by a later
+// scan that finds no hazard pointer holding it.
+//
+//   reclamation::HazardPointer hp;              // from HazardDomain::global()
+//   Node *old = hp.protect(head);               // safe to dereference now
+//   ...
+//   if (head.compare_exchange_strong(old, old->next)) {
+//     hp.reset();
+//     reclamation::HazardDomain::global().retire(old);
+//   }
+//
+// Each thread keeps its own retire list per domain and scans it once it
+// holds max(scan_threshold, 2 * hazard records) nodes, so the cost of a
+// scan (reading every record) is amortized over that many retires and at
+// most about half the list survives it. The records themselves are
+// per-thread: a HazardPointer takes one from its thread's cache, and only
+// the first use on a thread touches the domain's shared record list.
+//
+// Retire lists of threads that exit are adopted by the next scan on
+// another thread. Whatever is still retired when the domain is destroyed
+// is reclaimed then.
+
+namespace detail {
+
+struct HazardRecord {
+  std::atomic<const void *> hazard{nullptr};
+  std::atomic<bool> active{false};
+  HazardRecord *next = nullptr;
+};
+
+struct HazardShared {
+  explicit HazardShared(std::size_t threshold) : scan_threshold(threshold) {}
+
+  ~HazardShared() {
+    reclaim_all(orphans);
+    for (HazardRecord *r = records.load(); r != nullptr;) {
+      HazardRecord *next = r->next;
+      delete r;
+      r = next;
+    }
+  }
+
+  // An inactive record, or a new one; records are never freed before the
+  // domain, so the list only ever grows at the head.
+  HazardRecord *acquire_record() {
+    for (HazardRecord *r = records.load(std::memory_order_acquire); r != nullptr; r = r->next) {
+      bool expected = false;
+      if (!r->active.load(std::memory_order_relaxed) &&
+          r->active.compare_exchange_strong(expected, true, std::memory_order_acquire))
+        return r;
+    }
+
+    auto *r = new HazardRecord;
+    r->active.store(true, std::memory_order_relaxed);
+    r->next = records.load(std::memory_order_relaxed);
+    while (!records.compare_exchange_weak(r->next, r, std::memory_order_release,
+                                          std::memory_order_relaxed)) {
+    }
+    record_count.fetch_add(1, std::memory_order_relaxed);
+    return r;
+  }
+
+  void release_record(HazardRecord *r) {
+    r->hazard.store(nullptr, std::memory_order_relaxed);
+    r->active.store(false, std::memory_order_release);
+  }
+
+  const std::uint64_t id = next_id.fetch_add(1, std::memory_order_relaxed);
+  const std::size_t scan_threshold;
+  std::atomic<HazardRecord *> records{nullptr};
+  std::atomic<std::size_t> record_count{0};
+
+  std::mutex orphan_mutex;
+  std::vector<Retired> orphans;
+
+  static inline std::atomic<std::uint64_t> next_id{1};
+};
+
+// One thread's state in one domain.
+struct HazardLocal {
+  std::uint64_t id;
+  std::weak_ptr<HazardShared> owner;
+  std::vector<HazardRecord *> free_records;
+  std::vector<Retired> retired;
+
+  // The thread is leaving or the domain is gone: give the records back and
+  // hand the retired nodes to the domain, or reclaim them directly if there
+  // is no domain (and so no reader) any more.
+  void detach() {
+    if (auto shared = owner.lock()) {
+      for (HazardRecord *r : free_records)
+        shared->release_record(r);
+      std::lock_guard<std::mutex> lk(shared->orphan_mutex);
+      shared->orphans.insert(shared->orphans.end(), retired.begin(), retired.end());
+    } else {
+      reclaim_all(retired);
+    }
+    free_records.clear();
+    retired.clear();
+  }
+};
+
+inline HazardLocal &local_state(const std::shared_ptr<HazardShared> &shared) {
+  return thread_state<HazardLocal>(shared);
+}
+
+} // namespace detail
+
+class HazardPointer;
+
+class HazardDomain {
+public:
+  explicit HazardDomain(std::size_t scan_threshold = 64)
+      : shared(std::make_shared<detail::HazardShared>(scan_threshold)) {}
+
+  // No HazardPointer of this domain may be alive any more.
+  ~HazardDomain() {
+    if (auto *local = detail::thread_state_if_alive<detail::HazardLocal>(shared))
+      detail::reclaim_all(local->retired);
+  }
+
+  HazardDomain(const HazardDomain &) = delete;
+  HazardDomain &operator=(const HazardDomain &) = delete;
+
+  static HazardDomain &global() {
+    static HazardDomain domain;
+    return domain;
+  }
+
+  // Deletes p once no hazard pointer holds it. p must already be
+  // unreachable for new readers.
+  template <typename T>
+  void retire(T *p) {
+    retire(static_cast<void *>(p), [](void *q) { delete static_cast<T *>(q); });
+  }
+
+  void retire(void *p, void (*reclaim)(void *)) {
+    auto &local = detail::local_state(shared);
+    local.retired.push_back({p, reclaim});
+    std::size_t threshold = std::max(shared->scan_threshold,
+                                     2 * shared->record_count.load(std::memory_order_relaxed));
+    if (local.retired.size() >= threshold)
+      scan(local);
+  }
+
+  // Reclaims whatever this thread retired that is no longer protected,
+  // along with the lists of threads that have exited.
+  void scan() { scan(detail::local_state(shared)); }
+
+  // Nodes this thread has retired but not reclaimed yet.
+  [[nodiscard]] std::size_t pending() const { return detail::local_state(shared).retired.size(); }
+
+private:
+  friend class HazardPointer;
+
+  void scan(detail::HazardLocal &local) {
+    {
+      std::unique_lock<std::mutex> lk(shared->orphan_mutex, std::try_to_lock);
+      if (lk.owns_lock() && !shared->orphans.empty()) {
+        local.retired.insert(local.retired.end(), shared->orphans.begin(), shared->orphans.end());
+        shared->orphans.clear();
+      }
+    }
+
+    // Pairs with the seq_cst store in protect(): either the reader sees
+    // the node unlinked and retries, or this scan sees its hazard.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    std::vector<const void *> hazards;
+    for (auto *r = shared->records.load(std::memory_order_acquire); r != nullptr; r = r->next)
+      if (const void *h = r->hazard.load(std::memory_order_acquire))
+        hazards.push_back(h);
+    std::sort(hazards.begin(), hazards.end());
+
+    auto keep = std::partition(local.retired.begin(), local.retired.end(),
+                               [&](const detail::Retired &r) {
+                                 return std::binary_search(hazards.begin(), hazards.end(), r.ptr);
+                               });
+    std::vector<detail::Retired> reclaimable(keep, local.retired.end());
+    local.retired.erase(keep, local.retired.end());
+    detail::reclaim_all(reclaimable);
+  }
+
+  std::shared_ptr<detail::HazardShared> shared;
+};
+
+// One hazard pointer slot, held for the lifetime of the object. Cheap to
+// create after the first one on a thread: the record comes from a
+// per-thread cache.
+class HazardPointer {
+public:
+  explicit HazardPointer(HazardDomain &domain = HazardDomain::global())
+      : local(&detail::local_state(domain.shared)) {
+    if (local->free_records.empty()) {
+      record = domain.shared->acquire_record();
+    } else {
+      record = local->free_records.back();
+      local->free_records.pop_back();
+    }
+  }
+
+  ~HazardPointer() {
+    record->hazard.store(nullptr, std::memory_order_release);
+    local->free_records.push_back(record);
+  }
+
+  HazardPointer(const HazardPointer &) = delete;
+  HazardPointer &operator=(const HazardPointer &) = delete;
+
+  // Loads src and protects the value: on return the pointer (if not null)
+  // was still in src after the hazard was published, so it cannot have been
+  // reclaimed.
+  template <typename T>
+  T *protect(const std::atomic<T *> &src) {
+    T *p = src.load(std::memory_order_relaxed);
+    while (!try_protect(p, src)) {
+    }
+    return p;
+  }
+
+  // One attempt: publishes p and checks that src still holds it. On
+  // failure p is updated to the current value of src.
+  template <typename T>
+  bool try_protect(T *&p, const std::atomic<T *> &src) {
+    T *expected = p;
+    record->hazard.store(expected, std::memory_order_seq_cst);
+    p = src.load(std::memory_order_acquire);
+    if (p != expected) {
+      record->hazard.store(nullptr, std::memory_order_release);
+      return false;
+    }
+    return true;
+  }
+
+  // Protects p without validation, e.g. to hand a hazard over from another
+  // HazardPointer that already protects it.
+  void reset(const void *p = nullptr) { record->hazard.store(p, std::memory_order_seq_cst); }
+
+  void swap(HazardPointer &other) noexcept { std::swap(record, other.record); }
+
+private:
+  detail::HazardLocal *local;
+  detail::HazardRecord *record;
+};
+
+} // namespace reclamation
@@ -0,0 +1,232 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <stack>
+#include <thread>
+#include <vector>
+
+#include "reclamation/hazard_pointer.h"
+
+namespace {
+
+// Treiber stack whose pop() uses a hazard pointer to read head->next
+// safely while other threads pop and retire the same node.
+template <typename T>
+class HazardStack {
+  struct Node {
+    T value;
+    Node *next;
+  };
+
+public:
+  explicit HazardStack(reclamation::HazardDomain &domain = reclamation::HazardDomain::global())
+      : domain(domain) {}
+
+  ~HazardStack() {
+    for (Node *n = head.load(); n != nullptr;) {
+      Node *next = n->next;
+      delete n;
+      n = next;
+    }
+  }
+
+  void push(T value) {
+    auto *node = new Node{std::move(value), head.load(std::memory_order_relaxed)};
+    while (!head.compare_exchange_weak(node->next, node, std::memory_order_release,
+                                       std::memory_order_relaxed)) {
+    }
+  }
+
+  std::optional<T> pop() {
+    reclamation::HazardPointer hp(domain);
+    Node *old = hp.protect(head);
+    while (old != nullptr && !head.compare_exchange_strong(old, old->next,
+                                                           std::memory_order_acquire,
+                                                           std::memory_order_relaxed))
+      old = hp.protect(head);
+    hp.reset();
+    if (old == nullptr)
+      return std::nullopt;
+
+    std::optional<T> value(std::move(old->value));
+    domain.retire(old);
+    return value;
+  }
+
+private:
+  reclamation::HazardDomain &domain;
+  std::atomic<Node *> head{nullptr};
+};
+
+// Counts live instances, and poisons itself on destruction so that a
+// use-after-reclaim shows up as a bad value.
+struct Tracked {
+  static inline std::atomic<int> live{0};
+  static constexpr unsigned magic = 0x5eed5eed;
+
+  explicit Tracked(int v) : value(v) { live.fetch_add(1); }
+  Tracked(Tracked &&other) noexcept : value(other.value), check(other.check) { live.fetch_add(1); }
+  ~Tracked() {
+    check = 0;
+    live.fetch_sub(1);
+  }
+
+  int value;
+  unsigned check = magic;
+};
+
+} // namespace
+
+TEST(hazard_pointer_test, protect_test) {
+  reclamation::HazardDomain domain(1);
+  std::atomic<Tracked *> shared{new Tracked(1)};
+
+  {
+    reclamation::HazardPointer hp(domain);
+    Tracked *p = hp.protect(shared);
+    ASSERT_EQ(p->value, 1);
+
+    // Unlinked and retired while protected: must survive the scan.
+    shared.store(new Tracked(2));
+    domain.retire(p);
+    domain.scan();
+    EXPECT_EQ(domain.pending(), 1u);
+    EXPECT_EQ(p->check, Tracked::magic);
+  }
+
+  // The hazard pointer is gone, so the next scan reclaims it.
+  domain.scan();
+  EXPECT_EQ(domain.pending(), 0u);
+  EXPECT_EQ(Tracked::live.load(), 1);
+  delete shared.load();
+}
+
+TEST(hazard_pointer_test, stress_test) {
+  constexpr int threads = 4;
+  constexpr int ops = 20'000;
+  {
+    reclamation::HazardDomain domain(16);
+    HazardStack<Tracked> stack(domain);
+    std::atomic<long long> popped_sum{0};
+    std::atomic<bool> corrupted{false};
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+      workers.emplace_back([&, t] {
+        long long sum = 0;
+        for (int i = 0; i < ops; ++i) {
+          stack.push(Tracked(t * ops + i));
+          if (auto v = stack.pop()) {
+            if (v->check != Tracked::magic)
+              corrupted = true;
+            sum += v->value;
+          }
+        }
+        popped_sum += sum;
+      });
+    }
+    for (auto &w : workers)
+      w.join();
+
+    long long rest = 0;
+    while (auto v = stack.pop())
+      rest += v->value;
+    long long n = threads * ops;
+    EXPECT_FALSE(corrupted.load());
+    EXPECT_EQ(popped_sum.load() + rest, n * (n - 1) / 2);
+  }
+  // Retire lists of exited threads were reclaimed with the domain.
+  EXPECT_EQ(Tracked::live.load(), 0);
+}
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+template <typename F>
+double ns_per_op(int ops, F f) {
+  auto sta = Clock::now();
+  for (int i = 0; i < ops; ++i)
+    f(i);
+  std::chrono::duration<double, std::nano> dur = Clock::now() - sta;
+  return dur.count() / ops;
+}
+
+template <typename Stack>
+double stack_ms(Stack &stack, int threads, int ops) {
+  auto sta = Clock::now();
+  std::vector<std::thread> workers;
+  for (int t = 0; t < threads; ++t) {
+    workers.emplace_back([&stack, ops] {
+      for (int i = 0; i < ops; ++i) {
+        stack.push(i);
+        stack.pop();
+      }
+    });
+  }
+  for (auto &w : workers)
+    w.join();
+  std::chrono::duration<double, std::milli> dur = Clock::now() - sta;
+  return dur.count();
+}
+
+class MutexStack {
+public:
+  void push(int v) {
+    std::lock_guard<std::mutex> lk(m);
+    data.push(v);
+  }
+
+  std::optional<int> pop() {
+    std::lock_guard<std::mutex> lk(m);
+    if (data.empty())
+      return std::nullopt;
+    int v = data.top();
+    data.pop();
+    return v;
+  }
+
+private:
+  std::mutex m;
+  std::stack<int> data;
+};
+
+} // namespace
+
+TEST(hazard_pointer_test, benchmark) {
+  constexpr int ops = 1'000'000;
+  reclamation::HazardDomain domain;
+
+  std::atomic<int *> target{new int(42)};
+  long long sink = 0;
+  double load_ns = ns_per_op(ops, [&](int) { sink += *target.load(std::memory_order_acquire); });
+  reclamation::HazardPointer hp(domain);
+  double protect_ns = ns_per_op(ops, [&](int) { sink += *hp.protect(target); });
+  hp.reset();
+  double scoped_ns = ns_per_op(ops, [&](int) {
+    reclamation::HazardPointer scoped(domain);
+    sink += *scoped.protect(target);
+  });
+  delete target.load();
+
+  double delete_ns = ns_per_op(ops, [](int i) { delete new int(i); });
+  double retire_ns = ns_per_op(ops, [&](int i) { domain.retire(new int(i)); });
+  domain.scan();
+  EXPECT_GT(sink, 0);
+
+  std::cout << "acquire load " << load_ns << " ns, protect " << protect_ns
+            << " ns, HazardPointer + protect " << scoped_ns << " ns." << std::endl;
+  std::cout << "new + delete " << delete_ns << " ns, new + retire " << retire_ns
+            << " ns (scans amortized)." << std::endl;
+
+  constexpr int threads = 4;
+  constexpr int stack_ops = 200'000;
+  MutexStack locked;
+  HazardStack<int> lock_free(domain);
+  std::cout << threads << " threads x " << stack_ops << " push/pop: mutex stack "
+            << stack_ms(locked, threads, stack_ops) << " ms, hazard-pointer stack "
+            << stack_ms(lock_free, threads, stack_ops) << " ms." << std::endl;
+}
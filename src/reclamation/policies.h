@@ -0,0 +1,73 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+#include "reclamation/epoch.h"
+#include "reclamation/hazard_pointer.h"
+
+namespace reclamation {
+
+// Reclamation policies for containers that take the scheme as a template
+// parameter. Both provide
+//
+//   Policy::Domain                 HazardDomain or EpochDomain
+//   Policy::default_domain()       the process-wide domain
+//   Policy::Guard<N> g(domain)     N protection slots for one operation
+//   g.protect(i, src)              load src, safe to dereference while g lives
+//   g.reset(i)                     drop slot i early
+//
+// and the container retires through domain.retire(p), which both domains
+// implement.
+
+struct HazardPointers {
+  using Domain = HazardDomain;
+
+  static Domain &default_domain() { return HazardDomain::global(); }
+
+  template <std::size_t N>
+  class Guard {
+  public:
+    explicit Guard(Domain &domain) : Guard(domain, std::make_index_sequence<N>()) {}
+
+    template <typename T>
+    T *protect(std::size_t i, const std::atomic<T *> &src) {
+      return slots[i].protect(src);
+    }
+
+    void reset(std::size_t i) { slots[i].reset(); }
+
+  private:
+    template <std::size_t... I>
+    Guard(Domain &domain, std::index_sequence<I...>) : slots{make(domain, I)...} {}
+
+    static HazardPointer make(Domain &domain, std::size_t) { return HazardPointer(domain); }
+
+    HazardPointer slots[N];
+  };
+};
+
+struct Epochs {
+  using Domain = EpochDomain;
+
+  static Domain &default_domain() { return EpochDomain::global(); }
+
+  template <std::size_t N>
+  class Guard {
+  public:
+    explicit Guard(Domain &domain) : pin(domain) {}
+
+    template <typename T>
+    T *protect(std::size_t, const std::atomic<T *> &src) {
+      return src.load(std::memory_order_acquire);
+    }
+
+    void reset(std::size_t) {}
+
+  private:
+    EpochGuard pin;
+  };
+};
+
+} // namespace reclamation
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace reclamation::detail {
+
+// Pieces shared by the reclamation domains (hazard_pointer.h, epoch.h).
+
+// A node waiting to be reclaimed, with the function that frees it.
+struct Retired {
+  void *ptr;
+  void (*reclaim)(void *);
+};
+
+inline void reclaim_all(std::vector<Retired> &list) {
+  for (auto &r : list)
+    r.reclaim(r.ptr);
+  list.clear();
+}
+
+// A thread's state in every domain it has used. Local is default
+// constructible, has members `std::uint64_t id` and `std::weak_ptr<Shared>
+// owner`, and has a detach() that hands its leftovers to the domain, or
+// frees them if the domain is gone. Domain ids are never reused, so the
+// entry of a destroyed domain is simply never matched again. Entries are
+// heap-allocated so that guards can keep a pointer to their thread's state
+// while the thread starts using other domains.
+template <typename Local>
+struct ThreadRegistry {
+  std::vector<std::unique_ptr<Local>> locals;
+  Local *last = nullptr;
+
+  // Set once the registry is gone, so that a domain destroyed later in
+  // the thread's (or the program's) shutdown does not touch it.
+  static inline thread_local bool destroyed = false;
+
+  ~ThreadRegistry() {
+    for (auto &local : locals)
+      local->detach();
+    destroyed = true;
+  }
+
+  template <typename Shared>
+  Local &find(const std::shared_ptr<Shared> &shared) {
+    std::uint64_t id = shared->id;
+    if (last != nullptr && last->id == id)
+      return *last;
+    for (auto &local : locals)
+      if (local->id == id)
+        return *(last = local.get());
+
+    last = nullptr;
+    std::erase_if(locals, [](const std::unique_ptr<Local> &local) {
+      if (!local->owner.expired())
+        return false;
+      local->detach();
+      return true;
+    });
+    locals.push_back(make_local(shared));
+    return *(last = locals.back().get());
+  }
+
+  template <typename Shared>
+  static std::unique_ptr<Local> make_local(const std::shared_ptr<Shared> &shared) {
+    auto local = std::make_unique<Local>();
+    local->id = shared->id;
+    local->owner = shared;
+    return local;
+  }
+
+  // After the registry is gone a thread can still use a domain: the main
+  // thread's thread_locals are destroyed before static objects, and a
+  // static ThreadPool drains its queue in its destructor. Such uses get
+  // Locals from a list that only a trivially destructible pointer refers
+  // to, so that nothing of it is torn down under them. They are never
+  // detached; find_late() lets the domain's destructor free what they
+  // retired, and the list itself is left to the process exit.
+  static inline thread_local std::vector<std::unique_ptr<Local>> *late = nullptr;
+
+  static Local *find_late(std::uint64_t id) {
+    if (late != nullptr)
+      for (auto &local : *late)
+        if (local->id == id)
+          return local.get();
+    return nullptr;
+  }
+
+  template <typename Shared>
+  static Local &find_or_add_late(const std::shared_ptr<Shared> &shared) {
+    if (Local *local = find_late(shared->id))
+      return *local;
+    if (late == nullptr)
+      late = new std::vector<std::unique_ptr<Local>>;
+    late->push_back(make_local(shared));
+    return *late->back();
+  }
+};
+
+template <typename Local, typename Shared>
+Local &thread_state(const std::shared_ptr<Shared> &shared) {
+  if (ThreadRegistry<Local>::destroyed)
+    return ThreadRegistry<Local>::find_or_add_late(shared);
+  thread_local ThreadRegistry<Local> registry;
+  return registry.find(shared);
+}
+
+// The calling thread's state, or, once its registry has been destroyed
+// (and its leftovers handed to the domain), the Local it used for the
+// domain since, if any.
+template <typename Local, typename Shared>
+Local *thread_state_if_alive(const std::shared_ptr<Shared> &shared) {
+  if (ThreadRegistry<Local>::destroyed)
+    return ThreadRegistry<Local>::find_late(shared->id);
+  return &thread_state<Local>(shared);
+}
+
+} // namespace reclamation::detail
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstdint>
+#include <random>
+
+namespace rng {
+
+// A fast per-thread random number: Marsaglia's xorshift64, seeded once per
+// thread from std::random_device. Not for anything that needs quality or
+// secrecy; it is for spreading work, e.g. picking a shard or a skip list
+// height, where a std::mt19937 per call site would cost more than the
+// operation it serves.
+//
+//   std::size_t shard = rng::thread_random() % shards;
+inline std::uint64_t thread_random() {
+  thread_local std::uint64_t state = (std::uint64_t{std::random_device{}()} << 32) | 1;
+  state ^= state << 13;
+  state ^= state >> 7;
+  state ^= state << 17;
+  return state;
+}
+
+} // namespace rng
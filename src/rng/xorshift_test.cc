@@ -0,0 +1,25 @@
+#include <gtest/gtest.h>
+#include <array>
+#include <cstdint>
+#include <thread>
+
+#include "rng/xorshift.h"
+
+TEST(xorshift_test, thread_random_test) {
+  // Low bits are spread evenly, as the modulo users rely on.
+  std::array<int, 16> buckets{};
+  for (int i = 0; i < 160'000; ++i)
+    ++buckets[rng::thread_random() % 16];
+  for (int count : buckets) {
+    EXPECT_GT(count, 9'000);
+    EXPECT_LT(count, 11'000);
+  }
+
+  // Every thread has its own state, seeded separately.
+  std::uint64_t here = rng::thread_random();
+  std::uint64_t there = 0;
+  std::thread([&there] { there = rng::thread_random(); }).join();
+  EXPECT_NE(here, 0u);
+  EXPECT_NE(there, 0u);
+  EXPECT_NE(here, there);
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+namespace thread_pool {
+
+// std::function requires a copyable target, but std::packaged_task is
+// move-only. FunctionWrapper is a move-only type-erased `void()` callable so
+// that the pool can queue packaged tasks and hand back their futures.
+class FunctionWrapper {
+  struct ImplBase {
+    virtual void call() = 0;
+    virtual ~ImplBase() = default;
+  };
+
+  template <typename F>
+  struct ImplType : ImplBase {
+    F f;
+    explicit ImplType(F &&f_) : f(std::move(f_)) {}
+    void call() override { f(); }
+  };
+
+  std::unique_ptr<ImplBase> impl;
+
+public:
+  FunctionWrapper() = default;
+
+  template <typename F>
+    requires(!std::is_same_v<std::decay_t<F>, FunctionWrapper>)
+  FunctionWrapper(F &&f)
+    : impl(new ImplType<std::decay_t<F>>(std::decay_t<F>(std::forward<F>(f))))
+  {}
+
+  FunctionWrapper(FunctionWrapper &&other) noexcept = default;
+  FunctionWrapper &operator=(FunctionWrapper &&other) noexcept = default;
+
+  FunctionWrapper(const FunctionWrapper &) = delete;
+  FunctionWrapper &operator=(const FunctionWrapper &) = delete;
+
+  void operator()() { impl->call(); }
+
+  explicit operator bool() const { return static_cast<bool>(impl); }
+};
+
+} // namespace thread_pool
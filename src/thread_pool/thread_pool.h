@@ -0,0 +1,487 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <stop_token>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "lock_free/ms_queue.h"
+#include "thread_pool/function_wrapper.h"
+#include "object_pool/object_pool.h"
+#include "priority/multi_queue.h"
+#include "topology/topology.h"
+
+namespace thread_pool {
+
+// The pointer-returning pops hand out Handles::handle: a shared_ptr by
+// default, or with object_pool::PooledHandles<T> a handle into a pool owned
+// by the queue, which saves an allocation per pop.
+//
+// The blocking pops can be cancelled: with a std::stop_token they give up
+// as soon as stop is requested on its source, e.g. by the std::jthread
+// that waits:
+//   std::jthread consumer([&](std::stop_token st) {
+//     int job;
+//     while (queue.wait_and_pop(job, st))
+//       handle(job);
+//   });
+template <typename T, typename Handles = object_pool::SharedHandles<T>>
+class ThreadSafeQueue {
+private:
+  mutable std::mutex mut;
+  std::queue<T> data_queue;
+  // _any for the stop_token-aware waits.
+  std::condition_variable_any data_cond;
+  Handles handles;
+
+public:
+  using handle = typename Handles::handle;
+
+  void push(T new_value) {
+    std::lock_guard<std::mutex> lk(mut);
+    data_queue.push(std::move(new_value));
+    data_cond.notify_one();
+  }
+
+  void wait_and_pop(T &value) {
+    std::unique_lock<std::mutex> lk(mut);
+    data_cond.wait(lk, [this] { return !data_queue.empty(); });
+    value = std::move(data_queue.front());
+    data_queue.pop();
+  }
+
+  handle wait_and_pop() {
+    std::unique_lock<std::mutex> lk(mut);
+    data_cond.wait(lk, [this] { return !data_queue.empty(); });
+    handle res(handles.make(std::move(data_queue.front())));
+    data_queue.pop();
+    return res;
+  }
+
+  // False if stop was requested before an item came in.
+  bool wait_and_pop(T &value, std::stop_token st) {
+    std::unique_lock<std::mutex> lk(mut);
+    if (!data_cond.wait(lk, st, [this] { return !data_queue.empty(); }))
+      return false;
+    value = std::move(data_queue.front());
+    data_queue.pop();
+    return true;
+  }
+
+  // An empty handle if stop was requested before an item came in.
+  handle wait_and_pop(std::stop_token st) {
+    std::unique_lock<std::mutex> lk(mut);
+    if (!data_cond.wait(lk, st, [this] { return !data_queue.empty(); }))
+      return handle();
+    handle res(handles.make(std::move(data_queue.front())));
+    data_queue.pop();
+    return res;
+  }
+
+  // False on timeout or stop.
+  template <typename Rep, typename Period>
+  bool wait_and_pop_for(T &value, const std::chrono::duration<Rep, Period> &timeout,
+                        std::stop_token st = {}) {
+    std::unique_lock<std::mutex> lk(mut);
+    if (!data_cond.wait_for(lk, st, timeout, [this] { return !data_queue.empty(); }))
+      return false;
+    value = std::move(data_queue.front());
+    data_queue.pop();
+    return true;
+  }
+
+  bool try_pop(T &value) {
+    std::lock_guard<std::mutex> lk(mut);
+    if (data_queue.empty())
+      return false;
+
+    value = std::move(data_queue.front());
+    data_queue.pop();
+    return true;
+  }
+
+  handle try_pop() {
+    std::lock_guard<std::mutex> lk(mut);
+    if (data_queue.empty())
+      return handle();
+
+    handle res(handles.make(std::move(data_queue.front())));
+    data_queue.pop();
+
+    return res;
+  }
+
+  bool empty() const {
+    std::lock_guard<std::mutex> lk(mut);
+    return data_queue.empty();
+  }
+};
+
+class JoinThreads {
+  std::vector<std::thread> &threads;
+
+public:
+  explicit JoinThreads(std::vector<std::thread> &threads_)
+    : threads(threads_)
+  {}
+
+  ~JoinThreads() {
+    for (auto & thread : threads) {
+      if (thread.joinable())
+        thread.join();
+    }
+  }
+};
+
+// How a pool stops; see ThreadPool::shutdown().
+//   drain           run every queued task, and those they queue, then stop.
+//   cancel_pending  let running tasks finish and drop the queued ones;
+//                   their futures throw std::future_error (broken_promise).
+//   abort           cancel_pending, and also request stop on the token
+//                   handed to running tasks, so that those which watch it
+//                   return early.
+enum class Shutdown { drain, cancel_pending, abort };
+
+namespace detail {
+
+// A task either takes no arguments or takes the pool's std::stop_token.
+template <typename F>
+struct task_result {
+  using type = std::invoke_result_t<F &>;
+};
+
+template <typename F>
+  requires std::is_invocable_v<F &, std::stop_token>
+struct task_result<F> {
+  using type = std::invoke_result_t<F &, std::stop_token>;
+};
+
+template <typename F>
+using task_result_t = typename task_result<F>::type;
+
+template <typename F>
+auto bind_stop(F f, std::stop_token st) {
+  if constexpr (std::is_invocable_v<F &, std::stop_token>)
+    return [f = std::move(f), st = std::move(st)]() mutable { return f(st); };
+  else
+    return f;
+}
+
+// Queue policies for WorkerPool: how a task is pushed (with whatever key
+// the pool orders by) and popped.
+
+// Lock-free, so submitting never blocks on a worker that holds the queue.
+class FifoTasks {
+public:
+  explicit FifoTasks(unsigned) {}
+
+  void push(FunctionWrapper task) { queue.push(std::move(task)); }
+  bool try_pop(FunctionWrapper &task) { return queue.try_pop(task); }
+
+private:
+  lock_free::MSQueue<FunctionWrapper, reclamation::Epochs> queue;
+};
+
+class PriorityTasks {
+public:
+  explicit PriorityTasks(unsigned threads) : queue(2 * threads) {}
+
+  void push(std::uint64_t priority, FunctionWrapper task) {
+    queue.push(priority, std::move(task));
+  }
+  bool try_pop(FunctionWrapper &task) { return queue.try_pop(task); }
+
+private:
+  priority::MultiQueue<FunctionWrapper> queue;
+};
+
+// The workers, shutdown and std::stop_token plumbing of a pool, over a
+// queue policy. The pools derive from it and add their submit() flavours.
+//
+// Workers are std::jthreads. The destructor drains the queue, so nothing
+// submitted is lost; shutdown() can stop the pool earlier, in any of the
+// Shutdown modes. A long task can watch for abort by taking a
+// std::stop_token:
+//   pool.execute([](std::stop_token st) {
+//     while (!st.stop_requested())
+//       step();
+//   });
+// Once shutdown() has started, the pool takes no more work from other
+// threads, and once it has finished, none at all: submit() returns a future
+// that throws std::future_error (broken_promise) and execute() returns
+// false. Until then the pool's own tasks can still queue more, so that
+// drain runs chains of continuations to the end. Dropped tasks are
+// destroyed without running; schedule() resumes a coroutine inline when
+// its task is rejected.
+template <typename Tasks>
+class WorkerPool {
+public:
+  WorkerPool(const WorkerPool &) = delete;
+  WorkerPool &operator=(const WorkerPool &) = delete;
+
+  [[nodiscard]] std::size_t size() const { return threads.size(); }
+
+  // Stops the workers and waits for them. Meant for the pool's owner, and
+  // only the first call counts, the destructor's included.
+  void shutdown(Shutdown mode = Shutdown::drain) {
+    if (stopped.exchange(true))
+      return;
+    closing.store(true);
+    if (mode != Shutdown::drain)
+      discard = true;
+    if (mode == Shutdown::abort)
+      task_stop.request_stop();
+    for (auto &t : threads)
+      t.request_stop();
+    for (auto &t : threads)
+      t.join();
+
+    // Left over: tasks queued by the last running ones (drain), or the ones
+    // never started (cancel_pending, abort). Tasks run here may still queue
+    // more; then intake closes, and what was pushed before it did is taken
+    // too.
+    auto take_leftovers = [this, mode] {
+      FunctionWrapper task;
+      while (work_queue.try_pop(task)) {
+        if (mode == Shutdown::drain)
+          task();
+      }
+    };
+    running_on = this;
+    take_leftovers();
+    running_on = nullptr;
+    closed.store(true);
+    while (pushing.load() != 0)
+      std::this_thread::yield();
+    take_leftovers();
+  }
+
+  // Runs one queued task on the calling thread, if there is one. A thread
+  // that waits for pool tasks can call this instead of blocking so that the
+  // tasks it depends on still make progress.
+  void run_pending_task() {
+    FunctionWrapper task;
+    if (work_queue.try_pop(task)) {
+      task();
+    } else {
+      std::this_thread::yield();
+    }
+  }
+
+protected:
+  // Pins worker i to cpus[i], if cpus is not empty.
+  WorkerPool(unsigned thread_count, const std::vector<int> &cpus)
+      : discard(false), work_queue(thread_count)
+  {
+    // If this throws, the workers already started stop and join as the
+    // vector is destroyed.
+    for (unsigned i = 0; i < thread_count; ++i) {
+      int cpu = cpus.empty() ? -1 : cpus[i];
+      threads.emplace_back([this, cpu](std::stop_token st) { worker_thread(st, cpu); });
+    }
+  }
+
+  ~WorkerPool() { shutdown(Shutdown::drain); }
+
+  // `key` is whatever Tasks::push takes before the task.
+  template <typename FunctionType, typename... Key>
+  std::future<task_result_t<FunctionType>> submit_task(FunctionType f, Key... key) {
+    using result_type = task_result_t<FunctionType>;
+
+    std::packaged_task<result_type()> task(bind_stop(std::move(f), task_stop.get_token()));
+    std::future<result_type> res(task.get_future());
+    push(FunctionWrapper(std::move(task)), key...);
+    return res;
+  }
+
+  template <typename FunctionType, typename... Key>
+  bool execute_task(FunctionType f, Key... key) {
+    return push(FunctionWrapper(bind_stop(std::move(f), task_stop.get_token())), key...);
+  }
+
+private:
+  // Drops the task once intake is closed to the calling thread. `pushing`
+  // counts the pushes in flight, so that shutdown() cannot close intake and
+  // take the leftovers between a push's check and the push itself.
+  template <typename... Key>
+  bool push(FunctionWrapper task, Key... key) {
+    pushing.fetch_add(1);
+    bool open = !(running_on == this ? closed : closing).load();
+    if (open)
+      work_queue.push(key..., std::move(task));
+    pushing.fetch_sub(1);
+    return open;
+  }
+
+  // A stop request only ends the loop once the queue is empty, which is
+  // how the workers drain it.
+  void worker_thread(std::stop_token st, int cpu) {
+    if (cpu >= 0)
+      topology::pin_current_thread(cpu);
+    running_on = this;
+    while (!discard.load(std::memory_order_relaxed)) {
+      FunctionWrapper task;
+      if (work_queue.try_pop(task))
+        task();
+      else if (st.stop_requested())
+        return;
+      else
+        std::this_thread::yield();
+    }
+  }
+
+  // Set by cancel_pending and abort: workers stop taking tasks.
+  std::atomic_bool discard;
+  std::atomic_bool stopped{false};
+  // Set when shutdown() starts, for other threads, and when it ends, for
+  // the pool's own tasks: submissions are rejected from then on.
+  std::atomic_bool closing{false};
+  std::atomic_bool closed{false};
+  alignas(64) std::atomic<unsigned> pushing{0};
+  // Handed to tasks that take a std::stop_token; requested by abort.
+  std::stop_source task_stop;
+  Tasks work_queue;
+  std::vector<std::jthread> threads;
+
+  // The pool whose tasks the calling thread runs, if any.
+  static inline thread_local const WorkerPool *running_on = nullptr;
+};
+
+} // namespace detail
+
+// FIFO pool; see detail::WorkerPool for shutdown and cancellation.
+class ThreadPool : public detail::WorkerPool<detail::FifoTasks> {
+public:
+  explicit ThreadPool(unsigned thread_count = std::thread::hardware_concurrency())
+      : ThreadPool(thread_count, topology::Pinning::none)
+  {}
+
+  // Pins worker i to placement(pinning)[i] of `topo`, e.g.
+  //   ThreadPool pool(8, topology::Pinning::one_per_core);
+  //   ThreadPool local(4, topology::Pinning::compact, topology::Topology::system().node(0));
+  ThreadPool(unsigned thread_count, topology::Pinning pinning,
+             const topology::Topology &topo = topology::Topology::system())
+      : WorkerPool(std::max(thread_count, 1u),
+                   topo.placement(pinning, std::max(thread_count, 1u)))
+  {}
+
+  template <typename FunctionType>
+  std::future<detail::task_result_t<FunctionType>> submit(FunctionType f) {
+    return submit_task(std::move(f));
+  }
+
+  // Fire-and-forget variant of submit(): no packaged_task and no future.
+  // This makes the pool usable as an executor for continuations. False if
+  // the pool has been shut down.
+  template <typename FunctionType>
+  [[nodiscard]] bool execute(FunctionType f) {
+    return execute_task(std::move(f));
+  }
+
+  // Awaitable that moves the awaiting coroutine onto one of the pool threads:
+  //   co_await pool.schedule();
+  auto schedule() {
+    struct Awaiter {
+      ThreadPool &pool;
+
+      bool await_ready() const noexcept { return false; }
+      // A pool that has been shut down rejects the task; the coroutine
+      // then carries on inline rather than being lost. Not a bool return:
+      // once the task is queued a worker may resume and finish the
+      // coroutine, and GCC stores that result in the (freed) frame.
+      void await_suspend(std::coroutine_handle<> h) {
+        if (!pool.execute([h] { h.resume(); }))
+          h.resume();
+      }
+      void await_resume() const noexcept {}
+    };
+    return Awaiter{*this};
+  }
+};
+
+// A pool that runs the most urgent queued task first instead of the
+// oldest. Tasks are ordered by a key, lower first: either a priority
+//   pool.submit(0, urgent);  pool.submit(10, batch_job);
+// or, for earliest-deadline-first scheduling, a deadline
+//   pool.submit_by(std::chrono::steady_clock::now() + 5ms, request);
+// Both map onto the same key space, so use one or the other per pool.
+//
+// The queue is a relaxed priority::MultiQueue: a task may overtake one of
+// slightly higher priority, but never waits behind a flood of lower ones.
+// Shutdown and std::stop_token tasks work as in ThreadPool; drain runs the
+// queue out in priority order.
+class PriorityThreadPool : public detail::WorkerPool<detail::PriorityTasks> {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  explicit PriorityThreadPool(unsigned thread_count = std::thread::hardware_concurrency())
+      : WorkerPool(std::max(thread_count, 1u), {})
+  {}
+
+  template <typename FunctionType>
+  std::future<detail::task_result_t<FunctionType>> submit(std::uint64_t priority,
+                                                          FunctionType f) {
+    return submit_task(std::move(f), priority);
+  }
+
+  template <typename FunctionType>
+  std::future<detail::task_result_t<FunctionType>> submit_by(Clock::time_point deadline,
+                                                             FunctionType f) {
+    return submit(key(deadline), std::move(f));
+  }
+
+  template <typename FunctionType>
+  [[nodiscard]] bool execute(std::uint64_t priority, FunctionType f) {
+    return execute_task(std::move(f), priority);
+  }
+
+private:
+  static std::uint64_t key(Clock::time_point deadline) {
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline.time_since_epoch());
+    return static_cast<std::uint64_t>(std::max<std::chrono::nanoseconds::rep>(ns.count(), 0));
+  }
+};
+
+// Waits for every future while letting the calling thread run queued pool
+// tasks, so a caller that itself runs on the pool cannot deadlock it.
+template <typename Pool, typename T>
+void wait_all(Pool &pool, std::vector<std::future<T>> &futures) {
+  for (auto &fut : futures) {
+    while (fut.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+      pool.run_pending_task();
+  }
+}
+
+// Process-wide pool, created on first use. Prefer it over
+// std::async(std::launch::async, ...), which starts a fresh OS thread for
+// every call in libstdc++.
+inline ThreadPool &global_pool() {
+  static ThreadPool pool;
+  return pool;
+}
+
+// std::async-like entry point: runs f(args...) on `pool` and returns a future
+// for the result. The arguments are decay-copied into the task, as std::async
+// does; use std::ref to pass references.
+template <typename F, typename... Args>
+std::future<std::invoke_result_t<std::decay_t<F>, std::decay_t<Args>...>>
+async_on(ThreadPool &pool, F &&f, Args &&...args) {
+  return pool.submit(
+      [f = std::forward<F>(f), ... args = std::forward<Args>(args)]() mutable {
+        return std::invoke(std::move(f), std::move(args)...);
+      });
+}
+
+} // namespace thread_pool
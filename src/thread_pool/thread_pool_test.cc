@@ -1,128 +1,395 @@
 #include <gtest/gtest.h>
+#include <algorithm>
 #include <atomic>
-#include <condition_variable>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <future>
+#include <iostream>
 #include <memory>
-#include <mutex>
-#include <queue>
+#include <numeric>
+#include <stop_token>
+#include <string>
 #include <thread>
 #include <vector>
 
+#include "thread_pool/thread_pool.h"
+
+TEST(thread_pool_test, submit_test) {
+  thread_pool::ThreadPool pool;
+
+  std::vector<std::future<int>> futures;
+  for (int i = 0; i < 100; ++i)
+    futures.push_back(pool.submit([i] { return i * i; }));
+
+  int sum = 0;
+  for (auto &fut : futures)
+    sum += fut.get();
+
+  EXPECT_EQ(sum, 328350);
+}
+
+TEST(thread_pool_test, exception_test) {
+  thread_pool::ThreadPool pool(2);
+
+  auto fut = pool.submit([]() -> int { throw std::runtime_error("boom"); });
+
+  EXPECT_THROW(fut.get(), std::runtime_error);
+}
+
+TEST(thread_pool_test, async_on_test) {
+  thread_pool::ThreadPool pool(2);
+
+  auto add = [](int a, int b) { return a + b; };
+  EXPECT_EQ(thread_pool::async_on(pool, add, 20, 11).get(), 31);
+
+  // Arguments are copied unless wrapped in std::ref, as with std::async.
+  int value = 1;
+  thread_pool::async_on(pool, [](int &v) { v = 42; }, std::ref(value)).get();
+  EXPECT_EQ(value, 42);
+
+  auto moved = std::make_unique<int>(7);
+  auto fut = thread_pool::async_on(
+      thread_pool::global_pool(), [](std::unique_ptr<int> p) { return *p; },
+      std::move(moved));
+  EXPECT_EQ(fut.get(), 7);
+}
+
 namespace {
 
-template <typename T>
-class ThreadSafeQueue {
-private:
-  mutable std::mutex mut;
-  std::queue<T> data_queue;
-  std::condition_variable data_cond;
-
-public:
-  void push(T new_value) {
-    std::lock_guard<std::mutex> lk(mut);
-    data_queue.push(new_value);
-    data_cond.notify_one();
-  }
+long long work(long long iterations) {
+  long long sum = 0;
+  for (long long i = 0; i < iterations; ++i)
+    sum += i % 7;
+  return sum;
+}
 
-  void wait_and_pop(T &value) {
-    std::unique_lock<std::mutex> lk(mut);
-    data_cond.wait(lk, [this] { return !data_queue.empty(); });
-    value = data_queue.front();
-    data_queue.pop();
-  }
+// Average submit-to-result time of one task.
+template <typename Launch>
+double per_task_latency(Launch launch, long long iterations, int tasks) {
+  auto sta = std::chrono::steady_clock::now();
+  long long total = 0;
+  for (int i = 0; i < tasks; ++i)
+    total += launch(iterations).get();
+  std::chrono::duration<double, std::micro> dur = std::chrono::steady_clock::now() - sta;
 
-  std::shared_ptr<T> wait_and_pop() {
-    std::unique_lock<std::mutex> lk(mut);
-    data_cond.wait(lk, [this] { return !data_queue.empty(); });
-    std::shared_ptr<T> res(
-        std::make_shared<T>(std::move(data_queue.front())));
-    data_queue.pop();
-    return res;
-  }
+  EXPECT_EQ(total, work(iterations) * tasks);
+  return dur.count() / tasks;
+}
 
-  bool try_pop(T &value) {
-    std::lock_guard<std::mutex> lk(mut);
-    if (data_queue.empty())
-      return false;
+} // namespace
 
-    value = std::move(data_queue.front());
-    data_queue.pop();
-    return true;
-  }
+TEST(thread_pool_test, async_on_benchmark) {
+  auto &pool = thread_pool::global_pool();
 
-  std::shared_ptr<T> try_pop() {
-    std::lock_guard<std::mutex> lk(mut);
-    if (data_queue.empty())
-      return std::shared_ptr<T>();
+  struct Size {
+    const char *name;
+    long long iterations;
+    int tasks;
+  };
 
-    std::shared_ptr<T> res(
-        std::make_shared<T>(std::move(data_queue.front())));
-    data_queue.pop();
+  for (auto const &size : {Size{"tiny", 1, 2000}, Size{"medium", 10000, 1000},
+                           Size{"large", 1000000, 20}}) {
+    double async_us = per_task_latency(
+        [](long long n) { return std::async(std::launch::async, work, n); },
+        size.iterations, size.tasks);
+    double pool_us = per_task_latency(
+        [&](long long n) { return thread_pool::async_on(pool, work, n); },
+        size.iterations, size.tasks);
 
-    return res;
+    std::cout << size.name << " task: std::async " << async_us
+              << " us, async_on " << pool_us << " us per task." << std::endl;
   }
+}
 
-  bool empty() const {
-    std::lock_guard<std::mutex> lk(mut);
-    return data_queue.empty();
-  }
-};
+TEST(thread_pool_test, shutdown_test) {
+  using namespace std::chrono_literals;
 
-class JoinThreads {
-  std::vector<std::thread> &threads;
+  // The destructor drains: every queued task runs.
+  std::atomic<int> ran{0};
+  {
+    thread_pool::ThreadPool pool(2);
+    for (int i = 0; i < 1000; ++i)
+      EXPECT_TRUE(pool.execute([&ran] { ++ran; }));
+    // So do the tasks that tasks queue while the pool drains.
+    EXPECT_TRUE(pool.execute([&ran, &pool] { EXPECT_TRUE(pool.execute([&ran] { ++ran; })); }));
+  }
+  EXPECT_EQ(ran.load(), 1001);
 
-public:
-  explicit JoinThreads(std::vector<std::thread> &threads_)
-    : threads(threads_)
-  {}
+  // One worker, held up by a task, with more queued behind it.
+  auto held_pool = [](thread_pool::ThreadPool &pool, std::shared_future<void> opened,
+                      std::vector<std::future<void>> &queued) {
+    std::atomic<bool> started{false};
+    EXPECT_TRUE(pool.execute([&started, opened] {
+      started = true;
+      opened.wait();
+    }));
+    while (!started)
+      std::this_thread::yield();
+    for (int i = 0; i < 10; ++i)
+      queued.push_back(pool.submit([] {}));
+  };
 
-  ~JoinThreads() {
-    for (auto & thread : threads) {
-      if (thread.joinable())
-        thread.join();
-    }
+  // cancel_pending lets the running task finish and drops the rest.
+  {
+    thread_pool::ThreadPool pool(1);
+    std::promise<void> gate;
+    std::vector<std::future<void>> queued;
+    held_pool(pool, gate.get_future().share(), queued);
+    std::jthread opener([&gate] {
+      std::this_thread::sleep_for(10ms);
+      gate.set_value();
+    });
+    pool.shutdown(thread_pool::Shutdown::cancel_pending);
+    for (auto &fut : queued)
+      EXPECT_THROW(fut.get(), std::future_error);
   }
-};
 
-class ThreadPool {
-  std::atomic_bool done;
-  ThreadSafeQueue<std::function<void()>> work_queue;
-  std::vector<std::thread> threads;
-  JoinThreads joiner;
-
-  void worker_thread() {
-    while (!done) {
-      std::function<void()> task;
-      if (work_queue.try_pop(task)) {
-        task();
-      } else {
+  // abort also stops a running task that watches its stop_token.
+  {
+    thread_pool::ThreadPool pool(1);
+    std::atomic<bool> started{false};
+    auto spinner = pool.submit([&started](std::stop_token st) {
+      started = true;
+      int spins = 0;
+      while (!st.stop_requested()) {
+        ++spins;
         std::this_thread::yield();
       }
+      return spins;
+    });
+    while (!started)
+      std::this_thread::yield();
+    auto queued = pool.submit([] { return 0; });
+    pool.shutdown(thread_pool::Shutdown::abort);
+    EXPECT_GE(spinner.get(), 0);
+    EXPECT_THROW(queued.get(), std::future_error);
+    // Later calls, the destructor's included, do nothing.
+    pool.shutdown(thread_pool::Shutdown::drain);
+
+    // A stopped pool takes no more work.
+    EXPECT_FALSE(pool.execute([] {}));
+    EXPECT_THROW(pool.submit([] { return 1; }).get(), std::future_error);
+  }
+  {
+    thread_pool::PriorityThreadPool pool(1);
+    pool.shutdown();
+    EXPECT_FALSE(pool.execute(0, [] {}));
+    EXPECT_THROW(pool.submit(0, [] { return 1; }).get(), std::future_error);
+  }
+
+  // Submitters racing shutdown(): every task accepted runs.
+  {
+    std::atomic<int> accepted{0};
+    std::atomic<int> executed{0};
+    thread_pool::ThreadPool pool(2);
+    std::vector<std::jthread> submitters;
+    for (int t = 0; t < 2; ++t) {
+      submitters.emplace_back([&] {
+        while (pool.execute([&executed] { ++executed; }))
+          ++accepted;
+      });
     }
+    std::this_thread::sleep_for(10ms);
+    pool.shutdown();
+    for (auto &t : submitters)
+      t.join();
+    EXPECT_GT(accepted.load(), 0);
+    EXPECT_EQ(executed.load(), accepted.load());
   }
+}
+
+TEST(thread_pool_test, global_pool_exit_test) {
+  // The global pool drains during static destruction, after the main
+  // thread's reclamation state is gone. Run in a fresh process ("threadsafe"
+  // re-executes the test binary), since the pool has to be first used there.
+  struct StyleGuard {
+    std::string old = GTEST_FLAG_GET(death_test_style);
+    ~StyleGuard() { GTEST_FLAG_SET(death_test_style, old); }
+  } guard;
+  GTEST_FLAG_SET(death_test_style, "threadsafe");
+  EXPECT_EXIT(
+      {
+        int v = thread_pool::async_on(thread_pool::global_pool(), [] { return 7; }).get();
+        bool queued = thread_pool::global_pool().execute([] {});
+        std::exit(v == 7 && queued ? 0 : 1);
+      },
+      ::testing::ExitedWithCode(0), "");
+}
 
-public:
-  ThreadPool()
-      : done(false), joiner(threads)
+TEST(thread_pool_test, queue_stop_test) {
+  using namespace std::chrono_literals;
+  thread_pool::ThreadSafeQueue<int> queue;
+  int sum = 0;
   {
-    unsigned const thread_count = std::thread::hardware_concurrency();
+    std::jthread consumer([&queue, &sum](std::stop_token st) {
+      int value;
+      while (queue.wait_and_pop(value, st))
+        sum += value;
+    });
+    for (int i = 1; i <= 100; ++i)
+      queue.push(i);
+    while (!queue.empty())
+      std::this_thread::yield();
+    // ~jthread requests stop, which wakes the blocked consumer, and joins.
+  }
+  EXPECT_EQ(sum, 5050);
 
-    try {
-      for (unsigned i = 0; i < thread_count; ++i) {
-        threads.emplace_back(&ThreadPool::worker_thread, this);
-      }
-    }
-    catch (...) {
-      done = true;
-      throw;
+  std::stop_source source;
+  source.request_stop();
+  EXPECT_FALSE(queue.wait_and_pop(source.get_token()));
+
+  int value = 0;
+  EXPECT_FALSE(queue.wait_and_pop_for(value, 10ms));
+  queue.push(7);
+  EXPECT_TRUE(queue.wait_and_pop_for(value, 10ms));
+  EXPECT_EQ(value, 7);
+}
+
+TEST(thread_pool_test, shutdown_benchmark) {
+  constexpr int tasks = 1'000'000;
+  constexpr unsigned workers = 4;
+  const std::pair<const char *, thread_pool::Shutdown> modes[] = {
+      {"drain", thread_pool::Shutdown::drain},
+      {"cancel_pending", thread_pool::Shutdown::cancel_pending},
+      {"abort", thread_pool::Shutdown::abort}};
+
+  std::cout << "shutdown with " << tasks << " queued tasks:" << std::endl;
+  for (auto [name, mode] : modes) {
+    std::atomic<int> ran{0};
+    std::atomic<bool> open{false};
+    thread_pool::ThreadPool pool(workers);
+    // Hold the workers so that the whole backlog is still queued.
+    for (unsigned i = 0; i < workers; ++i)
+      EXPECT_TRUE(pool.execute([&open] {
+        while (!open)
+          std::this_thread::yield();
+      }));
+    for (int i = 0; i < tasks; ++i)
+      EXPECT_TRUE(pool.execute([&ran] { ran.fetch_add(1, std::memory_order_relaxed); }));
+
+    auto sta = std::chrono::steady_clock::now();
+    open = true;
+    pool.shutdown(mode);
+    std::chrono::duration<double, std::milli> dur = std::chrono::steady_clock::now() - sta;
+    std::cout << "  " << name << ": " << dur.count() << " ms, ran " << ran.load() << " tasks"
+              << std::endl;
+    if (mode == thread_pool::Shutdown::drain) {
+      EXPECT_EQ(ran.load(), tasks);
     }
   }
+}
 
-  ~ThreadPool() { done = true; }
+TEST(thread_pool_test, priority_test) {
+  // One worker, held up until everything is queued.
+  thread_pool::PriorityThreadPool pool(1);
+  std::promise<void> gate;
+  std::shared_future<void> opened = gate.get_future().share();
+  std::atomic<bool> started{false};
+  auto blocker = pool.submit(0, [&started, opened] {
+    started = true;
+    opened.wait();
+  });
+  while (!started)
+    std::this_thread::yield();
 
-  template <typename FunctionType>
-  void submit(FunctionType f) {
-    work_queue.push(std::function<void()>(f));
-  }
+  std::vector<int> order;
+  std::vector<std::future<void>> futures;
+  for (int priority : {10, 5, 1, 7})
+    futures.push_back(pool.submit(priority, [&order, priority] { order.push_back(priority); }));
+  gate.set_value();
+  // get(), not wait_all(): only the worker may run the tasks, or `order`
+  // would be appended to from two threads, and out of order.
+  for (auto &fut : futures)
+    fut.get();
+  EXPECT_EQ(order, (std::vector<int>{1, 5, 7, 10}));
+
+  // Earliest deadline first.
+  auto now = std::chrono::steady_clock::now();
+  order.clear();
+  futures.clear();
+  std::promise<void> gate2;
+  opened = gate2.get_future().share();
+  started = false;
+  blocker = pool.submit(0, [&started, opened] {
+    started = true;
+    opened.wait();
+  });
+  while (!started)
+    std::this_thread::yield();
+  for (int ms : {30, 10, 20})
+    futures.push_back(pool.submit_by(now + std::chrono::milliseconds(ms),
+                                     [&order, ms] { order.push_back(ms); }));
+  gate2.set_value();
+  for (auto &fut : futures)
+    fut.get();
+  EXPECT_EQ(order, (std::vector<int>{10, 20, 30}));
+}
+
+namespace {
+
+struct FloodResult {
+  double tasks_per_sec;
+  double p50_us;
+  double p99_us;
+  double max_us;
 };
 
-}
\ No newline at end of file
+// Queues `flood` low-priority tasks, then submits `urgent` high-priority
+// ones at intervals and measures how long each waits before it starts.
+template <typename SubmitLow, typename SubmitHigh>
+FloodResult flood_latency(SubmitLow submit_low, SubmitHigh submit_high, int flood, int urgent) {
+  using Clock = std::chrono::steady_clock;
+  std::atomic<int> finished{0};
+  std::vector<double> waits(urgent);
+
+  auto sta = Clock::now();
+  for (int i = 0; i < flood; ++i)
+    submit_low([&finished] {
+      work(2000);
+      finished.fetch_add(1);
+    });
+  for (int i = 0; i < urgent; ++i) {
+    auto submitted = Clock::now();
+    submit_high([&finished, &waits, i, submitted] {
+      std::chrono::duration<double, std::micro> wait = Clock::now() - submitted;
+      waits[i] = wait.count();
+      finished.fetch_add(1);
+    });
+    std::this_thread::sleep_for(std::chrono::microseconds(200));
+  }
+  while (finished.load() < flood + urgent)
+    std::this_thread::yield();
+  std::chrono::duration<double> dur = Clock::now() - sta;
+
+  std::sort(waits.begin(), waits.end());
+  return {(flood + urgent) / dur.count(), waits[urgent / 2], waits[urgent * 99 / 100],
+          waits.back()};
+}
+
+} // namespace
+
+TEST(thread_pool_test, priority_benchmark) {
+  constexpr unsigned workers = 4;
+  constexpr int flood = 20'000;
+  constexpr int urgent = 100;
+
+  auto report = [](const char *name, const FloodResult &r) {
+    std::cout << name << ": " << r.tasks_per_sec / 1e6 << " M tasks/s; urgent task wait p50 "
+              << r.p50_us << " us, p99 " << r.p99_us << " us, max " << r.max_us << " us"
+              << std::endl;
+  };
+
+  {
+    thread_pool::ThreadPool pool(workers);
+    report("FIFO pool", flood_latency([&pool](auto f) { (void)pool.execute(std::move(f)); },
+                                      [&pool](auto f) { (void)pool.execute(std::move(f)); }, flood,
+                                      urgent));
+  }
+  {
+    thread_pool::PriorityThreadPool pool(workers);
+    report("priority pool", flood_latency([&pool](auto f) { (void)pool.execute(100, std::move(f)); },
+                                          [&pool](auto f) { (void)pool.execute(0, std::move(f)); },
+                                          flood, urgent));
+  }
+}
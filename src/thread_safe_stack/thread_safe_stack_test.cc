@@ -2,22 +2,32 @@
 #include <exception>
 #include <memory>
 #include <mutex>
+#include <set>
 #include <stack>
+#include <string>
 #include <thread>
+#include <vector>
+
+#include "object_pool/object_pool.h"
 
 namespace {
 struct empty_stack : std::exception
 {
-  [[nodiscard]] const char* what() const throw();
+  [[nodiscard]] const char* what() const throw() { return "empty stack"; }
 };
 
-template <typename T>
+// Handles as in thread_pool::ThreadSafeQueue: shared_ptr by default,
+// object_pool::PooledHandles<T> to pop into pooled storage.
+template <typename T, typename Handles = object_pool::SharedHandles<T>>
 class ThreadSafeStack {
 private:
   std::stack<T> data;
   mutable std::mutex m;
+  Handles handles;
 
 public:
+  using handle = typename Handles::handle;
+
   ThreadSafeStack() = default;
 
   ThreadSafeStack(const ThreadSafeStack &other) {
@@ -32,10 +42,10 @@ public:
     data.push(new_value);
   }
 
-  std::shared_ptr<T> pop() {
+  handle pop() {
     std::lock_guard<std::mutex> lock(m);
     if (data.empty()) throw empty_stack();
-    std::shared_ptr<T> const res(std::make_shared<T>(data.pop()));
+    handle res(handles.make(std::move(data.top())));
     data.pop();
     return res;
   }
@@ -167,4 +177,25 @@ TEST(hierarchical_mutex_test_11, test1) {
   thread_fine.join();
   thread_wild.join();
 #endif
-}
\ No newline at end of file
+}
+
+TEST(thread_safe_stack_test, pooled_pop_test) {
+  ThreadSafeStack<std::string, object_pool::PooledHandles<std::string>> stack;
+  std::vector<std::thread> producers;
+  for (int t = 0; t < 4; ++t) {
+    producers.emplace_back([&stack, t] {
+      for (int i = 0; i < 1000; ++i)
+        stack.push("value " + std::to_string(t * 1000 + i));
+    });
+  }
+  for (auto &t : producers)
+    t.join();
+
+  std::set<std::string> seen;
+  while (!stack.empty()) {
+    auto value = stack.pop();
+    seen.insert(*value);
+  }
+  EXPECT_EQ(seen.size(), 4000u);
+  EXPECT_THROW(stack.pop(), empty_stack);
+}
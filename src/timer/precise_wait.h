@@ -0,0 +1,126 @@
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <sys/prctl.h>
+#include <time.h>
+#endif
+
+namespace timer {
+
+// Precise short waits without burning a core for their whole length.
+//
+//   timer::precise_sleep_for(std::chrono::microseconds(250));
+//
+// A wait has three phases:
+//   sleep   clock_nanosleep to an absolute time `sleep_margin` before the
+//           deadline; the kernel wakes us late by up to the timer slack
+//           plus scheduling latency, which the margin absorbs.
+//   yield   std::this_thread::yield() until `spin_window` is left.
+//   spin    a pause loop for the last few microseconds.
+// The margins are measured once per process, on first use, from real
+// sleeps and yields on this host (calibrate()). Waits never end early.
+
+using WaitClock = std::chrono::steady_clock;
+
+struct WaitCalibration {
+  WaitClock::duration sleep_margin;
+  WaitClock::duration spin_window;
+};
+
+// Tells the CPU we are spinning: frees pipeline resources for the sibling
+// hyperthread and saves power.
+inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__)
+  asm volatile("yield");
+#endif
+}
+
+namespace detail {
+
+// steady_clock is CLOCK_MONOTONIC on Linux, so its time points can be
+// passed to clock_nanosleep as absolute deadlines.
+inline void sleep_until(WaitClock::time_point deadline) {
+#if defined(__linux__)
+  auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline.time_since_epoch());
+  timespec ts{};
+  ts.tv_sec = static_cast<time_t>(ns.count() / 1'000'000'000);
+  ts.tv_nsec = static_cast<long>(ns.count() % 1'000'000'000);
+  while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {
+  }
+#else
+  std::this_thread::sleep_until(deadline);
+#endif
+}
+
+// The kernel's timer slack for this thread: how late it may batch a wakeup.
+inline WaitClock::duration timer_slack() {
+#if defined(__linux__)
+  int slack = prctl(PR_GET_TIMERSLACK, 0, 0, 0, 0);
+  if (slack > 0)
+    return std::chrono::nanoseconds(slack);
+#endif
+  return std::chrono::microseconds(50);
+}
+
+inline WaitClock::duration percentile(std::vector<WaitClock::duration> &samples, int p) {
+  std::sort(samples.begin(), samples.end());
+  return samples[samples.size() * p / 100];
+}
+
+} // namespace detail
+
+// Measures how late short sleeps wake up and how long a yield takes. The
+// sleep margin is the 90th percentile oversleep (at least the timer
+// slack); the spin window is twice the 99th percentile yield.
+inline WaitCalibration calibrate(int samples = 20) {
+  std::vector<WaitClock::duration> late;
+  for (int i = 0; i < samples; ++i) {
+    auto target = WaitClock::now() + std::chrono::microseconds(200);
+    detail::sleep_until(target);
+    late.push_back(WaitClock::now() - target);
+  }
+
+  std::vector<WaitClock::duration> yields;
+  for (int i = 0; i < 50 * samples; ++i) {
+    auto sta = WaitClock::now();
+    std::this_thread::yield();
+    yields.push_back(WaitClock::now() - sta);
+  }
+
+  return {std::max(detail::percentile(late, 90), detail::timer_slack()),
+          std::max(2 * detail::percentile(yields, 99),
+                   WaitClock::duration(std::chrono::microseconds(2)))};
+}
+
+inline const WaitCalibration &calibration() {
+  static const WaitCalibration c = calibrate();
+  return c;
+}
+
+inline void precise_sleep_until(WaitClock::time_point deadline,
+                                const WaitCalibration &cal = calibration()) {
+  if (WaitClock::now() < deadline - cal.sleep_margin)
+    detail::sleep_until(deadline - cal.sleep_margin);
+  while (deadline - WaitClock::now() > cal.spin_window)
+    std::this_thread::yield();
+  while (WaitClock::now() < deadline)
+    cpu_relax();
+}
+
+template <typename Rep, typename Period>
+void precise_sleep_for(std::chrono::duration<Rep, Period> duration,
+                       const WaitCalibration &cal = calibration()) {
+  precise_sleep_until(WaitClock::now() + std::chrono::duration_cast<WaitClock::duration>(duration),
+                      cal);
+}
+
+} // namespace timer
@@ -0,0 +1,89 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "timer/precise_wait.h"
+
+TEST(precise_wait_test, calibration_test) {
+  const auto &cal = timer::calibration();
+  std::cout << "sleep margin "
+            << std::chrono::duration_cast<std::chrono::microseconds>(cal.sleep_margin).count()
+            << " us, spin window "
+            << std::chrono::duration_cast<std::chrono::microseconds>(cal.spin_window).count()
+            << " us" << std::endl;
+  EXPECT_GT(cal.sleep_margin.count(), 0);
+  EXPECT_GE(cal.spin_window, std::chrono::microseconds(2));
+}
+
+TEST(precise_wait_test, never_early_test) {
+  using namespace std::chrono_literals;
+  for (auto wait : {0us, 1us, 10us, 100us, 1000us, 5000us}) {
+    for (int i = 0; i < 5; ++i) {
+      auto sta = timer::WaitClock::now();
+      timer::precise_sleep_for(wait);
+      EXPECT_GE(timer::WaitClock::now() - sta, wait);
+    }
+  }
+
+  // A deadline in the past returns at once.
+  auto sta = timer::WaitClock::now();
+  timer::precise_sleep_until(sta - 1s);
+  EXPECT_LT(timer::WaitClock::now() - sta, 1ms);
+}
+
+namespace {
+
+// Baseline: the yield loop of little_sleep() in misc/this_thread_yield_test.cc.
+void yield_sleep(std::chrono::microseconds us) {
+  auto end = std::chrono::steady_clock::now() + us;
+  do {
+    std::this_thread::yield();
+  } while (std::chrono::steady_clock::now() < end);
+}
+
+double thread_cpu_us() {
+  timespec ts{};
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+// Lateness percentiles and mean CPU time of `samples` waits of `wait`.
+void measure(const std::string &name, const std::function<void(std::chrono::microseconds)> &sleep,
+             std::chrono::microseconds wait, int samples) {
+  std::vector<double> late_us;
+  double cpu = 0;
+  for (int i = 0; i < samples; ++i) {
+    double cpu_sta = thread_cpu_us();
+    auto sta = std::chrono::steady_clock::now();
+    sleep(wait);
+    std::chrono::duration<double, std::micro> late = std::chrono::steady_clock::now() - sta - wait;
+    cpu += thread_cpu_us() - cpu_sta;
+    late_us.push_back(late.count());
+  }
+  std::sort(late_us.begin(), late_us.end());
+  std::cout << "  " << name << ": late p50 " << late_us[samples / 2] << " us, p99 "
+            << late_us[samples * 99 / 100] << " us; cpu " << cpu / samples << " us/wait ("
+            << 100 * cpu / samples / static_cast<double>(wait.count()) << "%)" << std::endl;
+}
+
+} // namespace
+
+TEST(precise_wait_test, benchmark) {
+  constexpr int samples = 200;
+  auto std_sleep = [](std::chrono::microseconds us) { std::this_thread::sleep_for(us); };
+  auto precise = [](std::chrono::microseconds us) { timer::precise_sleep_for(us); };
+
+  for (int us : {50, 200, 1000, 5000}) {
+    std::chrono::microseconds wait(us);
+    std::cout << us << " us waits:" << std::endl;
+    measure("yield loop  ", yield_sleep, wait, samples);
+    measure("sleep_for   ", std_sleep, wait, samples);
+    measure("precise wait", precise, wait, samples);
+  }
+}
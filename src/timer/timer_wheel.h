@@ -0,0 +1,319 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "thread_pool/thread_pool.h"
+
+namespace timer {
+
+// Names a scheduled timer for cancel(). Stays valid across the firings of a
+// periodic timer; once a timer has fired for the last time or has been
+// cancelled, its id is stale and cancel() returns false.
+struct TimerId {
+  std::uint32_t index = std::numeric_limits<std::uint32_t>::max();
+  std::uint32_t generation = 0;
+
+  explicit operator bool() const { return index != std::numeric_limits<std::uint32_t>::max(); }
+};
+
+// Hashed hierarchical timing wheel (Varghese & Lauck), counted in ticks.
+//
+// Four levels of 256 slots. Level 0 holds timers due within 256 ticks, one
+// slot per tick; level k holds those due within 256^(k+1) ticks, one slot
+// per 256^k. Every time the tick count crosses a multiple of 256^k, the
+// current level-k slot is redistributed to the levels below, so a timer is
+// moved at most three times before it fires. Scheduling and cancelling
+// unlink or link one node: O(1), whatever the number of pending timers.
+// Delays are capped at 2^32 - 1 ticks (about 49 days at 1 ms).
+//
+// Nodes live in one vector and are linked by index, so that growing it
+// never invalidates a slot list, and freed nodes are reused. Not
+// thread-safe; TimerService adds the locking and the clock.
+class TimerWheel {
+public:
+  using Callback = std::function<void()>;
+
+  static constexpr int levels = 4;
+  static constexpr int slot_bits = 8;
+  static constexpr std::uint64_t slots = std::uint64_t{1} << slot_bits;
+  static constexpr std::uint64_t max_delay = (std::uint64_t{1} << (levels * slot_bits)) - 1;
+
+  TimerWheel() { std::fill(std::begin(heads), std::end(heads), nil); }
+
+  // Fires `fn` at tick `at` (the next tick if `at` has passed), and then
+  // every `period` ticks if `period` is not zero.
+  TimerId schedule_at(std::uint64_t at, std::uint64_t period, Callback fn) {
+    std::uint32_t i = allocate();
+    Node &n = nodes[i];
+    n.fn = std::move(fn);
+    n.expiry = std::clamp(at, current + 1, current + max_delay);
+    n.period = std::min(period, max_delay);
+    n.active = true;
+    place(i);
+    ++count;
+    return TimerId{i, n.generation};
+  }
+
+  bool cancel(TimerId id) {
+    if (id.index >= nodes.size())
+      return false;
+    Node &n = nodes[id.index];
+    if (!n.active || n.generation != id.generation)
+      return false;
+    unlink(id.index);
+    release(id.index);
+    --count;
+    return true;
+  }
+
+  // Moves the wheel on to tick `to`, calling fire(callback) for every timer
+  // that comes due, in tick order. fire gets a copy of a periodic timer's
+  // callback and the callback itself of a one-shot one. It must not call
+  // back into the wheel.
+  template <typename Fire>
+  void advance_to(std::uint64_t to, Fire &&fire) {
+    while (current < to) {
+      if (count == 0) {
+        current = to;
+        return;
+      }
+      ++current;
+
+      // Redistribute from the highest level whose slot boundary we crossed
+      // downwards, so that timers land in slots that are still ahead.
+      int top = 1;
+      while (top < levels && (current & ((std::uint64_t{1} << (slot_bits * top)) - 1)) == 0)
+        ++top;
+      for (int level = top - 1; level >= 1; --level)
+        cascade(level);
+
+      std::uint32_t i = take(0, current & (slots - 1));
+      while (i != nil) {
+        std::uint32_t next = nodes[i].next;
+        Node &n = nodes[i];
+        if (n.period != 0) {
+          fire(Callback(n.fn));
+          n.expiry += n.period;
+          place(i);
+        } else {
+          fire(std::move(n.fn));
+          release(i);
+          --count;
+        }
+        i = next;
+      }
+    }
+  }
+
+  [[nodiscard]] std::uint64_t now() const { return current; }
+
+  // Pending timers, periodic ones included.
+  [[nodiscard]] std::size_t size() const { return count; }
+
+private:
+  static constexpr std::uint32_t nil = std::numeric_limits<std::uint32_t>::max();
+
+  struct Node {
+    Callback fn;
+    std::uint64_t expiry = 0;
+    std::uint64_t period = 0;
+    std::uint32_t prev = nil;
+    std::uint32_t next = nil;
+    std::uint32_t slot = nil;
+    std::uint32_t generation = 0;
+    bool active = false;
+  };
+
+  std::uint32_t allocate() {
+    if (free_head != nil) {
+      std::uint32_t i = free_head;
+      free_head = nodes[i].next;
+      return i;
+    }
+    nodes.emplace_back();
+    return static_cast<std::uint32_t>(nodes.size() - 1);
+  }
+
+  void release(std::uint32_t i) {
+    Node &n = nodes[i];
+    n.fn = nullptr;
+    n.active = false;
+    ++n.generation;
+    n.next = free_head;
+    free_head = i;
+  }
+
+  // Links node i into the slot its expiry falls in, relative to now.
+  void place(std::uint32_t i) {
+    Node &n = nodes[i];
+    std::uint64_t delta = n.expiry - std::min(n.expiry, current);
+    int level = 0;
+    while (level + 1 < levels && delta >= (std::uint64_t{1} << (slot_bits * (level + 1))))
+      ++level;
+    std::uint32_t slot = static_cast<std::uint32_t>(
+        level * slots + ((n.expiry >> (slot_bits * level)) & (slots - 1)));
+
+    n.slot = slot;
+    n.prev = nil;
+    n.next = heads[slot];
+    if (n.next != nil)
+      nodes[n.next].prev = i;
+    heads[slot] = i;
+  }
+
+  void unlink(std::uint32_t i) {
+    Node &n = nodes[i];
+    if (n.prev != nil)
+      nodes[n.prev].next = n.next;
+    else
+      heads[n.slot] = n.next;
+    if (n.next != nil)
+      nodes[n.next].prev = n.prev;
+  }
+
+  // Detaches a slot's whole list and returns its first node.
+  std::uint32_t take(int level, std::uint64_t index) {
+    std::uint32_t &head = heads[level * slots + index];
+    std::uint32_t first = head;
+    head = nil;
+    return first;
+  }
+
+  void cascade(int level) {
+    std::uint32_t i = take(level, (current >> (slot_bits * level)) & (slots - 1));
+    while (i != nil) {
+      std::uint32_t next = nodes[i].next;
+      place(i);
+      i = next;
+    }
+  }
+
+  std::vector<Node> nodes;
+  std::uint32_t free_head = nil;
+  std::uint32_t heads[levels * slots];
+  std::uint64_t current = 0;
+  std::size_t count = 0;
+};
+
+// Runs callbacks on a ThreadPool after a delay or periodically.
+//
+//   timer::TimerService timers(pool);
+//   auto id = timers.schedule_after(50ms, [] { ... });
+//   timers.schedule_every(1s, [] { flush(); });
+//   timers.cancel(id);
+//
+// One thread drives a TimerWheel at `tick` resolution and hands due
+// callbacks to the pool, so a slow callback never delays other timers.
+// Timers never fire early; they fire up to a tick plus the pool's queueing
+// delay late. The thread sleeps while no timer is pending. Callbacks still
+// pending when the service is destroyed are dropped; the pool must outlive
+// the service.
+class TimerService {
+public:
+  using Clock = std::chrono::steady_clock;
+  using Callback = TimerWheel::Callback;
+
+  explicit TimerService(thread_pool::ThreadPool &pool,
+                        Clock::duration tick = std::chrono::milliseconds(1))
+      : pool(pool), tick(std::max(tick, Clock::duration(1))), start(Clock::now()),
+        thread(&TimerService::run, this) {}
+
+  ~TimerService() {
+    {
+      std::lock_guard<std::mutex> lk(mutex);
+      stopping = true;
+    }
+    cond.notify_one();
+    thread.join();
+  }
+
+  TimerService(const TimerService &) = delete;
+  TimerService &operator=(const TimerService &) = delete;
+
+  TimerId schedule_after(Clock::duration delay, Callback fn) {
+    return schedule(Clock::now() + delay, 0, std::move(fn));
+  }
+
+  // First fires one period from now.
+  TimerId schedule_every(Clock::duration period, Callback fn) {
+    std::uint64_t ticks = std::max<std::uint64_t>((period + tick / 2) / tick, 1);
+    return schedule(Clock::now() + period, ticks, std::move(fn));
+  }
+
+  bool cancel(TimerId id) {
+    std::lock_guard<std::mutex> lk(mutex);
+    return wheel.cancel(id);
+  }
+
+  [[nodiscard]] std::size_t pending() const {
+    std::lock_guard<std::mutex> lk(mutex);
+    return wheel.size();
+  }
+
+private:
+  TimerId schedule(Clock::time_point when, std::uint64_t period, Callback fn) {
+    // Round up, so that the timer's tick does not start before `when`.
+    auto since_start = std::max(when - start, Clock::duration(0));
+    std::uint64_t at = static_cast<std::uint64_t>((since_start + tick - Clock::duration(1)) / tick);
+    bool was_idle;
+    TimerId id;
+    {
+      std::lock_guard<std::mutex> lk(mutex);
+      was_idle = wheel.size() == 0;
+      // An idle wheel is not advanced; bring it up to the clock first,
+      // which is free while it is empty.
+      if (was_idle)
+        wheel.advance_to(static_cast<std::uint64_t>((Clock::now() - start) / tick),
+                         [](Callback) {});
+      id = wheel.schedule_at(at, period, std::move(fn));
+    }
+    if (was_idle)
+      cond.notify_one();
+    return id;
+  }
+
+  void run() {
+    std::vector<Callback> due;
+    std::unique_lock<std::mutex> lk(mutex);
+    while (!stopping) {
+      if (wheel.size() == 0) {
+        cond.wait(lk, [this] { return stopping || wheel.size() > 0; });
+        continue;
+      }
+      // Sleep until the next tick boundary, then catch up to the clock.
+      if (cond.wait_until(lk, start + tick * (wheel.now() + 1), [this] { return stopping; }))
+        break;
+      auto elapsed = static_cast<std::uint64_t>((Clock::now() - start) / tick);
+      wheel.advance_to(elapsed, [&due](Callback fn) { due.push_back(std::move(fn)); });
+
+      lk.unlock();
+      for (auto &fn : due)
+        // Dropped if the pool has been shut down under the service.
+        (void)pool.execute(std::move(fn));
+      due.clear();
+      lk.lock();
+    }
+  }
+
+  thread_pool::ThreadPool &pool;
+  const Clock::duration tick;
+  const Clock::time_point start;
+
+  mutable std::mutex mutex;
+  std::condition_variable cond;
+  TimerWheel wheel;
+  bool stopping = false;
+  std::thread thread;
+};
+
+} // namespace timer
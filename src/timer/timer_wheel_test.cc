@@ -0,0 +1,201 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "timer/timer_wheel.h"
+
+TEST(timer_wheel_test, wheel_test) {
+  timer::TimerWheel wheel;
+  std::vector<std::pair<int, std::uint64_t>> fired;
+  auto at = [&](int name) {
+    return [&fired, &wheel, name] { fired.emplace_back(name, wheel.now()); };
+  };
+
+  // One timer per level, plus two due on the same tick.
+  wheel.schedule_at(5, 0, at(1));
+  wheel.schedule_at(300, 0, at(2));
+  wheel.schedule_at(70'000, 0, at(3));
+  wheel.schedule_at((1 << 24) + 3, 0, at(4));
+  wheel.schedule_at(300, 0, at(5));
+  EXPECT_EQ(wheel.size(), 5);
+
+  auto run = [](auto f) { f(); };
+  wheel.advance_to(299, run);
+  EXPECT_EQ(fired, (std::vector<std::pair<int, std::uint64_t>>{{1, 5}}));
+  wheel.advance_to((1 << 24) + 10, run);
+  std::sort(fired.begin() + 1, fired.begin() + 3);
+  EXPECT_EQ(fired, (std::vector<std::pair<int, std::uint64_t>>{
+                       {1, 5}, {2, 300}, {5, 300}, {3, 70'000}, {4, (1 << 24) + 3}}));
+  EXPECT_EQ(wheel.size(), 0);
+
+  // A time in the past fires on the next tick.
+  fired.clear();
+  wheel.schedule_at(0, 0, at(6));
+  wheel.advance_to(wheel.now() + 1, run);
+  EXPECT_EQ(fired.size(), 1);
+}
+
+TEST(timer_wheel_test, cancel_test) {
+  timer::TimerWheel wheel;
+  int fired = 0;
+  auto count = [&fired] { ++fired; };
+  auto run = [](auto f) { f(); };
+
+  auto a = wheel.schedule_at(10, 0, count);
+  auto b = wheel.schedule_at(1000, 0, count);
+  auto c = wheel.schedule_at(10, 0, count);
+  EXPECT_TRUE(wheel.cancel(a));
+  EXPECT_FALSE(wheel.cancel(a));
+  EXPECT_TRUE(wheel.cancel(b));
+  EXPECT_EQ(wheel.size(), 1);
+
+  wheel.advance_to(2000, run);
+  EXPECT_EQ(fired, 1);
+  // Fired: stale. The node is reused, but the old id does not match it.
+  EXPECT_FALSE(wheel.cancel(c));
+  auto d = wheel.schedule_at(3000, 0, count);
+  EXPECT_FALSE(wheel.cancel(c));
+  EXPECT_FALSE(wheel.cancel(timer::TimerId{}));
+  EXPECT_TRUE(wheel.cancel(d));
+}
+
+TEST(timer_wheel_test, periodic_test) {
+  timer::TimerWheel wheel;
+  std::vector<std::uint64_t> ticks;
+  auto id = wheel.schedule_at(10, 10, [&] { ticks.push_back(wheel.now()); });
+  auto run = [](auto f) { f(); };
+
+  wheel.advance_to(100, run);
+  EXPECT_EQ(ticks.size(), 10);
+  EXPECT_EQ(ticks.back(), 100);
+
+  // Periods longer than level 0 go through the upper levels.
+  auto slow = wheel.schedule_at(1000, 1000, [&] { ticks.push_back(wheel.now()); });
+  EXPECT_TRUE(wheel.cancel(id));
+  ticks.clear();
+  wheel.advance_to(5000, run);
+  EXPECT_EQ(ticks, (std::vector<std::uint64_t>{1000, 2000, 3000, 4000, 5000}));
+  EXPECT_TRUE(wheel.cancel(slow));
+  EXPECT_EQ(wheel.size(), 0);
+}
+
+TEST(timer_wheel_test, service_test) {
+  using namespace std::chrono_literals;
+  thread_pool::ThreadPool pool(2);
+  timer::TimerService timers(pool);
+
+  auto sta = std::chrono::steady_clock::now();
+  std::promise<std::chrono::steady_clock::time_point> fired;
+  timers.schedule_after(20ms, [&fired] { fired.set_value(std::chrono::steady_clock::now()); });
+
+  std::atomic<int> cancelled_runs{0};
+  auto cancelled = timers.schedule_after(10ms, [&cancelled_runs] { ++cancelled_runs; });
+  EXPECT_TRUE(timers.cancel(cancelled));
+
+  std::atomic<int> beats{0};
+  std::promise<void> fifth;
+  auto heartbeat = timers.schedule_every(2ms, [&beats, &fifth] {
+    if (++beats == 5)
+      fifth.set_value();
+  });
+  fifth.get_future().wait();
+  EXPECT_TRUE(timers.cancel(heartbeat));
+  EXPECT_FALSE(timers.cancel(heartbeat));
+
+  // Never early.
+  EXPECT_GE(fired.get_future().get() - sta, 20ms);
+  std::this_thread::sleep_for(5ms);
+  EXPECT_EQ(cancelled_runs.load(), 0);
+  EXPECT_EQ(timers.pending(), 0);
+}
+
+TEST(timer_wheel_test, benchmark) {
+  using Clock = std::chrono::steady_clock;
+  constexpr int timers = 1'000'000;
+
+  // Raw wheel: a million pending timers spread over a minute of 1 ms ticks.
+  {
+    timer::TimerWheel wheel;
+    std::mt19937 rng(1);
+    std::vector<timer::TimerId> ids(timers);
+    std::uint64_t fired = 0;
+
+    auto sta = Clock::now();
+    for (int i = 0; i < timers; ++i)
+      ids[i] = wheel.schedule_at(1 + rng() % 60'000, 0, [&fired] { ++fired; });
+    std::chrono::duration<double> insert = Clock::now() - sta;
+
+    sta = Clock::now();
+    for (int i = 0; i < timers; i += 2)
+      wheel.cancel(ids[i]);
+    std::chrono::duration<double> cancel = Clock::now() - sta;
+
+    sta = Clock::now();
+    wheel.advance_to(60'000, [](auto f) { f(); });
+    std::chrono::duration<double> fire = Clock::now() - sta;
+    EXPECT_EQ(fired, timers / 2);
+
+    std::cout << "wheel (M timers/s): insert " << timers / insert.count() / 1e6 << ", cancel "
+              << timers / 2 / cancel.count() / 1e6 << ", fire " << timers / 2 / fire.count() / 1e6
+              << std::endl;
+  }
+
+  // Service: how late timers fire, compared with a thread that sleeps.
+  {
+    constexpr int samples = 200;
+    thread_pool::ThreadPool pool(2);
+    timer::TimerService service(pool);
+    std::mutex mutex;
+    std::vector<double> late_us;
+    std::atomic<int> done{0};
+    std::mt19937 rng(2);
+
+    for (int i = 0; i < samples; ++i) {
+      auto delay = std::chrono::microseconds(5'000 + rng() % 45'000);
+      auto due = Clock::now() + delay;
+      service.schedule_after(delay, [&, due] {
+        std::chrono::duration<double, std::micro> late = Clock::now() - due;
+        std::lock_guard<std::mutex> lk(mutex);
+        late_us.push_back(late.count());
+        ++done;
+      });
+    }
+    while (done.load() < samples)
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    std::sort(late_us.begin(), late_us.end());
+    std::cout << "service firing delay, 1 ms ticks: p50 " << late_us[samples / 2] << " us, p99 "
+              << late_us[samples * 99 / 100] << " us, max " << late_us.back() << " us"
+              << std::endl;
+    EXPECT_GE(late_us.front(), 0.0);
+
+    // The same delays, each on its own thread that sleeps.
+    late_us.clear();
+    std::vector<std::thread> sleepers;
+    for (int i = 0; i < samples; ++i) {
+      auto delay = std::chrono::microseconds(5'000 + rng() % 45'000);
+      auto due = Clock::now() + delay;
+      sleepers.emplace_back([&, delay, due] {
+        std::this_thread::sleep_for(delay);
+        std::chrono::duration<double, std::micro> late = Clock::now() - due;
+        std::lock_guard<std::mutex> lk(mutex);
+        late_us.push_back(late.count());
+      });
+    }
+    for (auto &t : sleepers)
+      t.join();
+
+    std::sort(late_us.begin(), late_us.end());
+    std::cout << "thread per timer, sleep_for: p50 " << late_us[samples / 2] << " us, p99 "
+              << late_us[samples * 99 / 100] << " us, max " << late_us.back() << " us"
+              << std::endl;
+  }
+}
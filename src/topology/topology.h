@@ -0,0 +1,285 @@
+#pragma once
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace topology {
+
+// CPU topology as Linux exposes it under /sys/devices/system:
+//
+//   cpu/online                          "0-15"
+//   cpu/cpuN/topology/core_id           core within the package
+//   cpu/cpuN/topology/physical_package_id
+//   cpu/cpuN/topology/thread_siblings_list   SMT siblings, "0,8"
+//   cpu/cpuN/cache/indexK/{level,type,size,shared_cpu_list}
+//   cpu/cpuN/nodeM                      link to the NUMA node
+//
+// Missing files (containers, non-x86 kernels) degrade to one package, one
+// node and no SMT rather than failing.
+
+// Parses a kernel cpu list such as "0-3,8,10-11".
+inline std::vector<int> parse_cpu_list(const std::string &list) {
+  std::vector<int> cpus;
+  std::stringstream in(list);
+  std::string range;
+  while (std::getline(in, range, ',')) {
+    if (range.empty() || range == "\n")
+      continue;
+    auto dash = range.find('-');
+    int first = std::stoi(range.substr(0, dash));
+    int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+    for (int cpu = first; cpu <= last; ++cpu)
+      cpus.push_back(cpu);
+  }
+  return cpus;
+}
+
+// CPUs this thread may run on.
+inline std::vector<int> current_affinity() {
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  std::vector<int> cpus;
+  if (sched_getaffinity(0, sizeof(set), &set) != 0)
+    return cpus;
+  for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+    if (CPU_ISSET(cpu, &set))
+      cpus.push_back(cpu);
+  return cpus;
+}
+
+inline bool pin_current_thread(int cpu) {
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
+
+struct Cpu {
+  int id;
+  int core;     // core_id, unique only within a package
+  int package;
+  int node;
+  std::vector<int> siblings;   // SMT siblings, including this cpu
+};
+
+struct Cache {
+  int level;
+  std::string type;            // "Data", "Instruction" or "Unified"
+  std::size_t size;            // bytes
+  std::vector<int> cpus;       // cpus sharing this cache
+};
+
+// Where a pool puts its workers:
+//   compact       fill a core's SMT siblings, then the next core of the
+//                 same package, then the next package -- threads share caches
+//   scatter       spread over packages first, then over cores, SMT siblings
+//                 last -- threads get as much cache and bandwidth each as
+//                 possible
+//   one_per_core  one thread per physical core, siblings stay idle
+enum class Pinning { none, compact, scatter, one_per_core };
+
+class Topology {
+public:
+  // Online cpus under `root` that are also in `allowed` (all online cpus if
+  // `allowed` is empty).
+  static Topology read(const std::string &root = "/sys/devices/system",
+                       const std::vector<int> &allowed = current_affinity()) {
+    namespace fs = std::filesystem;
+    Topology t;
+
+    std::set<int> permitted(allowed.begin(), allowed.end());
+    std::string online = read_line(root + "/cpu/online");
+    std::vector<int> ids = online.empty() ? allowed : parse_cpu_list(online);
+
+    std::set<std::tuple<int, std::string, std::vector<int>>> seen_caches;
+    for (int id : ids) {
+      if (!permitted.empty() && !permitted.count(id))
+        continue;
+
+      std::string dir = root + "/cpu/cpu" + std::to_string(id);
+      Cpu cpu{id, read_int(dir + "/topology/core_id", id),
+              read_int(dir + "/topology/physical_package_id", 0), 0,
+              parse_cpu_list(read_line(dir + "/topology/thread_siblings_list"))};
+      if (cpu.siblings.empty())
+        cpu.siblings.push_back(id);
+
+      std::error_code ec;
+      for (const auto &entry : fs::directory_iterator(dir, ec)) {
+        auto name = entry.path().filename().string();
+        if (name.rfind("node", 0) == 0 && name.size() > 4 &&
+            std::isdigit(static_cast<unsigned char>(name[4])))
+          cpu.node = std::stoi(name.substr(4));
+      }
+
+      for (const auto &entry : fs::directory_iterator(dir + "/cache", ec)) {
+        if (entry.path().filename().string().rfind("index", 0) != 0)
+          continue;
+        auto path = entry.path().string();
+        Cache cache{read_int(path + "/level", 0), read_line(path + "/type"),
+                    parse_size(read_line(path + "/size")),
+                    parse_cpu_list(read_line(path + "/shared_cpu_list"))};
+        if (seen_caches.emplace(cache.level, cache.type, cache.cpus).second)
+          t.cache_list.push_back(std::move(cache));
+      }
+
+      t.cpu_list.push_back(std::move(cpu));
+    }
+
+    std::sort(t.cache_list.begin(), t.cache_list.end(), [](const Cache &a, const Cache &b) {
+      return std::tie(a.level, a.type, a.cpus) < std::tie(b.level, b.type, b.cpus);
+    });
+    return t;
+  }
+
+  // The machine this process runs on, read once.
+  static const Topology &system() {
+    static const Topology t = read();
+    return t;
+  }
+
+  [[nodiscard]] const std::vector<Cpu> &cpus() const { return cpu_list; }
+  [[nodiscard]] const std::vector<Cache> &caches() const { return cache_list; }
+
+  [[nodiscard]] std::size_t cores() const {
+    return count([](const Cpu &c) { return std::pair(c.package, c.core); });
+  }
+  [[nodiscard]] std::size_t packages() const {
+    return count([](const Cpu &c) { return c.package; });
+  }
+  [[nodiscard]] std::size_t nodes() const {
+    return count([](const Cpu &c) { return c.node; });
+  }
+
+  // The part of the topology on one NUMA node, e.g. to keep a pool there.
+  [[nodiscard]] Topology node(int id) const {
+    Topology t;
+    for (const auto &cpu : cpu_list)
+      if (cpu.node == id)
+        t.cpu_list.push_back(cpu);
+    for (const auto &cache : cache_list)
+      if (std::any_of(cache.cpus.begin(), cache.cpus.end(),
+                      [&](int c) { return t.contains(c); }))
+        t.cache_list.push_back(cache);
+    return t;
+  }
+
+  [[nodiscard]] bool contains(int cpu) const {
+    return std::any_of(cpu_list.begin(), cpu_list.end(),
+                       [cpu](const Cpu &c) { return c.id == cpu; });
+  }
+
+  // Cpu for each of `count` threads under `policy`; wraps around when there
+  // are more threads than cpus. Empty for Pinning::none.
+  [[nodiscard]] std::vector<int> placement(Pinning policy, std::size_t count) const {
+    std::vector<int> order = ordering(policy);
+    std::vector<int> cpus;
+    if (order.empty())
+      return cpus;
+    for (std::size_t i = 0; i < count; ++i)
+      cpus.push_back(order[i % order.size()]);
+    return cpus;
+  }
+
+private:
+  static std::string read_line(const std::string &path) {
+    std::ifstream in(path);
+    std::string line;
+    std::getline(in, line);
+    return line;
+  }
+
+  static int read_int(const std::string &path, int fallback) {
+    std::ifstream in(path);
+    int value;
+    return in >> value ? value : fallback;
+  }
+
+  // "48K", "2048K", "1M".
+  static std::size_t parse_size(const std::string &s) {
+    if (s.empty())
+      return 0;
+    std::size_t value = std::stoul(s);
+    switch (s.back()) {
+    case 'K': return value << 10;
+    case 'M': return value << 20;
+    case 'G': return value << 30;
+    default: return value;
+    }
+  }
+
+  template <typename Key>
+  std::size_t count(Key key) const {
+    std::set<decltype(key(cpu_list.front()))> keys;
+    for (const auto &cpu : cpu_list)
+      keys.insert(key(cpu));
+    return keys.size();
+  }
+
+  std::vector<int> ordering(Pinning policy) const {
+    std::vector<const Cpu *> compact;
+    for (const auto &cpu : cpu_list)
+      compact.push_back(&cpu);
+    std::sort(compact.begin(), compact.end(), [](const Cpu *a, const Cpu *b) {
+      return std::tie(a->package, a->node, a->core, a->id) <
+             std::tie(b->package, b->node, b->core, b->id);
+    });
+
+    // Rank of each cpu among its SMT siblings, and of its core within the
+    // package, both in compact order.
+    std::map<std::pair<int, int>, int> smt_seen;
+    std::map<int, std::set<int>> package_cores;
+    std::map<int, int> smt_rank, core_rank;
+    for (const Cpu *cpu : compact) {
+      smt_rank[cpu->id] = smt_seen[{cpu->package, cpu->core}]++;
+      package_cores[cpu->package].insert(cpu->core);
+    }
+    for (const Cpu *cpu : compact) {
+      const auto &cores = package_cores[cpu->package];
+      core_rank[cpu->id] = static_cast<int>(std::distance(cores.begin(), cores.find(cpu->core)));
+    }
+
+    std::vector<int> order;
+    switch (policy) {
+    case Pinning::none:
+      break;
+    case Pinning::compact:
+      for (const Cpu *cpu : compact)
+        order.push_back(cpu->id);
+      break;
+    case Pinning::one_per_core:
+      for (const Cpu *cpu : compact)
+        if (smt_rank[cpu->id] == 0)
+          order.push_back(cpu->id);
+      break;
+    case Pinning::scatter: {
+      auto scattered = compact;
+      std::stable_sort(scattered.begin(), scattered.end(), [&](const Cpu *a, const Cpu *b) {
+        return std::tuple(smt_rank[a->id], core_rank[a->id], a->package) <
+               std::tuple(smt_rank[b->id], core_rank[b->id], b->package);
+      });
+      for (const Cpu *cpu : scattered)
+        order.push_back(cpu->id);
+      break;
+    }
+    }
+    return order;
+  }
+
+  std::vector<Cpu> cpu_list;
+  std::vector<Cache> cache_list;
+};
+
+} // namespace topology
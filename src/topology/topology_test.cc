@@ -0,0 +1,177 @@
+#include <gtest/gtest.h>
+#include <sched.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <latch>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include "parallel_fill/parallel_fill.h"
+#include "thread_pool/thread_pool.h"
+#include "topology/topology.h"
+
+namespace {
+
+namespace fs = std::filesystem;
+
+void write_file(const fs::path &path, const std::string &content) {
+  fs::create_directories(path.parent_path());
+  std::ofstream(path) << content << '\n';
+}
+
+// A fake /sys/devices/system for two packages x two cores x two SMT
+// threads, numbered the way Linux usually does it: cpu = thread * 4 +
+// package * 2 + core, so siblings are 4 apart. One NUMA node per package.
+fs::path make_fake_sysfs() {
+  fs::path root = fs::temp_directory_path() / ("topology_test_" + std::to_string(::getpid()));
+  fs::remove_all(root);
+  write_file(root / "cpu/online", "0-7");
+
+  for (int id = 0; id < 8; ++id) {
+    int package = (id / 2) % 2, core = id % 2;
+    int first = package * 2 + core;
+    fs::path cpu = root / "cpu" / ("cpu" + std::to_string(id));
+    write_file(cpu / "topology/core_id", std::to_string(core));
+    write_file(cpu / "topology/physical_package_id", std::to_string(package));
+    write_file(cpu / "topology/thread_siblings_list",
+               std::to_string(first) + "," + std::to_string(first + 4));
+    fs::create_directories(cpu / ("node" + std::to_string(package)));
+
+    write_file(cpu / "cache/index0/level", "1");
+    write_file(cpu / "cache/index0/type", "Data");
+    write_file(cpu / "cache/index0/size", "48K");
+    write_file(cpu / "cache/index0/shared_cpu_list",
+               std::to_string(first) + "," + std::to_string(first + 4));
+    write_file(cpu / "cache/index3/level", "3");
+    write_file(cpu / "cache/index3/type", "Unified");
+    write_file(cpu / "cache/index3/size", "32M");
+    write_file(cpu / "cache/index3/shared_cpu_list",
+               package == 0 ? "0-1,4-5" : "2-3,6-7");
+  }
+  return root;
+}
+
+} // namespace
+
+TEST(topology_test, parse_cpu_list_test) {
+  EXPECT_EQ(topology::parse_cpu_list("0-3,8,10-11"),
+            (std::vector<int>{0, 1, 2, 3, 8, 10, 11}));
+  EXPECT_EQ(topology::parse_cpu_list("5"), std::vector<int>{5});
+  EXPECT_TRUE(topology::parse_cpu_list("").empty());
+}
+
+TEST(topology_test, fake_sysfs_test) {
+  fs::path root = make_fake_sysfs();
+  auto topo = topology::Topology::read(root.string(), {});
+  fs::remove_all(root);
+
+  ASSERT_EQ(topo.cpus().size(), 8u);
+  EXPECT_EQ(topo.cores(), 4u);
+  EXPECT_EQ(topo.packages(), 2u);
+  EXPECT_EQ(topo.nodes(), 2u);
+  EXPECT_EQ(topo.cpus()[5].siblings, (std::vector<int>{1, 5}));
+
+  // Four per-core L1d caches and two per-package L3s.
+  ASSERT_EQ(topo.caches().size(), 6u);
+  EXPECT_EQ(topo.caches().front().size, 48u << 10);
+  EXPECT_EQ(topo.caches().back().size, 32u << 20);
+  EXPECT_EQ(topo.caches().back().cpus, (std::vector<int>{2, 3, 6, 7}));
+
+  using topology::Pinning;
+  EXPECT_TRUE(topo.placement(Pinning::none, 4).empty());
+  EXPECT_EQ(topo.placement(Pinning::compact, 8), (std::vector<int>{0, 4, 1, 5, 2, 6, 3, 7}));
+  EXPECT_EQ(topo.placement(Pinning::scatter, 8), (std::vector<int>{0, 2, 1, 3, 4, 6, 5, 7}));
+  EXPECT_EQ(topo.placement(Pinning::one_per_core, 6), (std::vector<int>{0, 1, 2, 3, 0, 1}));
+
+  auto node1 = topo.node(1);
+  EXPECT_EQ(node1.placement(Pinning::compact, 3), (std::vector<int>{2, 6, 3}));
+  EXPECT_EQ(node1.caches().size(), 3u);
+
+  // Only the cpus in the affinity mask.
+  fs::path again = make_fake_sysfs();
+  auto masked = topology::Topology::read(again.string(), {1, 5});
+  fs::remove_all(again);
+  EXPECT_EQ(masked.cpus().size(), 2u);
+  EXPECT_EQ(masked.cores(), 1u);
+}
+
+TEST(topology_test, pinned_pool_test) {
+  const auto &topo = topology::Topology::system();
+  ASSERT_FALSE(topo.cpus().empty());
+  for (const auto &cache : topo.caches())
+    std::cout << "L" << cache.level << " " << cache.type << " " << (cache.size >> 10)
+              << " KiB shared by " << cache.cpus.size() << " cpu(s)" << std::endl;
+  std::cout << topo.cpus().size() << " cpus, " << topo.cores() << " cores, "
+            << topo.packages() << " packages, " << topo.nodes() << " nodes." << std::endl;
+
+  // A single-thread pool pinned compactly must run on the first cpu.
+  thread_pool::ThreadPool pool(1, topology::Pinning::compact);
+  int expected = topo.placement(topology::Pinning::compact, 1).front();
+  EXPECT_EQ(pool.submit([] { return sched_getcpu(); }).get(), expected);
+}
+
+namespace {
+
+long long dot_product(thread_pool::ThreadPool &pool, const std::vector<int> &v,
+                      const std::vector<int> &w) {
+  std::size_t chunks = pool.size();
+  std::size_t step = v.size() / chunks;
+  std::vector<std::future<long long>> parts;
+  for (std::size_t i = 0; i < chunks; ++i) {
+    std::size_t first = i * step, last = i + 1 == chunks ? v.size() : first + step;
+    parts.push_back(pool.submit([&v, &w, first, last] {
+      return std::inner_product(v.begin() + first, v.begin() + last, w.begin() + first, 0LL);
+    }));
+  }
+  long long sum = 0;
+  for (auto &part : parts)
+    sum += part.get();
+  return sum;
+}
+
+double queue_throughput(thread_pool::ThreadPool &pool, int tasks) {
+  std::latch done{tasks};
+  auto sta = std::chrono::steady_clock::now();
+  for (int i = 0; i < tasks; ++i)
+    (void)pool.execute([&done] { done.count_down(); });
+  done.wait();
+  std::chrono::duration<double> dur = std::chrono::steady_clock::now() - sta;
+  return tasks / dur.count();
+}
+
+} // namespace
+
+TEST(topology_test, benchmark) {
+  constexpr std::size_t size = 10'000'000;
+  constexpr int tasks = 200'000;
+
+  std::vector<int> v(size), w(size);
+  {
+    thread_pool::ThreadPool fill_pool;
+    parallel_fill::fill_uniform(fill_pool, v.begin(), v.end(), 0, 100, 1);
+    parallel_fill::fill_uniform(fill_pool, w.begin(), w.end(), 0, 100, 2);
+  }
+  long long expected = std::inner_product(v.begin(), v.end(), w.begin(), 0LL);
+
+  using topology::Pinning;
+  for (auto [name, pinning] : {std::pair{"unpinned", Pinning::none},
+                               {"compact", Pinning::compact},
+                               {"scatter", Pinning::scatter},
+                               {"one_per_core", Pinning::one_per_core}}) {
+    thread_pool::ThreadPool pool(std::thread::hardware_concurrency(), pinning);
+
+    auto sta = std::chrono::steady_clock::now();
+    EXPECT_EQ(dot_product(pool, v, w), expected);
+    std::chrono::duration<double, std::milli> dur = std::chrono::steady_clock::now() - sta;
+
+    std::cout << name << " (" << pool.size() << " threads): dot product " << dur.count()
+              << " ms, queue " << queue_throughput(pool, tasks) / 1e6 << " M tasks/s."
+              << std::endl;
+  }
+}